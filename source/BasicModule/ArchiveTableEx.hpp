@@ -0,0 +1,346 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_ARCHIVE_TABLE_EX_H_
+#define   GUI_WXWIDGETS_MAIN_APP_ARCHIVE_TABLE_EX_H_
+
+/*****************************************************************************
+ *
+ * CLASS   : ArchiveTableEx
+ * PURPOSE : Read-mostly columnar copy of TableEx rows with compressed
+ *           numeric columns
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Rows are appended and never updated. Row IDs and every numeric
+ *           column are stored in an EncodedColumn (delta encoding suits
+ *           ascending IDs, frame-of-reference addresses and small-range
+ *           scores, run-length low-cardinality values); strings are kept
+ *           as they are. Cells must have the type of their ColumnInfo.
+ *           Filters and sorts decode whole blocks and work on the keys,
+ *           cells are only rebuilt as ColumnData for formatting.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class ArchiveTableEx
+{
+public:
+  using ColumnType = typename ColumnInfo<C>::ColumnType;
+  using RowData    = std::array<ColumnData<C>, N>;
+protected:
+  // Column metadata
+  std::array<ColumnInfo<C>, N>             m_arrColumnInfo;
+  // Row IDs in append order
+  EncodedColumn                            m_ids;
+  // Numeric columns as order-preserving keys
+  std::array<EncodedColumn, N>             m_arrColumns;
+  // String columns (UTF-8)
+  std::array<std::vector<std::string>, N>  m_arrStrings;
+  // Number of rows
+  size_t                                   m_nRows = 0;
+public:
+  ArchiveTableEx()
+    : m_ids(ColumnEncoding::DELTA)
+  {
+  }
+  // Get column metadata by index
+  const ColumnInfo<C>& GetColumnInfo(size_t col) const
+  {
+    static ColumnInfo<C> dummyColumn = {};
+    return (col < N) ? m_arrColumnInfo[col] : dummyColumn;
+  }
+  // Set column metadata, the type can only change while the archive is empty
+  void SetColumnInfo(size_t col, const ColumnInfo<C>& info)
+  {
+    if (col < N && (m_nRows == 0 || info.type == m_arrColumnInfo[col].type))
+    {
+      m_arrColumnInfo[col] = info;
+    }
+  }
+  // Force one encoding for a numeric column (AUTO picks per block).
+  // Only possible while the archive is empty.
+  void SetEncoding(size_t col, ColumnEncoding encoding)
+  {
+    if (col < N && m_nRows == 0)
+    {
+      m_arrColumns[col] = EncodedColumn(encoding);
+    }
+  }
+  // Append one row
+  void AppendRow(size_t id, const RowData& row)
+  {
+    m_ids.Append(id);
+    for (size_t col = 0; col < N; ++col)
+    {
+      if (IsStringColumn(col))
+      {
+        m_arrStrings[col].push_back(row[col].str);
+      }
+      else
+      {
+        m_arrColumns[col].Append(ToKey(row[col]));
+      }
+    }
+    ++m_nRows;
+  }
+  // Append the rows of a table in its view order. The column info is taken
+  // from the table when the archive is empty. An unsorted, unfiltered
+  // table gives ascending IDs, which delta-encode to a few bits.
+  void AppendTable(const TableEx<C, N>& table)
+  {
+    if (m_nRows == 0)
+    {
+      for (size_t col = 0; col < N; ++col)
+      {
+        m_arrColumnInfo[col] = table.GetColumnInfo(col);
+      }
+    }
+    for (auto it = table.begin(), last = table.end(); it != last; ++it)
+    {
+      AppendRow(it.Id(), *it);
+    }
+    Seal();
+  }
+  // Encode rows still buffered, call when a batch of appends is done
+  void Seal()
+  {
+    m_ids.Seal();
+    for (EncodedColumn& column : m_arrColumns)
+    {
+      column.Seal();
+    }
+  }
+  // Number of rows
+  size_t GetRowCount() const
+  {
+    return m_nRows;
+  }
+  // ID of the row at a position
+  size_t GetId(size_t pos) const
+  {
+    return static_cast<size_t>(m_ids.Get(pos));
+  }
+  // Rebuild one cell, linked to our column info so it can be formatted
+  ColumnData<C> GetCell(size_t pos, size_t col) const
+  {
+    ColumnData<C> cell = IsStringColumn(col)
+      ? MakeString(col, m_arrStrings[col][pos])
+      : FromKey(m_arrColumnInfo[col].type, m_arrColumns[col].Get(pos));
+    cell.columnInfo = &m_arrColumnInfo[col];
+    return cell;
+  }
+  // Rebuild one row
+  RowData GetRow(size_t pos) const
+  {
+    RowData row;
+    for (size_t col = 0; col < N; ++col)
+    {
+      row[col] = GetCell(pos, col);
+    }
+    return row;
+  }
+  // Positions (ascending) of rows whose column is in [lower, upper],
+  // nullptr leaves that side open
+  std::vector<size_t> FilterRange(size_t               col,
+                                  const ColumnData<C>* lower,
+                                  const ColumnData<C>* upper) const
+  {
+    std::vector<size_t> positions;
+    if (col >= N)
+      return positions;
+
+    if (IsStringColumn(col))
+    {
+      const std::vector<std::string>& strings = m_arrStrings[col];
+      for (size_t pos = 0; pos < strings.size(); ++pos)
+      {
+        if ((!lower || strings[pos].compare(lower->str) >= 0)
+          && (!upper || strings[pos].compare(upper->str) <= 0))
+        {
+          positions.push_back(pos);
+        }
+      }
+      return positions;
+    }
+    m_arrColumns[col].FilterRange(lower ? ToKey(*lower) : 0,
+                                  upper ? ToKey(*upper) : ~0ULL, positions);
+    return positions;
+  }
+  // Order positions by a column, equal values keep ascending position
+  void SortPositions(size_t               col,
+                     bool                 ascending,
+                     std::vector<size_t>& positions) const
+  {
+    if (col >= N)
+      return;
+
+    if (IsStringColumn(col))
+    {
+      const std::vector<std::string>& strings = m_arrStrings[col];
+      std::sort(positions.begin(), positions.end(),
+        [&strings, ascending](size_t a, size_t b)
+      {
+        int result = strings[a].compare(strings[b]);
+        return result != 0 ? (ascending ? result < 0 : result > 0) : a < b;
+      });
+      return;
+    }
+
+    // Decode the column block by block once, then sort on plain keys
+    std::vector<uint64_t> keys(m_nRows);
+    m_arrColumns[col].Decode(0, m_nRows, keys.data());
+    std::sort(positions.begin(), positions.end(),
+      [&keys, ascending](size_t a, size_t b)
+    {
+      if (keys[a] != keys[b])
+        return ascending ? keys[a] < keys[b] : keys[a] > keys[b];
+      return a < b;
+    });
+  }
+  // Copy every row back into a table for editing
+  void ExtractTo(TableEx<C, N>& table) const
+  {
+    for (size_t col = 0; col < N; ++col)
+    {
+      table.SetColumnInfo(col, m_arrColumnInfo[col]);
+    }
+
+    // Decode a block of every column at a time instead of cell by cell
+    const size_t BLOCK = EncodedColumn::BLOCK_VALUES;
+    std::vector<uint64_t> ids(BLOCK);
+    std::vector<uint64_t> keys(BLOCK * N);
+    table.BeginTransaction();
+    for (size_t first = 0; first < m_nRows; first += BLOCK)
+    {
+      size_t count = std::min(BLOCK, m_nRows - first);
+      m_ids.Decode(first, count, ids.data());
+      for (size_t col = 0; col < N; ++col)
+      {
+        if (!IsStringColumn(col))
+        {
+          m_arrColumns[col].Decode(first, count, &keys[col * BLOCK]);
+        }
+      }
+      for (size_t i = 0; i < count; ++i)
+      {
+        RowData row;
+        for (size_t col = 0; col < N; ++col)
+        {
+          row[col] = IsStringColumn(col)
+            ? MakeString(col, m_arrStrings[col][first + i])
+            : FromKey(m_arrColumnInfo[col].type, keys[col * BLOCK + i]);
+        }
+        table.UpsertRow(static_cast<size_t>(ids[i]), row);
+      }
+    }
+    table.CommitTransaction();
+  }
+  // Report memory use. rowBytes counts the encoded IDs and numeric columns,
+  // GetPlainBytes() what the same rows take in a TableEx for comparison.
+  TableExMemoryUsage GetMemoryUsage() const
+  {
+    const size_t INLINE_CAPACITY = std::string().capacity();
+
+    TableExMemoryUsage usage;
+    usage.rows     = m_nRows;
+    usage.rowBytes = m_ids.GetEncodedBytes();
+    for (size_t col = 0; col < N; ++col)
+    {
+      usage.rowBytes += m_arrColumns[col].GetEncodedBytes()
+                      + m_arrStrings[col].size() * sizeof(std::string);
+      for (const std::string& str : m_arrStrings[col])
+      {
+        if (str.capacity() > INLINE_CAPACITY)
+        {
+          usage.stringBytes += str.capacity() + 1;
+        }
+      }
+    }
+    return usage;
+  }
+  // Bytes the rows would take as TableEx map nodes, strings excluded
+  size_t GetPlainBytes() const
+  {
+    return m_nRows * (sizeof(typename TableEx<C, N>::RowNode) + 4 * sizeof(void*));
+  }
+protected:
+  bool IsStringColumn(size_t col) const
+  {
+    return m_arrColumnInfo[col].type == ColumnType::STRING
+        || m_arrColumnInfo[col].type == ColumnType::WSTRING;
+  }
+  // Build a string cell of the column's type without transcoding
+  ColumnData<C> MakeString(size_t col, const std::string& str) const
+  {
+    ColumnData<C> cell(str);
+    cell.type = m_arrColumnInfo[col].type;
+    return cell;
+  }
+  // Map a numeric value to an unsigned key with the same ordering. Signed
+  // values have their sign bit flipped, floating point values are flipped
+  // whole when negative, so small ranges around zero stay small.
+  static uint64_t ToKey(const ColumnData<C>& cell)
+  {
+    const uint32_t SIGN32 = 0x80000000U;
+    const uint64_t SIGN64 = 0x8000000000000000ULL;
+    switch (cell.type)
+    {
+    case ColumnType::INT32:  return static_cast<uint32_t>(cell.value.i32) ^ SIGN32;
+    case ColumnType::INT64:  return static_cast<uint64_t>(cell.value.i64) ^ SIGN64;
+    case ColumnType::UINT32: return cell.value.u32;
+    case ColumnType::UINT64: return cell.value.u64;
+    case ColumnType::FLOAT:
+    {
+      uint32_t bits;
+      memcpy(&bits, &cell.value.f, sizeof(bits));
+      return (bits & SIGN32) ? ~bits : (bits | SIGN32);
+    }
+    case ColumnType::DOUBLE:
+    {
+      uint64_t bits;
+      memcpy(&bits, &cell.value.d, sizeof(bits));
+      return (bits & SIGN64) ? ~bits : (bits | SIGN64);
+    }
+    default:
+      return 0;
+    }
+  }
+  // Inverse of ToKey
+  static ColumnData<C> FromKey(ColumnType type, uint64_t key)
+  {
+    const uint32_t SIGN32 = 0x80000000U;
+    const uint64_t SIGN64 = 0x8000000000000000ULL;
+    switch (type)
+    {
+    case ColumnType::INT32:  return ColumnData<C>(static_cast<int32_t>(static_cast<uint32_t>(key) ^ SIGN32));
+    case ColumnType::INT64:  return ColumnData<C>(static_cast<int64_t>(key ^ SIGN64));
+    case ColumnType::UINT32: return ColumnData<C>(static_cast<uint32_t>(key));
+    case ColumnType::UINT64: return ColumnData<C>(key);
+    case ColumnType::FLOAT:
+    {
+      uint32_t bits = static_cast<uint32_t>(key);
+      bits = (bits & SIGN32) ? (bits & ~SIGN32) : ~bits;
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      return ColumnData<C>(value);
+    }
+    case ColumnType::DOUBLE:
+    {
+      uint64_t bits = (key & SIGN64) ? (key & ~SIGN64) : ~key;
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return ColumnData<C>(value);
+    }
+    default:
+      return ColumnData<C>();
+    }
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_ARCHIVE_TABLE_EX_H_
@@ -0,0 +1,472 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include "ColumnCodec.h"
+
+namespace
+{
+  // Bits needed for a run end inside a block (0 .. BLOCK_VALUES)
+  const unsigned RUN_END_BITS = 11;
+  // Words taken by count packed values of the given width, padding included
+  size_t PackedWords(size_t count, unsigned width)
+  {
+    return (count * width + 63) / 64 + 1;
+  }
+}
+
+EncodedColumn::EncodedColumn(ColumnEncoding encoding)
+  : m_encoding    (encoding)
+  , m_nSize       (0)
+  , m_nCachedBlock(static_cast<size_t>(-1))
+{
+  m_vPending.reserve(BLOCK_VALUES);
+}
+
+void EncodedColumn::Append(uint64_t key)
+{
+  m_vPending.push_back(key);
+  ++m_nSize;
+  if (m_vPending.size() == BLOCK_VALUES)
+  {
+    Seal();
+  }
+}
+
+void EncodedColumn::Seal()
+{
+  if (m_vPending.empty())
+    return;
+
+  EncodeBlock(m_vPending.data(), m_vPending.size());
+  m_vPending.clear();
+}
+
+void EncodedColumn::Clear()
+{
+  m_vBlocks.clear();
+  m_vWords.clear();
+  m_vPending.clear();
+  m_nSize        = 0;
+  m_nCachedBlock = static_cast<size_t>(-1);
+}
+
+ColumnEncoding EncodedColumn::GetBlockEncoding(size_t block) const
+{
+  return block < m_vBlocks.size() ? m_vBlocks[block].encoding
+                                  : ColumnEncoding::PLAIN;
+}
+
+size_t EncodedColumn::GetEncodedBytes() const
+{
+  return m_vWords.size()   * sizeof(uint64_t)
+       + m_vBlocks.size()  * sizeof(Block)
+       + m_vPending.size() * sizeof(uint64_t);
+}
+
+uint64_t EncodedColumn::Get(size_t pos) const
+{
+  size_t       index = 0;
+  const Block* block = FindBlock(pos, index);
+  if (!block)
+    return m_vPending[index];
+
+  switch (block->encoding)
+  {
+  case ColumnEncoding::PLAIN:
+  case ColumnEncoding::FRAME_OF_REFERENCE:
+    return UnpackOne(&m_vWords[block->offset], index,
+                     block->base, block->bitWidth);
+  default:
+    break;
+  }
+
+  size_t blockIndex = static_cast<size_t>(block - m_vBlocks.data());
+  if (m_nCachedBlock != blockIndex)
+  {
+    m_vCachedValues.resize(block->count);
+    DecodeBlock(*block, m_vCachedValues.data());
+    m_nCachedBlock = blockIndex;
+  }
+  return m_vCachedValues[index];
+}
+
+void EncodedColumn::Decode(size_t first, size_t count, uint64_t* out) const
+{
+  uint64_t buffer[BLOCK_VALUES];
+  size_t   end = std::min(first + count, m_nSize);
+  while (first < end)
+  {
+    size_t       index = 0;
+    const Block* block = FindBlock(first, index);
+    if (!block)
+    {
+      std::copy(m_vPending.begin() + index,
+                m_vPending.begin() + index + (end - first), out);
+      return;
+    }
+
+    size_t take = std::min<size_t>(block->count - index, end - first);
+    if (index == 0 && take == block->count)
+    {
+      DecodeBlock(*block, out);
+    }
+    else
+    {
+      DecodeBlock(*block, buffer);
+      std::copy(buffer + index, buffer + index + take, out);
+    }
+    out   += take;
+    first += take;
+  }
+}
+
+void EncodedColumn::FilterRange(uint64_t             lower,
+                                uint64_t             upper,
+                                std::vector<size_t>& positions) const
+{
+  if (lower > upper)
+    return;
+
+  uint64_t buffer[BLOCK_VALUES];
+  uint32_t hits  [BLOCK_VALUES];
+  for (const Block& block : m_vBlocks)
+  {
+    // Skip or take whole blocks from their min/max
+    if (block.maxValue < lower || block.minValue > upper)
+      continue;
+    if (lower <= block.minValue && block.maxValue <= upper)
+    {
+      for (size_t i = 0; i < block.count; ++i)
+      {
+        positions.push_back(block.first + i);
+      }
+      continue;
+    }
+
+    switch (block.encoding)
+    {
+    case ColumnEncoding::PLAIN:
+    case ColumnEncoding::FRAME_OF_REFERENCE:
+    {
+      // Compare packed offsets against the bounds moved into offset space
+      uint64_t low   = std::max(lower, block.minValue) - block.base;
+      uint64_t width = std::min(upper, block.maxValue) - block.base - low;
+      Unpack(&m_vWords[block.offset], block.count, 0, block.bitWidth, buffer);
+      size_t count = 0;
+      for (size_t i = 0; i < block.count; ++i)
+      {
+        hits[count] = static_cast<uint32_t>(i);
+        count += (buffer[i] - low <= width);
+      }
+      for (size_t i = 0; i < count; ++i)
+      {
+        positions.push_back(block.first + hits[i]);
+      }
+      break;
+    }
+    case ColumnEncoding::DELTA:
+    {
+      // Values are ascending, so the matches are one contiguous range
+      DecodeBlock(block, buffer);
+      uint64_t* begin = std::lower_bound(buffer, buffer + block.count, lower);
+      uint64_t* end   = std::upper_bound(begin,  buffer + block.count, upper);
+      for (const uint64_t* p = begin; p < end; ++p)
+      {
+        positions.push_back(block.first + (p - buffer));
+      }
+      break;
+    }
+    case ColumnEncoding::RUN_LENGTH:
+    {
+      uint64_t        ends[BLOCK_VALUES];
+      const uint64_t* words = &m_vWords[block.offset];
+      Unpack(words, block.runs, block.base, block.bitWidth, buffer);
+      Unpack(words + PackedWords(block.runs, block.bitWidth), block.runs,
+             0, RUN_END_BITS, ends);
+      size_t start = 0;
+      for (size_t run = 0; run < block.runs; ++run)
+      {
+        if (buffer[run] >= lower && buffer[run] <= upper)
+        {
+          for (size_t i = start; i < ends[run]; ++i)
+          {
+            positions.push_back(block.first + i);
+          }
+        }
+        start = static_cast<size_t>(ends[run]);
+      }
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  // Values not encoded yet
+  size_t pendingFirst = m_nSize - m_vPending.size();
+  for (size_t i = 0; i < m_vPending.size(); ++i)
+  {
+    if (m_vPending[i] >= lower && m_vPending[i] <= upper)
+    {
+      positions.push_back(pendingFirst + i);
+    }
+  }
+}
+
+void EncodedColumn::EncodeBlock(const uint64_t* values, size_t count)
+{
+  Block block;
+  block.first    = m_nSize - m_vPending.size();
+  block.count    = static_cast<uint32_t>(count);
+  block.runs     = 1;
+  block.minDelta = 0;
+  block.offset   = m_vWords.size();
+
+  // Statistics deciding the encoding
+  uint64_t minValue  = values[0];
+  uint64_t maxValue  = values[0];
+  bool     ascending = true;
+  uint64_t minDelta  = static_cast<uint64_t>(-1);
+  uint64_t maxDelta  = 0;
+  for (size_t i = 1; i < count; ++i)
+  {
+    minValue   = std::min(minValue, values[i]);
+    maxValue   = std::max(maxValue, values[i]);
+    ascending  = ascending && values[i] >= values[i - 1];
+    block.runs += values[i] != values[i - 1];
+    uint64_t delta = values[i] - values[i - 1];
+    minDelta   = std::min(minDelta, delta);
+    maxDelta   = std::max(maxDelta, delta);
+  }
+  block.minValue = minValue;
+  block.maxValue = maxValue;
+
+  unsigned forWidth   = BitWidth(maxValue - minValue);
+  unsigned deltaWidth = count > 1 ? BitWidth(maxDelta - minDelta) : 0;
+  size_t   forBits    = count * forWidth;
+  size_t   deltaBits  = ascending ? (count - 1) * deltaWidth
+                                  : static_cast<size_t>(-1);
+  size_t   runBits    = block.runs * (forWidth + RUN_END_BITS);
+  size_t   plainBits  = count * 64;
+
+  ColumnEncoding encoding = m_encoding;
+  if (encoding == ColumnEncoding::AUTO)
+  {
+    size_t best = plainBits;
+    encoding    = ColumnEncoding::PLAIN;
+    if (forBits < best)
+    {
+      best     = forBits;
+      encoding = ColumnEncoding::FRAME_OF_REFERENCE;
+    }
+    if (deltaBits < best)
+    {
+      best     = deltaBits;
+      encoding = ColumnEncoding::DELTA;
+    }
+    if (runBits < best)
+    {
+      encoding = ColumnEncoding::RUN_LENGTH;
+    }
+  }
+  else if (encoding == ColumnEncoding::DELTA && !ascending)
+  {
+    // Differences of unsorted data would wrap, keep such blocks packed
+    encoding = ColumnEncoding::FRAME_OF_REFERENCE;
+  }
+  block.encoding = encoding;
+
+  switch (encoding)
+  {
+  case ColumnEncoding::PLAIN:
+    block.base     = 0;
+    block.bitWidth = 64;
+    Pack(values, count, 0, 64, m_vWords);
+    break;
+  case ColumnEncoding::FRAME_OF_REFERENCE:
+    block.base     = minValue;
+    block.bitWidth = static_cast<uint8_t>(forWidth);
+    Pack(values, count, minValue, forWidth, m_vWords);
+    break;
+  case ColumnEncoding::DELTA:
+  {
+    uint64_t deltas[BLOCK_VALUES];
+    for (size_t i = 1; i < count; ++i)
+    {
+      deltas[i - 1] = values[i] - values[i - 1];
+    }
+    block.base     = values[0];
+    block.minDelta = count > 1 ? minDelta : 0;
+    block.bitWidth = static_cast<uint8_t>(deltaWidth);
+    Pack(deltas, count - 1, block.minDelta, deltaWidth, m_vWords);
+    break;
+  }
+  case ColumnEncoding::RUN_LENGTH:
+  default:
+  {
+    uint64_t runValues[BLOCK_VALUES];
+    uint64_t runEnds  [BLOCK_VALUES];
+    size_t   runs = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      if (i == 0 || values[i] != values[i - 1])
+      {
+        runValues[runs++] = values[i];
+      }
+      runEnds[runs - 1] = i + 1;
+    }
+    block.encoding = ColumnEncoding::RUN_LENGTH;
+    block.base     = minValue;
+    block.bitWidth = static_cast<uint8_t>(forWidth);
+    Pack(runValues, runs, minValue, forWidth, m_vWords);
+    Pack(runEnds, runs, 0, RUN_END_BITS, m_vWords);
+    break;
+  }
+  }
+  m_vBlocks.push_back(block);
+}
+
+void EncodedColumn::DecodeBlock(const Block& block, uint64_t* out) const
+{
+  const uint64_t* words = &m_vWords[block.offset];
+  switch (block.encoding)
+  {
+  case ColumnEncoding::PLAIN:
+  case ColumnEncoding::FRAME_OF_REFERENCE:
+    Unpack(words, block.count, block.base, block.bitWidth, out);
+    break;
+  case ColumnEncoding::DELTA:
+    // Unpack the differences behind the first value, then prefix-sum them
+    out[0] = block.base;
+    Unpack(words, block.count - 1, block.minDelta, block.bitWidth, out + 1);
+    for (size_t i = 1; i < block.count; ++i)
+    {
+      out[i] += out[i - 1];
+    }
+    break;
+  case ColumnEncoding::RUN_LENGTH:
+  default:
+  {
+    uint64_t runValues[BLOCK_VALUES];
+    uint64_t runEnds  [BLOCK_VALUES];
+    Unpack(words, block.runs, block.base, block.bitWidth, runValues);
+    Unpack(words + PackedWords(block.runs, block.bitWidth), block.runs,
+           0, RUN_END_BITS, runEnds);
+    size_t start = 0;
+    for (size_t run = 0; run < block.runs; ++run)
+    {
+      std::fill(out + start, out + runEnds[run], runValues[run]);
+      start = static_cast<size_t>(runEnds[run]);
+    }
+    break;
+  }
+  }
+}
+
+const EncodedColumn::Block* EncodedColumn::FindBlock(size_t pos, size_t& index) const
+{
+  size_t pendingFirst = m_nSize - m_vPending.size();
+  if (pos >= pendingFirst)
+  {
+    index = pos - pendingFirst;
+    return nullptr;
+  }
+
+  // Blocks are full except where Seal() cut one short, so search by start
+  auto it = std::upper_bound(m_vBlocks.begin(), m_vBlocks.end(), pos,
+    [](size_t value, const Block& block)
+  {
+    return value < block.first;
+  });
+  --it;
+  index = pos - it->first;
+  return &*it;
+}
+
+unsigned EncodedColumn::BitWidth(uint64_t value)
+{
+  unsigned width = 0;
+  while (value)
+  {
+    ++width;
+    value >>= 1;
+  }
+  return width;
+}
+
+void EncodedColumn::Pack(const uint64_t*        values,
+                         size_t                 count,
+                         uint64_t               base,
+                         unsigned               width,
+                         std::vector<uint64_t>& words)
+{
+  size_t offset = words.size();
+  words.resize(offset + PackedWords(count, width), 0);
+  if (width == 0)
+    return;
+
+  uint64_t* out = &words[offset];
+  for (size_t i = 0; i < count; ++i)
+  {
+    uint64_t value = values[i] - base;
+    size_t   bit   = i * width;
+    size_t   word  = bit >> 6;
+    unsigned shift = bit & 63;
+    out[word] |= value << shift;
+    if (shift + width > 64)
+    {
+      out[word + 1] |= value >> (64 - shift);
+    }
+  }
+}
+
+void EncodedColumn::Unpack(const uint64_t* words,
+                           size_t          count,
+                           uint64_t        base,
+                           unsigned        width,
+                           uint64_t*       out)
+{
+  if (width == 0)
+  {
+    std::fill(out, out + count, base);
+    return;
+  }
+
+  // Branch-free: the high part always comes from the next word, shifted
+  // in two steps so a zero shift contributes nothing instead of being UB
+  const uint64_t mask = width == 64 ? ~0ULL : ((1ULL << width) - 1);
+  for (size_t i = 0; i < count; ++i)
+  {
+    size_t   bit   = i * width;
+    size_t   word  = bit >> 6;
+    unsigned shift = bit & 63;
+    uint64_t value = (words[word] >> shift)
+                   | ((words[word + 1] << 1) << (63 - shift));
+    out[i] = base + (value & mask);
+  }
+}
+
+uint64_t EncodedColumn::UnpackOne(const uint64_t* words,
+                                  size_t          index,
+                                  uint64_t        base,
+                                  unsigned        width)
+{
+  if (width == 0)
+    return base;
+
+  const uint64_t mask  = width == 64 ? ~0ULL : ((1ULL << width) - 1);
+  size_t         bit   = index * width;
+  size_t         word  = bit >> 6;
+  unsigned       shift = bit & 63;
+  uint64_t       value = (words[word] >> shift)
+                       | ((words[word + 1] << 1) << (63 - shift));
+  return base + (value & mask);
+}
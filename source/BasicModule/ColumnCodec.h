@@ -0,0 +1,123 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_COLUMN_CODEC_H_
+#define   GUI_WXWIDGETS_MAIN_APP_COLUMN_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block encodings of an EncodedColumn
+enum class ColumnEncoding
+{
+  AUTO,                // Pick the smallest encoding per block
+  PLAIN,               // 64 bits per value
+  FRAME_OF_REFERENCE,  // Block minimum plus bit-packed offsets
+  DELTA,               // First value plus bit-packed differences (sorted data)
+  RUN_LENGTH           // Bit-packed (value, run end) pairs
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : EncodedColumn
+ * PURPOSE : Append-only column of 64-bit keys compressed in fixed blocks
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Keys are unsigned and compared as such; callers map signed and
+ *           floating point values to order-preserving keys first.
+ *           Values are buffered until a block of BLOCK_VALUES is full, then
+ *           encoded; Seal() encodes a trailing partial block. Decoding
+ *           works a block at a time with branch-free loops the compiler
+ *           vectorizes, and range filters compare packed offsets without
+ *           adding the block base back.
+ *
+ *****************************************************************************/
+
+class EncodedColumn
+{
+public:
+  // Values per encoded block
+  static const size_t BLOCK_VALUES = 1024;
+
+  explicit EncodedColumn(ColumnEncoding encoding = ColumnEncoding::AUTO);
+
+  // Append one key
+  void     Append       (uint64_t key);
+  // Encode the values still buffered, further appends start a new block
+  void     Seal         ();
+  // Remove every value
+  void     Clear        ();
+
+  // Number of values, buffered ones included
+  size_t   size         () const { return m_nSize; }
+  // Number of encoded blocks
+  size_t   GetBlockCount() const { return m_vBlocks.size(); }
+  // Encoding used by one block
+  ColumnEncoding GetBlockEncoding(size_t block) const;
+  // Bytes used by encoded blocks and the pending buffer
+  size_t   GetEncodedBytes() const;
+
+  // Get one value. Frame-of-reference and plain blocks unpack the single
+  // value; delta and run-length blocks are decoded whole and cached.
+  uint64_t Get          (size_t pos) const;
+  // Decode count values starting at first into out
+  void     Decode       (size_t first, size_t count, uint64_t* out) const;
+  // Append the positions of values in [lower, upper] to positions
+  void     FilterRange  (uint64_t             lower,
+                         uint64_t             upper,
+                         std::vector<size_t>& positions) const;
+protected:
+  struct Block
+  {
+    ColumnEncoding encoding;
+    size_t         first;     // Position of the first value
+    uint32_t       count;     // Values in the block
+    uint32_t       runs;      // Runs of a RUN_LENGTH block
+    uint8_t        bitWidth;  // Width of packed values (or differences)
+    uint64_t       base;      // Minimum (or first value for DELTA)
+    uint64_t       minDelta;  // Smallest difference of a DELTA block
+    uint64_t       minValue;  // Smallest and largest value, for skipping
+    uint64_t       maxValue;  // or taking whole blocks in filters
+    size_t         offset;    // First word in m_vWords
+  };
+
+  // Encode values as one block
+  void     EncodeBlock  (const uint64_t* values, size_t count);
+  // Decode a whole block into out (block.count values)
+  void     DecodeBlock  (const Block& block, uint64_t* out) const;
+  // Block holding position pos, and the index of pos inside it
+  const Block* FindBlock(size_t pos, size_t& index) const;
+
+  // Bit-packing kernels. Every packed array is followed by a padding word
+  // so the unpack loop can always read two words without branching.
+  static unsigned BitWidth (uint64_t value);
+  static void     Pack     (const uint64_t* values, size_t count,
+                            uint64_t base, unsigned width,
+                            std::vector<uint64_t>& words);
+  static void     Unpack   (const uint64_t* words, size_t count,
+                            uint64_t base, unsigned width, uint64_t* out);
+  static uint64_t UnpackOne(const uint64_t* words, size_t index,
+                            uint64_t base, unsigned width);
+protected:
+  // Requested encoding
+  ColumnEncoding             m_encoding;
+  // Encoded blocks and their packed words
+  std::vector<Block>         m_vBlocks;
+  std::vector<uint64_t>      m_vWords;
+  // Values not yet encoded (always after the last block)
+  std::vector<uint64_t>      m_vPending;
+  // Total number of values
+  size_t                     m_nSize;
+  // Last block decoded by Get, for delta and run-length random access
+  mutable size_t             m_nCachedBlock;
+  mutable std::vector<uint64_t> m_vCachedValues;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_COLUMN_CODEC_H_
@@ -0,0 +1,119 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include "ColumnSketch.h"
+
+HyperLogLog::HyperLogLog(std::pmr::memory_resource* resource)
+  : m_vRegisters(resource)
+{
+}
+
+void HyperLogLog::Add(uint64_t hash)
+{
+  if (m_vRegisters.empty())
+  {
+    m_vRegisters.assign(REGISTERS, 0);
+  }
+
+  // The top bits pick the register, the rank is the position of the first
+  // set bit in the rest (a sentinel bit bounds it)
+  size_t   index = static_cast<size_t>(hash >> (64 - PRECISION));
+  uint64_t rest  = (hash << PRECISION) | (uint64_t(1) << (PRECISION - 1));
+  uint8_t  rank  = 1;
+  while (!(rest & (uint64_t(1) << 63)))
+  {
+    rest <<= 1;
+    ++rank;
+  }
+  m_vRegisters[index] = (std::max)(m_vRegisters[index], rank);
+}
+
+size_t HyperLogLog::Estimate() const
+{
+  if (m_vRegisters.empty())
+    return 0;
+
+  const double registers = static_cast<double>(REGISTERS);
+  double sum   = 0.0;
+  size_t zeros = 0;
+  for (uint8_t rank : m_vRegisters)
+  {
+    sum   += std::ldexp(1.0, -static_cast<int>(rank));
+    zeros += (rank == 0) ? 1 : 0;
+  }
+  double alpha    = 0.7213 / (1.0 + 1.079 / registers);
+  double estimate = alpha * registers * registers / sum;
+  // Few values: count the empty registers instead (linear counting)
+  if (estimate <= 2.5 * registers && zeros > 0)
+  {
+    estimate = registers * std::log(registers / static_cast<double>(zeros));
+  }
+  return static_cast<size_t>(estimate + 0.5);
+}
+
+void HyperLogLog::Clear()
+{
+  std::pmr::vector<uint8_t>(m_vRegisters.get_allocator()).swap(m_vRegisters);
+}
+
+CountMinSketch::CountMinSketch(std::pmr::memory_resource* resource)
+  : m_vCounters(resource)
+{
+}
+
+void CountMinSketch::Add(uint64_t hash, uint32_t count)
+{
+  if (m_vCounters.empty())
+  {
+    m_vCounters.assign(DEPTH * WIDTH, 0);
+  }
+  for (size_t row = 0; row < DEPTH; ++row)
+  {
+    m_vCounters[Cell(hash, row)] += count;
+  }
+}
+
+void CountMinSketch::Remove(uint64_t hash, uint32_t count)
+{
+  if (m_vCounters.empty())
+    return;
+
+  for (size_t row = 0; row < DEPTH; ++row)
+  {
+    uint32_t& counter = m_vCounters[Cell(hash, row)];
+    counter -= (std::min)(counter, count);
+  }
+}
+
+size_t CountMinSketch::Estimate(uint64_t hash) const
+{
+  if (m_vCounters.empty())
+    return 0;
+
+  uint32_t estimate = UINT32_MAX;
+  for (size_t row = 0; row < DEPTH; ++row)
+  {
+    estimate = (std::min)(estimate, m_vCounters[Cell(hash, row)]);
+  }
+  return estimate;
+}
+
+void CountMinSketch::Clear()
+{
+  std::pmr::vector<uint32_t>(m_vCounters.get_allocator()).swap(m_vCounters);
+}
+
+size_t CountMinSketch::Cell(uint64_t hash, size_t row)
+{
+  // Each row takes its bucket from its own 16 bits of the hash
+  return row * WIDTH + static_cast<size_t>((hash >> (row * 16)) & (WIDTH - 1));
+}
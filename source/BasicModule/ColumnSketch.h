@@ -0,0 +1,106 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_COLUMN_SKETCH_H_
+#define   GUI_WXWIDGETS_MAIN_APP_COLUMN_SKETCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory_resource>
+
+/*****************************************************************************
+ *
+ * FUNCTION: MixHash
+ * PURPOSE : Spread the bits of a 64-bit value (SplitMix64 finalizer)
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Sketches take their bucket numbers from different bit ranges of
+ *           the result, so every bit of the input must reach all of them
+ *
+ *****************************************************************************/
+
+inline uint64_t MixHash(uint64_t value)
+{
+  value ^= value >> 30;
+  value *= 0xBF58476D1CE4E5B9ULL;
+  value ^= value >> 27;
+  value *= 0x94D049BB133111EBULL;
+  value ^= value >> 31;
+  return value;
+}
+
+/*****************************************************************************
+ *
+ * CLASS   : HyperLogLog
+ * PURPOSE : Estimate the number of distinct hashes seen in fixed memory
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: 2^PRECISION one-byte registers (4 KB), about 1.6% standard
+ *           error. Values can not be taken out again, so after updates and
+ *           removals the estimate is of every value ever added.
+ *
+ *****************************************************************************/
+
+class HyperLogLog
+{
+public:
+  static const size_t PRECISION = 12;
+  static const size_t REGISTERS = size_t(1) << PRECISION;
+
+  explicit HyperLogLog(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+  // Add a (mixed) hash
+  void     Add     (uint64_t hash);
+  // Estimated number of distinct hashes added
+  size_t   Estimate() const;
+  // Forget everything, registers are allocated on the first Add
+  void     Clear   ();
+  // Bytes held
+  size_t   GetBytes() const { return m_vRegisters.capacity(); }
+protected:
+  std::pmr::vector<uint8_t> m_vRegisters;
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : CountMinSketch
+ * PURPOSE : Estimate how often each hash was counted in fixed memory
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: DEPTH rows of WIDTH counters (64 KB). Counts can be taken back,
+ *           an estimate is never below the true count and is above it by
+ *           at most 2 / WIDTH of the total with high probability.
+ *
+ *****************************************************************************/
+
+class CountMinSketch
+{
+public:
+  static const size_t DEPTH = 4;
+  static const size_t WIDTH = 4096;
+
+  explicit CountMinSketch(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+  // Count a (mixed) hash count times
+  void     Add     (uint64_t hash, uint32_t count = 1);
+  // Take back counts added before
+  void     Remove  (uint64_t hash, uint32_t count = 1);
+  // Estimated count of a hash
+  size_t   Estimate(uint64_t hash) const;
+  // Forget everything, counters are allocated on the first Add
+  void     Clear   ();
+  // Bytes held
+  size_t   GetBytes() const { return m_vCounters.capacity() * sizeof(uint32_t); }
+protected:
+  // Counter of a hash in one row
+  static size_t Cell(uint64_t hash, size_t row);
+
+  std::pmr::vector<uint32_t> m_vCounters;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_COLUMN_SKETCH_H_
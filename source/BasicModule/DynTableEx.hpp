@@ -0,0 +1,1076 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_DYN_TABLE_EX_H_
+#define   GUI_WXWIDGETS_MAIN_APP_DYN_TABLE_EX_H_
+
+#include <cerrno>
+#include <cinttypes>
+#include <fstream>
+#include <unordered_map>
+
+/*****************************************************************************
+ *
+ * CLASS   : DynTableEx
+ * PURPOSE : Table whose columns are set at run time, stored column by column
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: One instantiation serves every column count, unlike TableEx<C, N>.
+ *           Each column keeps its cells in one array by row slot: numbers as
+ *           8-byte values of the column type, strings as UTF-8. Sorting and
+ *           range filters switch on the column type once and then run a
+ *           loop specialized for it (see VisitNumeric), instead of
+ *           switching per compared cell. Rows keep their slot until Clear;
+ *           while row IDs equal their slots (0, 1, 2, ... as a loader
+ *           writes them) no ID lookup table is kept. Like TableEx, updated
+ *           rows keep their sorted position until the next SortByColumn,
+ *           and inserted rows are merged into a built view instead of
+ *           rebuilding it. Quick search looks slots up in a TrigramIndex
+ *           over the columns with EnableTextIndex. There is no lazy sort
+ *           window and no secondary index: a sort or range filter always
+ *           runs over the whole column, which the typed kernels keep fast.
+ *
+ *****************************************************************************/
+
+template <typename C>
+class DynTableEx
+{
+public:
+  using ColumnType = typename ColumnInfo<C>::ColumnType;
+  // One numeric cell, laid out as the value of ColumnData
+  using CellValue  = decltype(ColumnData<C>::value);
+
+  static const size_t NPOS = static_cast<size_t>(-1);
+
+  // Inclusive range filter of one column; a missing bound is open and
+  // upperOpen leaves the upper bound itself out
+  struct RangeFilter
+  {
+    bool                           active    = false;
+    bool                           hasLower  = false;
+    bool                           hasUpper  = false;
+    bool                           upperOpen = false;
+    ColumnData<C>                  lower;
+    ColumnData<C>                  upper;
+  };
+protected:
+  struct Column
+  {
+    ColumnInfo<C>                  info;
+    // Cells by slot, numeric columns use values and string columns texts
+    std::vector<CellValue>         values;
+    std::vector<std::string>       texts;
+    RangeFilter                    range;
+  };
+
+  std::vector<Column>              m_vColumns;
+  // Slot -> row ID, and row ID -> slot unless IDs equal slots
+  std::vector<size_t>              m_vIds;
+  std::unordered_map<size_t, size_t> m_mapSlots;
+  bool                             m_bDenseIds         = true;
+  // Slots are in ID order while every insert has a larger ID
+  bool                             m_bIdOrdered        = true;
+  // Version of the last change of each slot, and of the table
+  std::vector<uint64_t>            m_vRowVersions;
+  uint64_t                         m_nVersion          = 0;
+  // Folded quick search text, empty when off
+  std::string                      m_strQuickSearch;
+  size_t                           m_nSortCol          = NPOS;
+  bool                             m_bSortAscending    = true;
+  // Slots shown, in display order; rebuilt when invalid
+  mutable std::vector<size_t>      m_vView;
+  mutable bool                     m_bViewValid        = false;
+  // Slots inserted since the view was built, merged into it on next read
+  mutable std::vector<size_t>      m_vAppendedSlots;
+  // Indicates a sort key changed after sorting, so the view is out of order
+  mutable bool                     m_bSortOrderStale   = false;
+  // Sort key of the slot being updated, see BeginWrite
+  ColumnData<C>                    m_oldSortKey;
+  bool                             m_bHasOldSortKey    = false;
+  size_t                           m_nTransactionDepth = 0;
+  std::vector<size_t>              m_vDirtyIds;
+  // Value statistics, only maintained for columns with m_vHasStats set
+  std::vector<bool>                m_vHasStats;
+  std::vector<ColumnStats<C>>      m_vStats;
+  // Formatted lengths, only maintained for columns with m_vHasWidthStats
+  // set; rebuilt on read when stale, hence mutable
+  std::vector<bool>                m_vHasWidthStats;
+  mutable std::vector<TextWidthStats> m_vWidthStats;
+  // Trigram index by slot over the formatted text of the columns with
+  // m_vTextIndexed set, and the slots matching the quick search
+  std::vector<bool>                m_vTextIndexed;
+  TrigramIndex                     m_textIndex;
+  IdRangeSet                       m_quickSearchSlots;
+  std::vector<std::string>         m_vTexts;
+  std::vector<std::string>         m_vOldTexts;
+public:
+  DynTableEx()
+  {
+  }
+  explicit DynTableEx(const std::vector<ColumnInfo<C>>& columns)
+  {
+    SetColumns(columns);
+  }
+
+  // Replace the columns, which removes every row
+  void SetColumns(const std::vector<ColumnInfo<C>>& columns)
+  {
+    Clear();
+    m_vColumns.clear();
+    m_vColumns.resize(columns.size());
+    for (size_t col = 0; col < columns.size(); ++col)
+    {
+      m_vColumns[col].info = columns[col];
+    }
+    m_vHasStats     .assign(columns.size(), false);
+    m_vStats        .assign(columns.size(), ColumnStats<C>());
+    m_vHasWidthStats.assign(columns.size(), false);
+    m_vWidthStats   .assign(columns.size(), TextWidthStats());
+    m_vTextIndexed  .assign(columns.size(), false);
+    m_nSortCol   = NPOS;
+    m_bViewValid = false;
+  }
+  // Get the number of columns
+  size_t GetColumnCount() const
+  {
+    return m_vColumns.size();
+  }
+  // Get column metadata
+  const ColumnInfo<C>& GetColumnInfo(size_t col) const
+  {
+    static ColumnInfo<C> dummyColumn = {};
+    return (col < m_vColumns.size()) ? m_vColumns[col].info : dummyColumn;
+  }
+  // Remove every row, columns and filters are kept
+  void Clear()
+  {
+    for (Column& column : m_vColumns)
+    {
+      column.values.clear();
+      column.texts .clear();
+    }
+    for (ColumnStats<C>& stats : m_vStats)
+    {
+      stats.Clear();
+    }
+    for (TextWidthStats& stats : m_vWidthStats)
+    {
+      stats.Clear();
+    }
+    m_textIndex.Clear();
+    m_quickSearchSlots.Clear();
+    m_vIds.clear();
+    m_mapSlots.clear();
+    m_vRowVersions.clear();
+    m_bDenseIds  = true;
+    m_bIdOrdered = true;
+    m_bViewValid = false;
+    ++m_nVersion;
+  }
+  // Insert or update a row; missing cells are 0 or empty, cells of another
+  // type are converted to the column type
+  void UpsertRow(size_t id, const std::vector<ColumnData<C>>& row)
+  {
+    bool   inserted = false;
+    size_t slot     = AcquireSlot(id, inserted);
+    BeginWrite(slot, inserted);
+    for (size_t col = 0; col < m_vColumns.size(); ++col)
+    {
+      StoreCell(m_vColumns[col], slot, col < row.size() ? &row[col] : nullptr);
+    }
+    Touch(id, slot, inserted);
+  }
+  // Insert or update a row from texts, parsed by the column types
+  void UpsertRowText(size_t id, const std::vector<std::string>& fields)
+  {
+    bool   inserted = false;
+    size_t slot     = AcquireSlot(id, inserted);
+    BeginWrite(slot, inserted);
+    for (size_t col = 0; col < m_vColumns.size(); ++col)
+    {
+      Column&            column = m_vColumns[col];
+      const std::string& field  = col < fields.size() ? fields[col] : std::string();
+      if (IsStringType(column.info.type))
+      {
+        column.texts[slot] = field;
+      }
+      else
+      {
+        column.values[slot] =
+          ColumnData<C>::FromText(column.info.type, field, column.info.format).value;
+      }
+    }
+    Touch(id, slot, inserted);
+  }
+  // Check if a row exists
+  bool Contains(size_t id) const
+  {
+    return FindSlot(id) != NPOS;
+  }
+  // Get one cell of a row, linked to its column info; a default value if
+  // the row does not exist
+  ColumnData<C> GetCell(size_t id, size_t col) const
+  {
+    size_t slot = FindSlot(id);
+    return (slot != NPOS && col < m_vColumns.size()) ? CellAt(slot, col) : ColumnData<C>();
+  }
+  // Get the formatted cells of a row, false if it does not exist
+  bool FormatRow(size_t id, std::vector<std::string>& texts) const
+  {
+    size_t slot = FindSlot(id);
+    if (slot == NPOS)
+      return false;
+
+    texts.resize(m_vColumns.size());
+    for (size_t col = 0; col < m_vColumns.size(); ++col)
+    {
+      texts[col] = FormatAt(slot, col);
+    }
+    return true;
+  }
+  // Version of the last change of a row, 0 if it does not exist
+  uint64_t GetRowVersion(size_t id) const
+  {
+    size_t slot = FindSlot(id);
+    return slot != NPOS ? m_vRowVersions[slot] : 0;
+  }
+  // Version of the last change of the table
+  uint64_t GetVersion() const
+  {
+    return m_nVersion;
+  }
+  // Get the number of rows, filtered or not
+  size_t GetRowCount() const
+  {
+    return m_vIds.size();
+  }
+  // Get the number of rows shown
+  size_t size() const
+  {
+    return ViewSlots().size();
+  }
+  // Get the row ID shown at a position, NPOS past the end
+  size_t GetViewId(size_t pos) const
+  {
+    const std::vector<size_t>& view = ViewSlots();
+    return pos < view.size() ? m_vIds[view[pos]] : NPOS;
+  }
+  // Visit the shown rows in display order
+  template <typename F>
+  void ForEachViewId(F func) const
+  {
+    for (size_t slot : ViewSlots())
+    {
+      func(m_vIds[slot]);
+    }
+  }
+  // Set filter function for a column; it is passed a const ColumnData<C>*
+  void SetFilter(size_t col, std::function<bool(const void*)> filter)
+  {
+    if (col < m_vColumns.size())
+    {
+      m_vColumns[col].info.filter = filter;
+      m_bViewValid                = false;
+    }
+  }
+  // Set an inclusive range filter, nullptr leaves that side open and
+  // upperOpen keeps values below upper only. Bounds are expected in the
+  // column type.
+  void SetRangeFilter(size_t               col,
+                      const ColumnData<C>* lower,
+                      const ColumnData<C>* upper,
+                      bool                 upperOpen = false)
+  {
+    if (col >= m_vColumns.size())
+      return;
+
+    RangeFilter& range = m_vColumns[col].range;
+    range.active    = lower || upper;
+    range.hasLower  = lower != nullptr;
+    range.hasUpper  = upper != nullptr;
+    range.upperOpen = upper && upperOpen;
+    range.lower     = lower ? *lower : ColumnData<C>();
+    range.upper     = upper ? *upper : ColumnData<C>();
+    m_bViewValid    = false;
+  }
+  // Clear filter for a specific column or all columns if col is out of range
+  void ClearFilter(size_t col = -1)
+  {
+    m_bViewValid = false;
+    for (size_t i = 0; i < m_vColumns.size(); ++i)
+    {
+      if (col >= m_vColumns.size() || i == col)
+      {
+        m_vColumns[i].info.filter = nullptr;
+        m_vColumns[i].range       = RangeFilter();
+      }
+    }
+  }
+  // Index the formatted text of a column for SetQuickSearch
+  void EnableTextIndex(size_t col, bool enable = true)
+  {
+    if (col >= m_vColumns.size() || m_vTextIndexed[col] == enable)
+      return;
+
+    m_vTextIndexed[col] = enable;
+    m_textIndex.Clear();
+    for (size_t slot = 0; slot < m_vIds.size(); ++slot)
+    {
+      if (CollectTexts(slot, m_vTexts))
+      {
+        m_textIndex.Insert(slot, m_vTexts);
+      }
+    }
+    SetQuickSearch(m_strQuickSearch);
+  }
+  // Check if a column is searched through the text index
+  bool HasTextIndex(size_t col) const
+  {
+    return col < m_vColumns.size() && m_vTextIndexed[col];
+  }
+  // Only show rows where a text-indexed column (any column if none is)
+  // contains text, ignoring ASCII case; empty text shows all. The matches
+  // are looked up in the trigram index, then kept up to date by upserts.
+  void SetQuickSearch(const std::string& text)
+  {
+    m_strQuickSearch = TrigramIndex::Fold(text);
+    m_quickSearchSlots.Clear();
+    m_bViewValid     = false;
+    if (m_strQuickSearch.empty())
+      return;
+
+    // Without an indexed column every row is checked
+    std::vector<size_t> slots;
+    if (std::find(m_vTextIndexed.begin(), m_vTextIndexed.end(), true) == m_vTextIndexed.end())
+    {
+      for (size_t slot = 0; slot < m_vIds.size(); ++slot)
+      {
+        if (MatchesQuickSearch(slot))
+        {
+          slots.push_back(slot);
+        }
+      }
+      m_quickSearchSlots = IdRangeSet::FromSorted(slots);
+      return;
+    }
+
+    // Long patterns only narrow down the rows, check those left
+    bool       exact      = false;
+    IdRangeSet candidates = m_textIndex.Search(m_strQuickSearch, exact);
+    if (exact)
+    {
+      m_quickSearchSlots = std::move(candidates);
+      return;
+    }
+    candidates.ForEach([&](size_t slot)
+    {
+      if (MatchesQuickSearch(slot))
+      {
+        slots.push_back(slot);
+      }
+    });
+    m_quickSearchSlots = IdRangeSet::FromSorted(slots);
+  }
+  // Check if any filter is set
+  bool HasActiveFilters() const
+  {
+    if (!m_strQuickSearch.empty())
+      return true;
+
+    for (const Column& column : m_vColumns)
+    {
+      if (column.range.active || column.info.filter)
+        return true;
+    }
+    return false;
+  }
+  // Check a row against all filters, false if it does not exist
+  bool PassesFilters(size_t id) const
+  {
+    size_t slot = FindSlot(id);
+    if (slot == NPOS)
+      return false;
+
+    std::vector<size_t> slots(1, slot);
+    FilterSlots(slots);
+    return !slots.empty();
+  }
+  // Sort the shown rows by a column, ties stay in ID order. col out of
+  // range returns to ID order.
+  void SortByColumn(size_t col, bool ascending = true)
+  {
+    m_nSortCol       = col < m_vColumns.size() ? col : NPOS;
+    m_bSortAscending = ascending;
+    m_bViewValid     = false;
+  }
+  // Check if the view is sorted by a column
+  bool IsSorted() const
+  {
+    return m_nSortCol != NPOS;
+  }
+  // Start a batch of updates; nested calls are folded into the outermost one
+  void BeginTransaction()
+  {
+    if (m_nTransactionDepth++ == 0)
+    {
+      m_vDirtyIds.clear();
+    }
+  }
+  // Finish a batch of updates and return the sorted, unique IDs it touched
+  std::vector<size_t> CommitTransaction()
+  {
+    if (m_nTransactionDepth == 0 || --m_nTransactionDepth > 0)
+      return std::vector<size_t>();
+
+    std::vector<size_t> dirtyIds;
+    dirtyIds.swap(m_vDirtyIds);
+    std::sort(dirtyIds.begin(), dirtyIds.end());
+    dirtyIds.erase(
+      std::unique(dirtyIds.begin(), dirtyIds.end()), dirtyIds.end());
+    return dirtyIds;
+  }
+  // Maintain value statistics (distinct values, frequencies, histogram)
+  // of a column from now on; enabling counts the existing rows once
+  void EnableColumnStats(size_t col, bool enable = true)
+  {
+    if (col >= m_vColumns.size() || m_vHasStats[col] == enable)
+      return;
+
+    m_vHasStats[col] = enable;
+    m_vStats[col].Clear();
+    for (size_t slot = 0; enable && slot < m_vIds.size(); ++slot)
+    {
+      m_vStats[col].Add(CellAt(slot, col));
+    }
+  }
+  // Get the value statistics of a column, empty unless enabled
+  const ColumnStats<C>& GetColumnStats(size_t col) const
+  {
+    return m_vStats[(col < m_vStats.size()) ? col : 0];
+  }
+  // Maintain the lengths of the formatted values of a column from now on,
+  // for sizing it; enabling measures the existing rows once
+  void EnableWidthStats(size_t col, bool enable = true)
+  {
+    if (col >= m_vColumns.size() || m_vHasWidthStats[col] == enable)
+      return;
+
+    m_vHasWidthStats[col] = enable;
+    m_vWidthStats[col].Clear();
+    if (enable)
+    {
+      RebuildWidthStats(col);
+    }
+  }
+  // Get the width statistics of a column, empty unless enabled. Rebuilt
+  // here if updates took out the longest values it knew.
+  const TextWidthStats& GetWidthStats(size_t col) const
+  {
+    col = (col < m_vWidthStats.size()) ? col : 0;
+    if (m_vHasWidthStats[col] && m_vWidthStats[col].IsStale())
+    {
+      m_vWidthStats[col].Clear();
+      RebuildWidthStats(col);
+    }
+    return m_vWidthStats[col];
+  }
+  // Report how much memory the table uses
+  TableExMemoryUsage GetMemoryUsage() const
+  {
+    // A hash node carries its value, a link and the cached hash
+    const size_t HASH_NODE_OVERHEAD = 2 * sizeof(void*);
+    // A red-black tree node carries a color and three links on top of its value
+    const size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+    const size_t INLINE_CAPACITY    = std::string().capacity();
+
+    TableExMemoryUsage usage;
+    usage.rows     = m_vIds.size();
+    usage.rowBytes = m_vIds.capacity() * sizeof(size_t)
+                   + m_vRowVersions.capacity() * sizeof(uint64_t);
+    for (const Column& column : m_vColumns)
+    {
+      usage.rowBytes += column.values.capacity() * sizeof(CellValue)
+                      + column.texts .capacity() * sizeof(std::string);
+      for (const std::string& text : column.texts)
+      {
+        usage.stringBytes += text.capacity() > INLINE_CAPACITY ? text.capacity() + 1 : 0;
+      }
+    }
+    usage.viewBytes  = (m_vView.capacity() + m_vAppendedSlots.capacity()) * sizeof(size_t);
+    usage.indexBytes = m_mapSlots.size() * (sizeof(std::pair<size_t, size_t>) + HASH_NODE_OVERHEAD)
+                     + m_mapSlots.bucket_count() * sizeof(void*)
+                     + m_textIndex.GetBytes()
+                     + m_quickSearchSlots.RangeCount() * (2 * sizeof(size_t) + TREE_NODE_OVERHEAD);
+    for (size_t col = 0; col < m_vColumns.size(); ++col)
+    {
+      usage.statsBytes += m_vHasStats[col] ? m_vStats[col].GetBytes() : 0;
+      usage.statsBytes += m_vHasWidthStats[col] ? m_vWidthStats[col].GetBytes() : 0;
+    }
+    return usage;
+  }
+protected:
+  static bool IsStringType(ColumnType type)
+  {
+    return type == ColumnType::STRING || type == ColumnType::WSTRING;
+  }
+  // Call func with the member of CellValue holding a numeric type, false
+  // for string types. func is instantiated once per type, so the loops it
+  // runs read the cells without switching on their type.
+  template <typename F>
+  static bool VisitNumeric(ColumnType type, F&& func)
+  {
+    switch (type)
+    {
+    case ColumnType::INT32:  func(&CellValue::i32); return true;
+    case ColumnType::INT64:  func(&CellValue::i64); return true;
+    case ColumnType::UINT32: func(&CellValue::u32); return true;
+    case ColumnType::UINT64: func(&CellValue::u64); return true;
+    case ColumnType::FLOAT:  func(&CellValue::f  ); return true;
+    case ColumnType::DOUBLE: func(&CellValue::d  ); return true;
+    default:                 return false;
+    }
+  }
+  size_t FindSlot(size_t id) const
+  {
+    if (m_bDenseIds)
+      return id < m_vIds.size() ? id : NPOS;
+
+    auto it = m_mapSlots.find(id);
+    return it != m_mapSlots.end() ? it->second : NPOS;
+  }
+  // Slot of a row ID, a new one holding default cells if not present
+  size_t AcquireSlot(size_t id, bool& inserted)
+  {
+    size_t slot = FindSlot(id);
+    inserted    = slot == NPOS;
+    if (!inserted)
+      return slot;
+
+    slot = m_vIds.size();
+    if (m_bDenseIds && id != slot)
+    {
+      // IDs no longer follow the slots, index them from now on
+      m_bDenseIds = false;
+      m_mapSlots.reserve(slot + 1);
+      for (size_t i = 0; i < slot; ++i)
+      {
+        m_mapSlots.emplace(i, i);
+      }
+    }
+    if (!m_bDenseIds)
+    {
+      m_mapSlots.emplace(id, slot);
+    }
+    m_bIdOrdered = m_bIdOrdered && (m_vIds.empty() || id > m_vIds.back());
+    m_vIds.push_back(id);
+    m_vRowVersions.push_back(0);
+    for (Column& column : m_vColumns)
+    {
+      if (IsStringType(column.info.type))
+      {
+        column.texts.emplace_back();
+      }
+      else
+      {
+        column.values.push_back(ColumnData<C>().value);
+      }
+    }
+    return slot;
+  }
+  // Write one cell, converting it to the column type
+  static void StoreCell(Column& column, size_t slot, const ColumnData<C>* cell)
+  {
+    ColumnType type = column.info.type;
+    if (IsStringType(type))
+    {
+      std::string& text = column.texts[slot];
+      double       number = 0.0;
+      if (!cell)
+      {
+        text.clear();
+      }
+      else if (cell->IsString())
+      {
+        text = cell->str;
+      }
+      else if (cell->ToNumber(number))
+      {
+        char buffer[32];
+        text.assign(buffer, snprintf(buffer, sizeof(buffer), "%g", number));
+      }
+      return;
+    }
+
+    CellValue& value = column.values[slot];
+    double     number = 0.0;
+    if (!cell)
+    {
+      value = ColumnData<C>().value;
+    }
+    else if (cell->type == type)
+    {
+      value = cell->value;
+    }
+    else if (cell->IsString())
+    {
+      value = ColumnData<C>::FromText(type, cell->str, column.info.format).value;
+    }
+    else if (cell->ToNumber(number))
+    {
+      VisitNumeric(type, [&](auto member)
+      {
+        using T = typename std::remove_reference<decltype(value.*member)>::type;
+        value.*member = static_cast<T>(number);
+      });
+    }
+  }
+  // Take the cells of an updated slot out of the statistics and the text
+  // index before they are overwritten, and keep its sort key
+  void BeginWrite(size_t slot, bool inserted)
+  {
+    m_bHasOldSortKey = false;
+    if (inserted)
+      return;
+
+    CountCells(slot, false);
+    CollectTexts(slot, m_vOldTexts);
+    if (m_bViewValid && m_nSortCol != NPOS && !m_bSortOrderStale)
+    {
+      m_oldSortKey     = CellAt(slot, m_nSortCol);
+      m_bHasOldSortKey = true;
+    }
+  }
+  // Record a written row: count its cells, index its texts and bring the
+  // view along
+  void Touch(size_t id, size_t slot, bool inserted)
+  {
+    m_vRowVersions[slot] = ++m_nVersion;
+    if (m_nTransactionDepth > 0)
+    {
+      m_vDirtyIds.push_back(id);
+    }
+    CountCells(slot, true);
+    if (CollectTexts(slot, m_vTexts))
+    {
+      // An updated row only moves between the postings of changed windows
+      if (inserted)
+      {
+        m_textIndex.Insert(slot, m_vTexts);
+      }
+      else
+      {
+        m_textIndex.Update(slot, m_vOldTexts, m_vTexts);
+      }
+    }
+    if (!m_strQuickSearch.empty())
+    {
+      if (MatchesQuickSearch(slot))
+      {
+        m_quickSearchSlots.Insert(slot);
+      }
+      else
+      {
+        m_quickSearchSlots.Erase(slot);
+      }
+    }
+    if (!m_bViewValid)
+      return;
+
+    if (inserted)
+    {
+      // Merged into the view on its next read
+      m_vAppendedSlots.push_back(slot);
+    }
+    else if (HasActiveFilters())
+    {
+      m_bViewValid = false;
+    }
+    else if (m_bHasOldSortKey
+      && ColumnDataCompare<C>::Compare(m_oldSortKey, CellAt(slot, m_nSortCol)) != 0)
+    {
+      // The row keeps its position, later merges cannot search the view
+      m_bSortOrderStale = true;
+    }
+  }
+  // Count the cells of a slot in the statistics kept, or take them back
+  // before they are overwritten
+  void CountCells(size_t slot, bool add)
+  {
+    for (size_t col = 0; col < m_vColumns.size(); ++col)
+    {
+      if (m_vHasStats[col] && add)
+      {
+        m_vStats[col].Add(CellAt(slot, col));
+      }
+      else if (m_vHasStats[col])
+      {
+        m_vStats[col].Remove(CellAt(slot, col));
+      }
+      if (m_vHasWidthStats[col] && add)
+      {
+        m_vWidthStats[col].Add(FormatAt(slot, col));
+      }
+      else if (m_vHasWidthStats[col])
+      {
+        m_vWidthStats[col].Remove(FormatAt(slot, col));
+      }
+    }
+  }
+  // Count the formatted value of every row of a column
+  void RebuildWidthStats(size_t col) const
+  {
+    for (size_t slot = 0; slot < m_vIds.size(); ++slot)
+    {
+      m_vWidthStats[col].Add(FormatAt(slot, col));
+    }
+  }
+  // Get the folded text of the text-indexed columns of a slot, false if no
+  // column is text-indexed
+  bool CollectTexts(size_t slot, std::vector<std::string>& texts) const
+  {
+    texts.clear();
+    for (size_t col = 0; col < m_vColumns.size(); ++col)
+    {
+      if (m_vTextIndexed[col])
+      {
+        texts.push_back(TrigramIndex::Fold(FormatAt(slot, col)));
+      }
+    }
+    return !texts.empty();
+  }
+  // Check if the quick search text is in a searched column of a slot
+  bool MatchesQuickSearch(size_t slot) const
+  {
+    bool anyIndexed = std::find(m_vTextIndexed.begin(),
+      m_vTextIndexed.end(), true) != m_vTextIndexed.end();
+    for (size_t col = 0; col < m_vColumns.size(); ++col)
+    {
+      if ((!anyIndexed || m_vTextIndexed[col])
+        && TrigramIndex::Fold(FormatAt(slot, col)).find(m_strQuickSearch) != std::string::npos)
+        return true;
+    }
+    return false;
+  }
+  ColumnData<C> CellAt(size_t slot, size_t col) const
+  {
+    const Column& column = m_vColumns[col];
+    ColumnData<C> cell;
+    cell.type       = column.info.type;
+    cell.columnInfo = &column.info;
+    if (IsStringType(cell.type))
+    {
+      cell.str   = column.texts[slot];
+    }
+    else
+    {
+      cell.value = column.values[slot];
+    }
+    return cell;
+  }
+  std::string FormatAt(size_t slot, size_t col) const
+  {
+    const Column& column = m_vColumns[col];
+    return IsStringType(column.info.type) ? column.texts[slot] : CellAt(slot, col).FormatValue();
+  }
+  const std::vector<size_t>& ViewSlots() const
+  {
+    if (!m_bViewValid)
+    {
+      BuildView();
+    }
+    else if (!m_vAppendedSlots.empty())
+    {
+      MergeAppendedSlots();
+    }
+    return m_vView;
+  }
+  // Filter and sort every slot into the view
+  void BuildView() const
+  {
+    if (!m_strQuickSearch.empty())
+    {
+      // Only the quick search matches can pass
+      m_vView = m_quickSearchSlots.ToVector();
+    }
+    else
+    {
+      m_vView.resize(m_vIds.size());
+      for (size_t slot = 0; slot < m_vView.size(); ++slot)
+      {
+        m_vView[slot] = slot;
+      }
+    }
+    if (!m_bIdOrdered)
+    {
+      std::sort(m_vView.begin(), m_vView.end(),
+        [this](size_t a, size_t b) { return m_vIds[a] < m_vIds[b]; });
+    }
+    FilterSlots(m_vView);
+    if (m_nSortCol != NPOS)
+    {
+      SortSlots(m_vView, m_vColumns[m_nSortCol], m_bSortAscending);
+    }
+    m_vAppendedSlots.clear();
+    m_bSortOrderStale = false;
+    m_bViewValid = true;
+  }
+  // Merge the inserted slots that pass the filters into the view, each
+  // placed by binary search with the rows in between moved as a block
+  void MergeAppendedSlots() const
+  {
+    if (m_nSortCol != NPOS && m_bSortOrderStale)
+    {
+      // Updated rows sit out of order, no place can be searched for
+      BuildView();
+      return;
+    }
+
+    std::vector<size_t>& appended = m_vAppendedSlots;
+    FilterSlots(appended);
+    if (m_nSortCol == NPOS && m_bIdOrdered)
+    {
+      // Appended after every row: the view grows in place
+      m_vView.insert(m_vView.end(), appended.begin(), appended.end());
+      appended.clear();
+      return;
+    }
+
+    WithSlotOrder([&](auto before)
+    {
+      std::sort(appended.begin(), appended.end(), before);
+      size_t read  = m_vView.size();
+      size_t end   = read + appended.size();
+      size_t count = appended.size();
+      m_vView.resize(end);
+      while (count > 0)
+      {
+        size_t slot  = appended[--count];
+        size_t place = std::lower_bound(m_vView.begin(),
+          m_vView.begin() + read, slot, before) - m_vView.begin();
+        std::move_backward(m_vView.begin() + place, m_vView.begin() + read,
+          m_vView.begin() + end);
+        end  -= read - place;
+        read  = place;
+        m_vView[--end] = slot;
+      }
+    });
+    appended.clear();
+  }
+  // Call func with the strict order of slots in the view: by the sort
+  // column, switched on its type once (see VisitNumeric), with ties in ID
+  // order as the stable sort leaves them; by ID when not sorted
+  template <typename F>
+  void WithSlotOrder(F func) const
+  {
+    const size_t* ids = m_vIds.data();
+    if (m_nSortCol == NPOS)
+    {
+      func([ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+      return;
+    }
+
+    const Column& column    = m_vColumns[m_nSortCol];
+    bool          ascending = m_bSortAscending;
+    bool numeric = VisitNumeric(column.info.type, [&](auto member)
+    {
+      const CellValue* values = column.values.data();
+      func([values, member, ids, ascending](size_t a, size_t b)
+      {
+        auto x = values[a].*member;
+        auto y = values[b].*member;
+        if (x < y || y < x)
+          return ascending ? x < y : y < x;
+        return ids[a] < ids[b];
+      });
+    });
+    if (numeric)
+      return;
+
+    const std::string* texts = column.texts.data();
+    func([texts, ids, ascending](size_t a, size_t b)
+    {
+      int result = texts[a].compare(texts[b]);
+      if (result == 0)
+        return ids[a] < ids[b];
+      return ascending ? result < 0 : result > 0;
+    });
+  }
+  // Drop the slots failing a filter, one column at a time
+  void FilterSlots(std::vector<size_t>& slots) const
+  {
+    for (size_t col = 0; col < m_vColumns.size() && !slots.empty(); ++col)
+    {
+      const Column&      column = m_vColumns[col];
+      const RangeFilter& range  = column.range;
+      if (range.active)
+      {
+        FilterRange(slots, column);
+      }
+      if (column.info.filter)
+      {
+        slots.erase(std::remove_if(slots.begin(), slots.end(), [&](size_t slot)
+        {
+          ColumnData<C> cell = CellAt(slot, col);
+          return !column.info.filter(&cell);
+        }), slots.end());
+      }
+    }
+    if (!m_strQuickSearch.empty() && !slots.empty())
+    {
+      slots.erase(std::remove_if(slots.begin(), slots.end(), [&](size_t slot)
+      {
+        return !m_quickSearchSlots.Contains(slot);
+      }), slots.end());
+    }
+  }
+  // Range filter kernel of one column
+  static void FilterRange(std::vector<size_t>& slots, const Column& column)
+  {
+    const RangeFilter& range = column.range;
+    bool numeric = VisitNumeric(column.info.type, [&](auto member)
+    {
+      const CellValue* values = column.values.data();
+      auto lower = range.lower.value.*member;
+      auto upper = range.upper.value.*member;
+      slots.erase(std::remove_if(slots.begin(), slots.end(), [&](size_t slot)
+      {
+        auto value = values[slot].*member;
+        return (range.hasLower && value < lower)
+            || (range.hasUpper && (range.upperOpen ? !(value < upper) : upper < value));
+      }), slots.end());
+    });
+    if (numeric)
+      return;
+
+    const std::string* texts = column.texts.data();
+    slots.erase(std::remove_if(slots.begin(), slots.end(), [&](size_t slot)
+    {
+      return (range.hasLower && texts[slot].compare(range.lower.str) < 0)
+          || (range.hasUpper && (range.upperOpen ? texts[slot].compare(range.upper.str) >= 0
+                                                 : texts[slot].compare(range.upper.str) >  0));
+    }), slots.end());
+  }
+  // Sort kernel of one column; stable, so ties keep their order
+  static void SortSlots(std::vector<size_t>& slots, const Column& column, bool ascending)
+  {
+    bool numeric = VisitNumeric(column.info.type, [&](auto member)
+    {
+      const CellValue* values = column.values.data();
+      if (ascending)
+      {
+        std::stable_sort(slots.begin(), slots.end(), [values, member](size_t a, size_t b)
+        {
+          return values[a].*member < values[b].*member;
+        });
+      }
+      else
+      {
+        std::stable_sort(slots.begin(), slots.end(), [values, member](size_t a, size_t b)
+        {
+          return values[b].*member < values[a].*member;
+        });
+      }
+    });
+    if (numeric)
+      return;
+
+    const std::string* texts = column.texts.data();
+    std::stable_sort(slots.begin(), slots.end(), [texts, ascending](size_t a, size_t b)
+    {
+      int result = texts[a].compare(texts[b]);
+      return ascending ? result < 0 : result > 0;
+    });
+  }
+};
+
+/*****************************************************************************
+ *
+ * FUNCTION: LoadCsvDynTableEx
+ * PURPOSE : Load a CSV file with a header line into a DynTableEx
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: The header names the columns. A first pass picks each column's
+ *           type from all of its non-empty fields: INT64 if every one is an
+ *           integer, DOUBLE if every one is a number, STRING otherwise. The
+ *           second pass loads the rows, IDs are line numbers (header
+ *           excluded). Every column gets extraInfo, and with textIndex is
+ *           indexed for quick search as the rows are loaded.
+ *
+ *****************************************************************************/
+
+template <typename C>
+bool LoadCsvDynTableEx(const std::string& filename,
+                       DynTableEx<C>&     table,
+                       const C&           extraInfo = C(),
+                       bool               textIndex = false)
+{
+  using ColumnType = typename ColumnInfo<C>::ColumnType;
+
+  std::ifstream file(filename, std::ios::binary);
+  std::string   line;
+  if (!file.is_open() || !std::getline(file, line))
+    return false;
+
+  std::vector<std::string> names;
+  SplitCsvLine(line, names);
+  std::vector<ColumnType>  types(names.size(), ColumnType::INT64);
+  std::vector<bool>        seen (names.size(), false);
+  std::vector<std::string> fields;
+  while (std::getline(file, line))
+  {
+    SplitCsvLine(line, fields);
+    for (size_t col = 0; col < fields.size() && col < names.size(); ++col)
+    {
+      const std::string& field = fields[col];
+      if (field.empty() || types[col] == ColumnType::STRING)
+        continue;
+
+      seen[col]  = true;
+      char* end  = nullptr;
+      errno      = 0;
+      if (types[col] == ColumnType::INT64)
+      {
+        strtoll(field.c_str(), &end, 10);
+        if (*end == '\0' && errno == 0)
+          continue;
+        types[col] = ColumnType::DOUBLE;
+      }
+      strtod(field.c_str(), &end);
+      if (*end != '\0')
+      {
+        types[col] = ColumnType::STRING;
+      }
+    }
+  }
+
+  std::vector<ColumnInfo<C>> columns(names.size());
+  for (size_t col = 0; col < names.size(); ++col)
+  {
+    ColumnType type = seen[col] ? types[col] : ColumnType::STRING;
+    columns[col] = { type,
+      type == ColumnType::INT64 ? "%" PRId64 : type == ColumnType::DOUBLE ? "%g" : "%s",
+      nullptr, extraInfo, names[col] };
+  }
+  table.SetColumns(columns);
+  for (size_t col = 0; textIndex && col < columns.size(); ++col)
+  {
+    table.EnableTextIndex(col);
+  }
+
+  file.clear();
+  file.seekg(0, std::ios::beg);
+  std::getline(file, line);
+  for (size_t id = 0; std::getline(file, line); ++id)
+  {
+    SplitCsvLine(line, fields);
+    table.UpsertRowText(id, fields);
+  }
+  return true;
+}
+
+#endif // GUI_WXWIDGETS_MAIN_APP_DYN_TABLE_EX_H_
@@ -0,0 +1,549 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_DYN_TABLE_EX_ADAPTER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_DYN_TABLE_EX_ADAPTER_H_
+
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+/*****************************************************************************
+ *
+ * CLASS   : DynTableExAdapter
+ * PURPOSE : Adapter showing a DynTableEx<C>, whatever its columns
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Virtual lists draw through GetItemText from the table view,
+ *           with the texts of recently drawn rows cached as in
+ *           TableExAdapter. Report lists are diffed by the row version the
+ *           table stamps on every write, so no snapshot of the rows is
+ *           kept: an item is rewritten only if it shows another row or its
+ *           row changed since it was written.
+ *
+ *****************************************************************************/
+
+template <typename C>
+class DynTableExAdapter : public ITableExAdapter
+{
+public:
+  DynTableEx<C>     *table;                 // DynTableEx object actually used
+protected:
+  // List item -> row ID, and the row version each item shows
+  mutable std::vector<size_t>              m_vItemIds;
+  std::vector<uint64_t>                    m_vItemVersions;
+  // Row ID -> list item
+  mutable std::unordered_map<size_t, long> m_mapItemIndex;
+  // Indicates the list is virtual (items are drawn through GetItemText)
+  bool                                     m_bVirtual      = false;
+  // Indicates m_vItemIds matches the current view, always true unless virtual
+  mutable bool                             m_bItemIdsValid = true;
+  // Converted cell texts of recently drawn rows, keyed by row ID
+  mutable std::unordered_map<size_t, std::vector<wxString>> m_mapCellCache;
+  // Rows kept in m_mapCellCache before it is dropped (a few screens)
+  static const size_t                      CELL_CACHE_ROWS = 1024;
+public:
+
+  // Constructor
+  explicit DynTableExAdapter(DynTableEx<C> *t)
+    : table(t)
+  {
+  }
+
+  // Export data to CSV file
+  void ExportToCSV(const std::string& filename) override
+  {
+    if (!table)
+      return;
+
+    std::ofstream file(filename);
+    if (!file.is_open())
+      return;
+
+    std::string out;
+    for (size_t col = 0; col < table->GetColumnCount(); ++col)
+    {
+      if (col > 0)
+      {
+        out += ',';
+      }
+      AppendDelimitedCell(out, table->GetColumnInfo(col).name, ',');
+    }
+    out += '\n';
+    std::vector<size_t> ids;
+    ids.reserve(table->size());
+    table->ForEachViewId([&ids](size_t id) { ids.push_back(id); });
+    WriteRows(out, ids, ',');
+    file << out;
+  }
+  // Append the rows with the given IDs as CSV (',') or TSV ('\t') lines,
+  // skipping IDs no longer in the table
+  void WriteRows(std::string&               out,
+                 const std::vector<size_t>& ids,
+                 char                       separator) const override
+  {
+    if (!table)
+      return;
+
+    std::vector<std::string> texts;
+    for (size_t id : ids)
+    {
+      if (!table->FormatRow(id, texts))
+        continue;
+
+      for (size_t col = 0; col < texts.size(); ++col)
+      {
+        if (col > 0)
+        {
+          out += separator;
+        }
+        AppendDelimitedCell(out, texts[col], separator);
+      }
+      out += '\n';
+    }
+  }
+  // Set filter function for a specific column
+  void SetFilter(size_t col, std::function<bool(const void*)> filter) override
+  {
+    if (table)
+      table->SetFilter(col, filter);
+  }
+  // Set an inclusive range filter from text, an empty bound is open;
+  // upperOpen leaves the upper bound itself out
+  void SetRangeFilter(size_t             col,
+                      const std::string& lower,
+                      const std::string& upper,
+                      bool               upperOpen = false) override
+  {
+    if (!table || col >= table->GetColumnCount())
+      return;
+
+    const ColumnInfo<C>& info = table->GetColumnInfo(col);
+    ColumnData<C> lowerValue  = ColumnData<C>::FromText(info.type, lower, info.format);
+    ColumnData<C> upperValue  = ColumnData<C>::FromText(info.type, upper, info.format);
+    table->SetRangeFilter(col,
+      lower.empty() ? nullptr : &lowerValue,
+      upper.empty() ? nullptr : &upperValue,
+      upperOpen);
+  }
+  // Keep the rows whose cell, as displayed, is one of values, or with
+  // exclude those whose cell is none of them
+  void SetValueFilter(size_t                       col,
+                      const std::vector<wxString>& values,
+                      bool                         exclude = false) override
+  {
+    if (!table || col >= table->GetColumnCount())
+      return;
+
+    auto texts = std::make_shared<std::unordered_set<std::string>>();
+    for (const wxString& value : values)
+    {
+      texts->insert(value.utf8_string());
+    }
+    table->SetFilter(col, [texts, exclude](const void* cell)
+    {
+      return (texts->count(static_cast<const ColumnData<C>*>(cell)->FormatValue()) > 0) != exclude;
+    });
+  }
+  // Clear filter for a specific column or all columns if col is out of range
+  void ClearFilter(size_t col = -1) override
+  {
+    if (table)
+      table->ClearFilter(col);
+  }
+  // Only show rows containing text, empty text shows all
+  void SetQuickSearch(const wxString& text) override
+  {
+    if (table)
+      table->SetQuickSearch(text.utf8_string());
+  }
+  // Summarize a column from its value statistics. The first call for a
+  // column enables them, counting the rows once; after that the table keeps
+  // them up to date.
+  bool GetColumnSummary(size_t col, ColumnSummary& summary) override
+  {
+    if (!table || col >= table->GetColumnCount())
+      return false;
+
+    table->EnableColumnStats(col);
+    const ColumnStats<C>& stats = table->GetColumnStats(col);
+    summary = ColumnSummary();
+    summary.rows     = stats.GetValueCount();
+    summary.distinct = stats.GetDistinctCount();
+    summary.exact    = stats.IsExact();
+    summary.values.reserve(stats.GetValues().size());
+    for (const auto& pair : stats.GetValues())
+    {
+      // Stored values may outlive the column info they were linked to
+      ColumnData<C> value = pair.first;
+      value.columnInfo    = &table->GetColumnInfo(col);
+      summary.values.push_back({ wxString(value.FormatValueW()), pair.second });
+    }
+    for (const auto& bin : stats.GetHistogram())
+    {
+      summary.histogram.push_back({ bin.lower, bin.upper, bin.count });
+    }
+    return true;
+  }
+  // Sample the longest values of a column. The first call for a column
+  // enables its width statistics, measuring the rows once; after that the
+  // table keeps them up to date.
+  bool GetColumnWidthSample(size_t col, ColumnWidthSample& sample) override
+  {
+    if (!table || col >= table->GetColumnCount())
+      return false;
+
+    table->EnableWidthStats(col);
+    const TextWidthStats& stats = table->GetWidthStats(col);
+    sample           = ColumnWidthSample();
+    sample.maxLength = stats.GetMaxLength();
+    sample.version   = stats.GetVersion();
+    for (const TextWidthStats::Value& value : stats.GetWidest())
+    {
+      sample.widest.push_back(wxString::FromUTF8(value.text.data(), value.text.size()));
+    }
+    return true;
+  }
+  // Sort rows by a specific column. Typed sorts are fast enough to order
+  // the whole view at once, so lazyWindow is not needed.
+  void SortByColumn(size_t col, bool ascending = true, size_t = 0) override
+  {
+    if (table)
+      table->SortByColumn(col, ascending);
+  }
+  // Sorting is never left unfinished
+  bool RefineSort() override
+  {
+    return false;
+  }
+  // Get the text of a cell, used by virtual lists
+  wxString GetItemText(long item, long col) const override
+  {
+    size_t id = 0;
+    if (!table || col < 0 || static_cast<size_t>(col) >= table->GetColumnCount()
+      || !GetRowId(item, id))
+      return wxString();
+
+    // Repaints reuse the texts converted the first time the row was drawn
+    auto cached = m_mapCellCache.find(id);
+    if (cached != m_mapCellCache.end())
+      return cached->second[col];
+
+    if (!table->Contains(id))
+      return wxString();
+
+    if (m_mapCellCache.size() >= CELL_CACHE_ROWS)
+    {
+      m_mapCellCache.clear();
+    }
+    std::vector<wxString>& texts = m_mapCellCache[id];
+    texts.resize(table->GetColumnCount());
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+      texts[i] = table->GetCell(id, i).FormatValueW();
+    }
+    return texts[col];
+  }
+  // The view is ordered whole, nothing to prepare
+  void PrepareItems(long, long) override
+  {
+  }
+  // Get the row ID displayed by a list item
+  bool GetRowId(long item, size_t& id) const override
+  {
+    if (!m_bItemIdsValid)
+    {
+      id = (table && item >= 0) ? table->GetViewId(item) : DynTableEx<C>::NPOS;
+      return id != DynTableEx<C>::NPOS;
+    }
+    if (item < 0 || static_cast<size_t>(item) >= m_vItemIds.size())
+      return false;
+
+    id = m_vItemIds[item];
+    return true;
+  }
+  // Get the list item displaying a row ID
+  bool GetItemIndex(size_t id, long& item) const override
+  {
+    EnsureItemIds();
+    auto it = m_mapItemIndex.find(id);
+    if (it == m_mapItemIndex.end())
+      return false;
+
+    item = it->second;
+    return true;
+  }
+  // Get the row IDs of all list items in display order
+  const std::vector<size_t>& GetItemRowIds() const override
+  {
+    EnsureItemIds();
+    return m_vItemIds;
+  }
+  // Check if a row is shown, without finding its item
+  bool IsRowShown(size_t id) const override
+  {
+    if (m_bItemIdsValid)
+      return m_mapItemIndex.find(id) != m_mapItemIndex.end();
+
+    return table && table->PassesFilters(id);
+  }
+  // Get the IDs of all shown rows, in ID order
+  IdRangeSet GetShownRowIds() const override
+  {
+    std::vector<size_t> ids;
+    if (m_bItemIdsValid)
+    {
+      ids = m_vItemIds;
+    }
+    else if (table)
+    {
+      ids.reserve(table->size());
+      table->ForEachViewId([&ids](size_t id) { ids.push_back(id); });
+    }
+    std::sort(ids.begin(), ids.end());
+    return IdRangeSet::FromSorted(ids);
+  }
+  // Put shown row IDs in display order, dropping the others
+  void SortRowIds(std::vector<size_t>& ids) const override
+  {
+    EnsureItemIds();
+    std::vector<std::pair<long, size_t>> items;
+    for (size_t id : ids)
+    {
+      auto it = m_mapItemIndex.find(id);
+      if (it != m_mapItemIndex.end())
+      {
+        items.emplace_back(it->second, id);
+      }
+    }
+    std::sort(items.begin(), items.end());
+    ids.clear();
+    for (const auto& item : items)
+    {
+      ids.push_back(item.second);
+    }
+  }
+  // Start a batch of row updates on the table
+  void BeginTransaction() override
+  {
+    if (table)
+      table->BeginTransaction();
+  }
+  // Finish a batch of row updates, returns the IDs that were written
+  std::vector<size_t> CommitTransaction() override
+  {
+    return table ? table->CommitTransaction() : std::vector<size_t>();
+  }
+  // Report the memory of the table plus the item mapping
+  TableExMemoryUsage GetMemoryUsage() const override
+  {
+    TableExMemoryUsage usage;
+    if (table)
+    {
+      usage = table->GetMemoryUsage();
+    }
+    usage.viewBytes += m_vItemIds.capacity() * sizeof(size_t)
+                     + m_vItemVersions.capacity() * sizeof(uint64_t);
+    return usage;
+  }
+  // Full Refresh: Clear all data and reload
+  void FullRefreshList(wxListView* listView) override
+  {
+    if (!table || !listView)
+      return;
+
+    listView->Freeze();
+    listView->ClearAll();
+
+    // Add columns
+    for (size_t col = 0; col < table->GetColumnCount(); ++col)
+    {
+      listView->InsertColumn(
+        col,
+        table->GetColumnInfo(col).name,
+        table->GetColumnInfo(col).extraInfo.format,
+        table->GetColumnInfo(col).extraInfo.width);
+    }
+
+    m_bVirtual = listView->IsVirtual();
+    if (m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      listView->Thaw();
+      return;
+    }
+
+    m_bItemIdsValid = true;
+    m_vItemIds.clear();
+    m_vItemVersions.clear();
+    table->ForEachViewId([&](size_t id)
+    {
+      InsertItem(listView, id);
+    });
+    RebuildItemIndex();
+    listView->Thaw();
+  }
+  // Partial Refresh: Only rewrite items whose row changed
+  void PartialRefreshList(wxListView* listView) override
+  {
+    if (!table || !listView)
+      return;
+
+    if (m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      return;
+    }
+
+    listView->Freeze();
+    size_t oldSize = m_vItemIds.size();
+    size_t item    = 0;
+    table->ForEachViewId([&](size_t id)
+    {
+      if (item >= oldSize)
+      {
+        InsertItem(listView, id);
+      }
+      else if (m_vItemIds[item] != id || m_vItemVersions[item] != table->GetRowVersion(id))
+      {
+        WriteItem(listView, static_cast<long>(item), id);
+      }
+      ++item;
+    });
+    // Delete the items past the new view
+    for (size_t extra = item; extra < oldSize; ++extra)
+    {
+      listView->DeleteItem(static_cast<long>(item));
+    }
+    m_vItemIds     .resize(item);
+    m_vItemVersions.resize(item);
+    RebuildItemIndex();
+    listView->Thaw();
+  }
+  // Targeted Refresh: Only rewrite the items showing the given row IDs
+  void RefreshRows(wxListView* listView, const std::vector<size_t>& ids) override
+  {
+    if (!table || !listView || ids.empty())
+      return;
+
+    if (m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      return;
+    }
+
+    // Rows that appear, disappear or are new change the item layout,
+    // which only a partial refresh can handle
+    for (size_t id : ids)
+    {
+      bool shown = m_mapItemIndex.find(id) != m_mapItemIndex.end();
+      if (shown != table->PassesFilters(id))
+      {
+        PartialRefreshList(listView);
+        return;
+      }
+    }
+
+    listView->Freeze();
+    for (size_t id : ids)
+    {
+      auto it = m_mapItemIndex.find(id);
+      if (it != m_mapItemIndex.end())
+      {
+        WriteItem(listView, it->second, id);
+      }
+    }
+    listView->Thaw();
+  }
+  // Append Refresh: Add items for new rows whose IDs follow every shown
+  // row, without diffing the rest. Virtual lists only update their item
+  // count; a sorted view needs a partial refresh to place the rows.
+  void AppendRows(wxListView* listView, const std::vector<size_t>& ids) override
+  {
+    if (!table || !listView || ids.empty())
+      return;
+
+    if (m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      return;
+    }
+    if (table->IsSorted() || (!m_vItemIds.empty() && ids.front() <= m_vItemIds.back()))
+    {
+      PartialRefreshList(listView);
+      return;
+    }
+
+    listView->Freeze();
+    for (size_t id : ids)
+    {
+      if (!table->PassesFilters(id))
+        continue;
+
+      m_mapItemIndex[id] = static_cast<long>(m_vItemIds.size());
+      InsertItem(listView, id);
+    }
+    listView->Thaw();
+  }
+protected:
+  // Add an item for a row at the end of a report list
+  void InsertItem(wxListView* listView, size_t id)
+  {
+    long item = listView->InsertItem(static_cast<long>(m_vItemIds.size()), wxString());
+    m_vItemIds     .push_back(id);
+    m_vItemVersions.push_back(0);
+    WriteItem(listView, item, id);
+  }
+  // Write the cells of a row into an item and remember what it shows
+  void WriteItem(wxListView* listView, long item, size_t id)
+  {
+    for (size_t col = 0; col < table->GetColumnCount(); ++col)
+    {
+      listView->SetItem(item, col, table->GetCell(id, col).FormatValueW());
+    }
+    m_vItemIds     [item] = id;
+    m_vItemVersions[item] = table->GetRowVersion(id);
+  }
+  // Virtual Refresh: Update the item count and redraw the visible items
+  void RefreshVirtualList(wxListView* listView)
+  {
+    m_mapCellCache.clear();
+    m_bItemIdsValid = false;
+    m_vItemIds.clear();
+    m_mapItemIndex.clear();
+
+    listView->SetItemCount(static_cast<long>(table->size()));
+    listView->Refresh();
+  }
+  // Build the item <-> row ID mapping of a virtual list on first use
+  void EnsureItemIds() const
+  {
+    if (m_bItemIdsValid || !table)
+      return;
+
+    m_vItemIds.clear();
+    m_vItemIds.reserve(table->size());
+    table->ForEachViewId([this](size_t id) { m_vItemIds.push_back(id); });
+    RebuildItemIndex();
+    m_bItemIdsValid = true;
+  }
+  // Rebuild the row ID -> list item lookup from m_vItemIds
+  void RebuildItemIndex() const
+  {
+    m_mapItemIndex.clear();
+    m_mapItemIndex.reserve(m_vItemIds.size());
+    for (size_t item = 0; item < m_vItemIds.size(); ++item)
+    {
+      m_mapItemIndex[m_vItemIds[item]] = static_cast<long>(item);
+    }
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_DYN_TABLE_EX_ADAPTER_H_
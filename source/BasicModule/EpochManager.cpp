@@ -0,0 +1,90 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include "EpochManager.h"
+
+EpochManager::EpochManager()
+  : m_nEpoch(1)
+{
+  for (Slot& slot : m_arrSlots)
+  {
+    slot.epoch.store(0);
+  }
+}
+
+EpochManager::~EpochManager()
+{
+  for (const Retired& retired : m_vRetired)
+  {
+    retired.deleter(retired.object);
+  }
+}
+
+size_t EpochManager::Pin()
+{
+  // Start at a slot picked by thread, so readers rarely contend for one.
+  // An epoch read just before the writer advances it only makes us hold
+  // objects a little longer; the slot is set before the reader loads any
+  // shared pointer, so the writer either sees the slot or the reader sees
+  // the new pointer.
+  size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % MAX_READERS;
+  for (;;)
+  {
+    for (size_t i = 0; i < MAX_READERS; ++i)
+    {
+      size_t   slot  = (start + i) % MAX_READERS;
+      uint64_t free  = 0;
+      if (m_arrSlots[slot].epoch.load(std::memory_order_relaxed) == 0
+        && m_arrSlots[slot].epoch.compare_exchange_strong(free, m_nEpoch.load()))
+        return slot;
+    }
+    std::this_thread::yield();
+  }
+}
+
+void EpochManager::Unpin(size_t slot)
+{
+  m_arrSlots[slot].epoch.store(0, std::memory_order_release);
+}
+
+void EpochManager::Retire(void* object, void (*deleter)(void*))
+{
+  m_vRetired.push_back({ object, deleter, m_nEpoch.load() });
+}
+
+size_t EpochManager::Reclaim()
+{
+  // Readers pinning from now on can only see what is linked now
+  m_nEpoch.fetch_add(1);
+
+  uint64_t oldest = UINT64_MAX;
+  for (const Slot& slot : m_arrSlots)
+  {
+    uint64_t epoch = slot.epoch.load();
+    if (epoch != 0)
+    {
+      oldest = (std::min)(oldest, epoch);
+    }
+  }
+
+  // An object retired in epoch E may be held by readers pinned at E or
+  // before; retirement order is epoch order, so free a prefix
+  size_t count = 0;
+  while (count < m_vRetired.size() && m_vRetired[count].epoch < oldest)
+  {
+    m_vRetired[count].deleter(m_vRetired[count].object);
+    ++count;
+  }
+  m_vRetired.erase(m_vRetired.begin(), m_vRetired.begin() + count);
+  return count;
+}
@@ -0,0 +1,113 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_EPOCH_MANAGER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_EPOCH_MANAGER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+
+/*****************************************************************************
+ *
+ * CLASS   : EpochManager
+ * PURPOSE : Epoch-based reclamation of objects shared with lock-free readers
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: A reader pins the current epoch in one of MAX_READERS slots
+ *           (each on its own cache line) before loading a shared pointer,
+ *           and unpins when done; pinning and unpinning are one atomic
+ *           operation each and never wait for the writer. The writer
+ *           unlinks an object, then retires it; Reclaim frees the retired
+ *           objects no pinned reader can still see. A reader pinned for a
+ *           long time only delays freeing, never the writer.
+ *           Retire and Reclaim must be called from one thread (the writer).
+ *
+ *****************************************************************************/
+
+class EpochManager
+{
+public:
+  // Readers pinned at the same time; further readers wait for a free slot
+  static const size_t MAX_READERS = 64;
+
+  // Pins an epoch for the lifetime of the guard
+  class Guard
+  {
+  public:
+    explicit Guard(EpochManager& manager)
+      : m_pManager(&manager)
+      , m_nSlot   (manager.Pin())
+    {
+    }
+    Guard(Guard&& other)
+      : m_pManager(other.m_pManager)
+      , m_nSlot   (other.m_nSlot)
+    {
+      other.m_pManager = nullptr;
+    }
+    ~Guard()
+    {
+      if (m_pManager)
+      {
+        m_pManager->Unpin(m_nSlot);
+      }
+    }
+    Guard(const Guard&)            = delete;
+    Guard& operator=(const Guard&) = delete;
+    Guard& operator=(Guard&&)      = delete;
+  protected:
+    EpochManager          *m_pManager;
+    size_t                 m_nSlot;
+  };
+
+  EpochManager();
+  // Frees everything still retired; no reader may be pinned any more
+  ~EpochManager();
+  EpochManager(const EpochManager&)            = delete;
+  EpochManager& operator=(const EpochManager&) = delete;
+
+  // Pin the current epoch and return the slot to unpin
+  size_t   Pin            ();
+  // Release a slot returned by Pin
+  void     Unpin          (size_t slot);
+
+  // Hand over an object already unlinked from the shared structure;
+  // deleter frees it once no reader can hold it
+  void     Retire         (void* object, void (*deleter)(void*));
+  // Start a new epoch and free what the pinned readers can no longer see.
+  // Returns the number of objects freed.
+  size_t   Reclaim        ();
+
+  // Current epoch
+  uint64_t GetEpoch       () const { return m_nEpoch.load();   }
+  // Number of objects retired and not freed yet
+  size_t   GetRetiredCount() const { return m_vRetired.size(); }
+protected:
+  struct alignas(64) Slot
+  {
+    // Epoch pinned by the reader using the slot, 0 when free
+    std::atomic<uint64_t>  epoch;
+  };
+  struct Retired
+  {
+    void                  *object;
+    void                 (*deleter)(void*);
+    uint64_t               epoch;
+  };
+
+  // Current epoch, starts at 1 so that 0 marks a free slot
+  std::atomic<uint64_t>  m_nEpoch;
+  Slot                   m_arrSlots[MAX_READERS];
+  // Objects waiting for the readers, in retirement order (writer only)
+  std::vector<Retired>   m_vRetired;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_EPOCH_MANAGER_H_
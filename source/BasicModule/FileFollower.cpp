@@ -0,0 +1,285 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include "FileFollower.h"
+
+FileFollower::FileFollower()
+  : m_nOffset     (0)
+  , m_nHeaderLines(0)
+  , m_nSkipLines  (0)
+  , m_bPending    (false)
+  , m_bReset      (false)
+  , m_nFileVolume (0)
+  , m_nFileIndex  (0)
+  , m_nInotifyFd  (-1)
+  , m_nWatchFd    (-1)
+{
+}
+
+FileFollower::~FileFollower()
+{
+  Close();
+}
+
+bool FileFollower::Open(const std::string& path, bool fromEnd, size_t skipLines)
+{
+  Close();
+
+  uint64_t size = 0;
+  m_strPath = path;
+  if (!GetFileSize(size))
+  {
+    m_strPath.clear();
+    return false;
+  }
+
+  m_nOffset      = fromEnd ? size : 0;
+  m_nHeaderLines = skipLines;
+  m_nSkipLines   = fromEnd ? 0 : skipLines;
+  m_bPending     = true;
+  m_bReset       = false;
+  GetFileId(m_nFileVolume, m_nFileIndex);
+  Watch();
+  return true;
+}
+
+void FileFollower::Close()
+{
+#ifdef __linux__
+  if (m_nInotifyFd >= 0)
+  {
+    close(m_nInotifyFd);
+  }
+#endif
+  m_nInotifyFd   = -1;
+  m_nWatchFd     = -1;
+  m_strPath.clear();
+  m_strCarry.clear();
+  m_nOffset      = 0;
+  m_nHeaderLines = 0;
+  m_nSkipLines   = 0;
+  m_bPending     = false;
+  m_bReset       = false;
+  m_nFileVolume  = 0;
+  m_nFileIndex   = 0;
+}
+
+bool FileFollower::ReadLines(std::vector<std::string>& lines, size_t maxBytes)
+{
+  if (!IsOpen() || !HasChanged())
+    return false;
+
+  uint64_t size = 0;
+  if (!GetFileSize(size))
+  {
+    // Gone for now (e.g. being rotated), look again next time
+    m_bPending = true;
+    return false;
+  }
+  if (size < m_nOffset)
+  {
+    // Truncated or replaced by a shorter file
+    Rewind();
+  }
+  if (size == m_nOffset)
+  {
+    m_bPending = false;
+    return false;
+  }
+
+  std::ifstream file(m_strPath, std::ios::binary);
+  if (!file.is_open())
+  {
+    m_bPending = true;
+    return false;
+  }
+  size_t      want = static_cast<size_t>(std::min<uint64_t>(size - m_nOffset, maxBytes));
+  std::string buffer(want, '\0');
+  file.seekg(static_cast<std::streamoff>(m_nOffset));
+  file.read(&buffer[0], static_cast<std::streamsize>(want));
+  size_t got = static_cast<size_t>(file.gcount());
+  m_nOffset += got;
+
+  // Cut complete lines, the first one continues what was carried over
+  size_t start = 0;
+  for (;;)
+  {
+    const char* begin   = buffer.data() + start;
+    const char* newline = static_cast<const char*>(memchr(begin, '\n', got - start));
+    if (!newline)
+      break;
+
+    size_t end = static_cast<size_t>(newline - buffer.data());
+    m_strCarry.append(begin, end - start);
+    if (!m_strCarry.empty() && m_strCarry.back() == '\r')
+    {
+      m_strCarry.pop_back();
+    }
+    if (m_nSkipLines > 0)
+    {
+      --m_nSkipLines;
+    }
+    else
+    {
+      lines.push_back(std::move(m_strCarry));
+    }
+    m_strCarry.clear();
+    start = end + 1;
+  }
+  m_strCarry.append(buffer.data() + start, got - start);
+
+  m_bPending = m_nOffset < size;
+  return m_bPending;
+}
+
+bool FileFollower::TakeReset()
+{
+  bool reset = m_bReset;
+  m_bReset   = false;
+  return reset;
+}
+
+bool FileFollower::HasChanged()
+{
+  if (m_nInotifyFd < 0)
+  {
+    // Polling: a replacement may already be longer than what was read,
+    // so compare the identity as well as the size
+    uint64_t volume = 0;
+    uint64_t index  = 0;
+    if (GetFileId(volume, index)
+      && (volume != m_nFileVolume || index != m_nFileIndex))
+    {
+      m_nFileVolume = volume;
+      m_nFileIndex  = index;
+      Rewind();
+    }
+    uint64_t size = 0;
+    return !GetFileSize(size) || size != m_nOffset || m_bPending;
+  }
+
+#ifdef __linux__
+  // Drain the events; a moved or deleted file is watched again by path
+  bool changed  = m_bPending;
+  bool replaced = false;
+  alignas(inotify_event) char events[4096];
+  for (;;)
+  {
+    ssize_t length = read(m_nInotifyFd, events, sizeof(events));
+    if (length <= 0)
+      break;
+
+    changed = true;
+    for (ssize_t pos = 0; pos < length; )
+    {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>(events + pos);
+      if (event->wd == m_nWatchFd
+        && (event->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)))
+      {
+        replaced = true;
+      }
+      pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+    }
+  }
+  if (replaced)
+  {
+    // The new file is read from its start
+    Watch();
+    GetFileId(m_nFileVolume, m_nFileIndex);
+    Rewind();
+  }
+  return changed;
+#else
+  return true;
+#endif
+}
+
+void FileFollower::Watch()
+{
+#ifdef __linux__
+  if (m_nInotifyFd < 0)
+  {
+    m_nInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  }
+  if (m_nInotifyFd < 0)
+    return;
+
+  if (m_nWatchFd >= 0)
+  {
+    inotify_rm_watch(m_nInotifyFd, m_nWatchFd);
+  }
+  m_nWatchFd = inotify_add_watch(m_nInotifyFd, m_strPath.c_str(),
+    IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF);
+  if (m_nWatchFd < 0)
+  {
+    // Fall back to polling
+    close(m_nInotifyFd);
+    m_nInotifyFd = -1;
+  }
+#endif
+}
+
+void FileFollower::Rewind()
+{
+  m_nOffset    = 0;
+  m_nSkipLines = m_nHeaderLines;
+  m_strCarry.clear();
+  m_bReset     = true;
+}
+
+bool FileFollower::GetFileSize(uint64_t& size) const
+{
+  std::error_code error;
+  size = std::filesystem::file_size(m_strPath, error);
+  return !error;
+}
+
+bool FileFollower::GetFileId(uint64_t& volume, uint64_t& index) const
+{
+#ifdef _WIN32
+  // Share everything so the writer can still append, rename or delete
+  HANDLE file = CreateFileW(std::filesystem::path(m_strPath).c_str(), 0,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  BY_HANDLE_FILE_INFORMATION info;
+  BOOL ok = GetFileInformationByHandle(file, &info);
+  CloseHandle(file);
+  if (!ok)
+    return false;
+
+  volume = info.dwVolumeSerialNumber;
+  index  = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+  return true;
+#else
+  struct stat info;
+  if (stat(m_strPath.c_str(), &info) != 0)
+    return false;
+
+  volume = static_cast<uint64_t>(info.st_dev);
+  index  = static_cast<uint64_t>(info.st_ino);
+  return true;
+#endif
+}
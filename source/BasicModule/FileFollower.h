@@ -0,0 +1,101 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_FILE_FOLLOWER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_FILE_FOLLOWER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*****************************************************************************
+ *
+ * CLASS   : FileFollower
+ * PURPOSE : Read the lines other processes append to a file
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Only bytes after the last read position are read, so the cost
+ *           follows the appended data, not the file size. On Linux an
+ *           inotify watch tells whether the file changed at all; elsewhere
+ *           (or if inotify is unavailable) the file size and identity (inode
+ *           or file index) are polled. A line still being written is kept
+ *           until its newline arrives. A file that shrinks or is replaced is
+ *           read again from the start.
+ *           Not thread-safe; call ReadLines from one thread (e.g. a timer).
+ *
+ *****************************************************************************/
+
+class FileFollower
+{
+public:
+  // Bytes read by one ReadLines call unless told otherwise
+  static const size_t DEFAULT_READ_BYTES = 8 * 1024 * 1024;
+
+  FileFollower();
+  ~FileFollower();
+  FileFollower(const FileFollower&)            = delete;
+  FileFollower& operator=(const FileFollower&) = delete;
+
+  // Start following a file, fromEnd skips the content already there.
+  // skipLines drops that many leading lines (e.g. a CSV header).
+  bool     Open          (const std::string& path,
+                          bool               fromEnd   = false,
+                          size_t             skipLines = 0);
+  // Stop following
+  void     Close         ();
+  // Check if a file is being followed
+  bool     IsOpen        () const { return !m_strPath.empty(); }
+  // Check if changes are detected by inotify rather than polling
+  bool     IsUsingInotify() const { return m_nInotifyFd >= 0;   }
+  // Byte position up to which the file has been read
+  uint64_t GetOffset     () const { return m_nOffset;           }
+
+  // Append the complete lines written since the last call (at most
+  // maxBytes are read). Returns true if more data is already waiting.
+  bool     ReadLines     (std::vector<std::string>& lines,
+                          size_t                    maxBytes = DEFAULT_READ_BYTES);
+  // Check (once) whether the file was truncated or replaced, in which case
+  // the lines read next start over from the beginning of the file
+  bool     TakeReset     ();
+protected:
+  // Check for changes since the last read
+  bool     HasChanged    ();
+  // Set up the inotify watch, if available
+  void     Watch         ();
+  // Read the file again from its start
+  void     Rewind        ();
+  // Get the current file size, false if the file can not be read
+  bool     GetFileSize   (uint64_t& size) const;
+  // Get what tells this file from one replacing it under the same path
+  // (device and inode, or volume and file index), false if unknown
+  bool     GetFileId     (uint64_t& volume, uint64_t& index) const;
+protected:
+  // Path of the followed file, empty when closed
+  std::string            m_strPath;
+  // Bytes consumed so far (complete lines plus m_strCarry)
+  uint64_t               m_nOffset;
+  // Start of a line whose newline has not been written yet
+  std::string            m_strCarry;
+  // Leading lines to drop from the start of the file, and still to drop
+  size_t                 m_nHeaderLines;
+  size_t                 m_nSkipLines;
+  // Set when data is known to be waiting (partial read, just opened)
+  bool                   m_bPending;
+  // Set when the file was truncated or replaced
+  bool                   m_bReset;
+  // Identity of the file being read, see GetFileId
+  uint64_t               m_nFileVolume;
+  uint64_t               m_nFileIndex;
+  // inotify instance and watch, -1 when polling
+  int                    m_nInotifyFd;
+  int                    m_nWatchFd;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_FILE_FOLLOWER_H_
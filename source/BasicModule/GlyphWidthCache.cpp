@@ -0,0 +1,46 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <wx/wx.h>
+#include "GlyphWidthCache.h"
+
+GlyphWidthCache::GlyphWidthCache()
+{
+}
+
+int GlyphWidthCache::EstimateText(const wxWindow* window, const wxString& text)
+{
+  Widths&        widths = m_mapFonts[window->GetFont().GetNativeFontInfoDesc()];
+  const wchar_t* chars  = text.wc_str();
+  int            width  = 0;
+  for (size_t i = 0; chars[i] != 0; ++i)
+  {
+    auto found = widths.find(chars[i]);
+    if (found == widths.end())
+    {
+      found = widths.emplace(chars[i], MeasureText(window, wxString(chars + i, 1))).first;
+    }
+    width += found->second;
+  }
+  return width;
+}
+
+int GlyphWidthCache::MeasureText(const wxWindow* window, const wxString& text) const
+{
+  int width  = 0;
+  int height = 0;
+  window->GetTextExtent(text, &width, &height);
+  return width;
+}
+
+void GlyphWidthCache::Clear()
+{
+  m_mapFonts.clear();
+}
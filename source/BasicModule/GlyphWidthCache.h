@@ -0,0 +1,47 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_GLYPH_WIDTH_CACHE_H_
+#define   GUI_WXWIDGETS_MAIN_APP_GLYPH_WIDTH_CACHE_H_
+
+#include <map>
+#include <unordered_map>
+
+/*****************************************************************************
+ *
+ * CLASS   : GlyphWidthCache
+ * PURPOSE : Estimate text widths from cached per-character widths
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Each character is measured once per font (keyed by its native
+ *           description), after which estimating a text is a few table
+ *           lookups instead of a text extent call. Kerning is ignored, so
+ *           use MeasureText where the exact width matters.
+ *
+ *****************************************************************************/
+
+class GlyphWidthCache
+{
+public:
+  GlyphWidthCache();
+
+  // Estimated width in pixels of text drawn in the window's font
+  int  EstimateText(const wxWindow* window, const wxString& text);
+  // Exact width in pixels of text drawn in the window's font
+  int  MeasureText (const wxWindow* window, const wxString& text) const;
+  // Forget every font
+  void Clear       ();
+protected:
+  using Widths = std::unordered_map<wchar_t, int>;
+
+  // Widths by font description
+  std::map<wxString, Widths> m_mapFonts;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_GLYPH_WIDTH_CACHE_H_
@@ -0,0 +1,166 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include "IdRangeSet.h"
+
+IdRangeSet::IdRangeSet()
+  : m_nCount(0)
+{
+}
+
+IdRangeSet IdRangeSet::FromSorted(const std::vector<size_t>& ids)
+{
+  IdRangeSet result;
+  size_t i = 0;
+  while (i < ids.size())
+  {
+    size_t first = ids[i];
+    size_t last  = first;
+    // Extend the run while IDs are consecutive or repeated
+    while (++i < ids.size() && (ids[i] == last || ids[i] == last + 1))
+    {
+      last = ids[i];
+    }
+    result.m_mapRanges.emplace_hint(result.m_mapRanges.end(), first, last);
+    result.m_nCount += last - first + 1;
+  }
+  return result;
+}
+
+void IdRangeSet::Insert(size_t id)
+{
+  InsertRange(id, id);
+}
+
+void IdRangeSet::InsertRange(size_t first, size_t last)
+{
+  if (first > last)
+    return;
+
+  // Find the first range that could touch [first, last]
+  auto it = m_mapRanges.upper_bound(first);
+  if (it != m_mapRanges.begin())
+  {
+    auto prev = std::prev(it);
+    if (prev->second == static_cast<size_t>(-1) || prev->second + 1 >= first)
+    {
+      it = prev;
+    }
+  }
+
+  // Absorb every range that overlaps or is adjacent to [first, last]
+  while (it != m_mapRanges.end()
+    && (last == static_cast<size_t>(-1) || it->first <= last + 1))
+  {
+    if (it->first  < first) first = it->first;
+    if (it->second > last ) last  = it->second;
+    m_nCount -= it->second - it->first + 1;
+    it = m_mapRanges.erase(it);
+  }
+
+  m_mapRanges.emplace_hint(it, first, last);
+  m_nCount += last - first + 1;
+}
+
+void IdRangeSet::Erase(size_t id)
+{
+  EraseRange(id, id);
+}
+
+void IdRangeSet::EraseRange(size_t first, size_t last)
+{
+  if (first > last || m_mapRanges.empty())
+    return;
+
+  auto it = m_mapRanges.upper_bound(first);
+  if (it != m_mapRanges.begin())
+  {
+    auto prev = std::prev(it);
+    if (prev->second >= first)
+    {
+      it = prev;
+    }
+  }
+
+  while (it != m_mapRanges.end() && it->first <= last)
+  {
+    size_t rangeFirst = it->first;
+    size_t rangeLast  = it->second;
+    m_nCount -= rangeLast - rangeFirst + 1;
+    it = m_mapRanges.erase(it);
+
+    // Keep the parts of the range that stick out on either side
+    if (rangeFirst < first)
+    {
+      m_mapRanges.emplace_hint(it, rangeFirst, first - 1);
+      m_nCount += first - rangeFirst;
+    }
+    if (rangeLast > last)
+    {
+      it = m_mapRanges.emplace_hint(it, last + 1, rangeLast);
+      m_nCount += rangeLast - last;
+      break;
+    }
+  }
+}
+
+void IdRangeSet::Clear()
+{
+  m_mapRanges.clear();
+  m_nCount = 0;
+}
+
+bool IdRangeSet::Contains(size_t id) const
+{
+  auto it = m_mapRanges.upper_bound(id);
+  if (it == m_mapRanges.begin())
+    return false;
+
+  --it;
+  return id <= it->second;
+}
+
+bool IdRangeSet::ContainsRange(size_t first, size_t last) const
+{
+  if (first > last)
+    return true;
+
+  // Ranges are merged, so [first, last] must lie inside a single one
+  auto it = m_mapRanges.upper_bound(first);
+  if (it == m_mapRanges.begin())
+    return false;
+
+  --it;
+  return last <= it->second;
+}
+
+void IdRangeSet::ForEach(const std::function<void(size_t)>& func) const
+{
+  for (const auto& range : m_mapRanges)
+  {
+    for (size_t id = range.first; ; ++id)
+    {
+      func(id);
+      if (id == range.second)
+        break;
+    }
+  }
+}
+
+std::vector<size_t> IdRangeSet::ToVector() const
+{
+  std::vector<size_t> ids;
+  ids.reserve(m_nCount);
+  ForEach([&ids](size_t id)
+  {
+    ids.push_back(id);
+  });
+  return ids;
+}
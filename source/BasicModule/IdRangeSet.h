@@ -0,0 +1,85 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_ID_RANGE_SET_H_
+#define   GUI_WXWIDGETS_MAIN_APP_ID_RANGE_SET_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+#include <functional>
+
+/*****************************************************************************
+ *
+ * CLASS   : IdRangeSet
+ * PURPOSE : Compressed set of row IDs stored as disjoint inclusive ranges
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Adjacent and overlapping ranges are merged on insertion, so
+ *           contiguous selections cost one entry regardless of their size.
+ *           Count() is O(1), iteration is O(selected).
+ *
+ *****************************************************************************/
+
+class IdRangeSet
+{
+public:
+  // Ranges keyed by first ID, value is the last ID (inclusive)
+  using RangeMap = std::map<size_t, size_t>;
+
+  IdRangeSet();
+
+  // Build a set from IDs sorted in ascending order (duplicates allowed)
+  static IdRangeSet FromSorted(const std::vector<size_t>& ids);
+
+  // Add a single ID
+  void   Insert       (size_t id);
+  // Add all IDs in [first, last]
+  void   InsertRange  (size_t first, size_t last);
+  // Remove a single ID
+  void   Erase        (size_t id);
+  // Remove all IDs in [first, last]
+  void   EraseRange   (size_t first, size_t last);
+  // Remove every ID
+  void   Clear        ();
+
+  // Check if an ID is in the set, O(log ranges)
+  bool   Contains     (size_t id) const;
+  // Check if every ID in [first, last] is in the set, O(log ranges)
+  bool   ContainsRange(size_t first, size_t last) const;
+  // Number of IDs in the set
+  size_t Count        () const { return m_nCount;          }
+  // Check if the set is empty
+  bool   Empty        () const { return m_nCount == 0;     }
+  // Number of disjoint ranges used to store the set
+  size_t RangeCount   () const { return m_mapRanges.size(); }
+  // Access the underlying ranges
+  const RangeMap& GetRanges() const { return m_mapRanges; }
+
+  // Visit every ID in ascending order
+  void   ForEach      (const std::function<void(size_t)>& func) const;
+  // Copy every ID into a vector in ascending order
+  std::vector<size_t> ToVector() const;
+
+  bool operator==(const IdRangeSet& other) const
+  {
+    return m_mapRanges == other.m_mapRanges;
+  }
+  bool operator!=(const IdRangeSet& other) const
+  {
+    return !(*this == other);
+  }
+protected:
+  // Disjoint, non-adjacent ranges
+  RangeMap               m_mapRanges;
+  // Number of IDs covered by m_mapRanges
+  size_t                 m_nCount;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_ID_RANGE_SET_H_
@@ -12,8 +12,18 @@
 #include <wx/menu.h>
 #include <wx/filedlg.h>
 #include <wx/clipbrd.h>
+#include <wx/dialog.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+#include <wx/textctrl.h>
+#include <wx/checklst.h>
+#include <wx/listbox.h>
+#include <wx/utils.h>
 #include "TableEx.hpp"
 #include "TableExAdapter.hpp"
+#include "TableExDataObject.h"
+#include "GlyphWidthCache.h"
+#include "IdRangeSet.h"
 #include "ListViewEx.h"
 
 ListViewEx::ListViewEx(
@@ -26,10 +36,19 @@ ListViewEx::ListViewEx(
   , m_adapter         (nullptr)
   , m_editCallback    (nullptr)
   , m_editCallbackPara(nullptr)
+  , m_batchEditCallback    (nullptr)
+  , m_batchEditCallbackPara(nullptr)
   , m_lastSortedCol   (-1)
   , m_sortAscending   (true)
   , m_rightClickedCol (-1)
+  , m_bApplyingSelection(false)
+  , m_bAutoSizeColumns(false)
 {
+  Bind(wxEVT_LIST_ITEM_SELECTED   , &ListViewEx::OnItemSelected    , this);
+  Bind(wxEVT_LIST_ITEM_DESELECTED , &ListViewEx::OnItemDeselected  , this);
+  Bind(wxEVT_KEY_DOWN             , &ListViewEx::OnKeyDown         , this);
+  Bind(wxEVT_LIST_CACHE_HINT      , &ListViewEx::OnCacheHint       , this);
+  Bind(wxEVT_IDLE                 , &ListViewEx::OnIdle            , this);
   Bind(wxEVT_LIST_COL_CLICK       , &ListViewEx::OnColumnClick     , this);
   Bind(wxEVT_LIST_COL_RIGHT_CLICK , &ListViewEx::OnColumnRightClick, this);
   Bind(wxEVT_LIST_ITEM_RIGHT_CLICK, &ListViewEx::OnItemRightClick  , this);
@@ -37,12 +56,24 @@ ListViewEx::ListViewEx(
 
   Bind(wxEVT_MENU, &ListViewEx::OnSetupFilter  , this, MENU_ITEM_SETUP_FILTER   );
   Bind(wxEVT_MENU, &ListViewEx::OnClearFilter  , this, MENU_ITEM_CLEAR_FILTER   );
+  Bind(wxEVT_MENU, &ListViewEx::OnClearAllFilters, this, MENU_ITEM_CLEAR_ALL_FILTER);
   Bind(wxEVT_MENU, &ListViewEx::OnEditItem     , this, MENU_ITEM_EDIT_ITEM      );
   Bind(wxEVT_MENU, &ListViewEx::OnBatchEditItem, this, MENU_ITEM_BATCH_EDIT_ITEM);
   Bind(wxEVT_MENU, &ListViewEx::OnCopyAddress  , this, MENU_ITEM_COPY_ADDRESS   );
+  Bind(wxEVT_MENU, &ListViewEx::OnCopyRows     , this, MENU_ITEM_COPY_ROWS      );
+  Bind(wxEVT_MENU, &ListViewEx::OnAutoSizeColumns, this, MENU_ITEM_AUTO_SIZE_COLUMNS);
   Bind(wxEVT_MENU, &ListViewEx::OnExportCSV    , this, MENU_ITEM_EXPORT_CSV     );
 }
 
+ListViewEx::~ListViewEx()
+{
+  // The adapter may go with the list, a later paste finds nothing
+  if (auto rows = m_clipboardRows.lock())
+  {
+    rows->Detach(false);
+  }
+}
+
 void ListViewEx::SetEditCallback(
   ListViewEx::EditCallback     callback,
   void            *callbackParam)
@@ -51,8 +82,17 @@ void ListViewEx::SetEditCallback(
   m_editCallbackPara  = callbackParam;
 }
 
+void ListViewEx::SetBatchEditCallback(
+  ListViewEx::BatchEditCallback callback,
+  void            *callbackParam)
+{
+  m_batchEditCallback     = callback;
+  m_batchEditCallbackPara = callbackParam;
+}
+
 void ListViewEx::SetTable(ITableExAdapter* adapter)
 {
+  m_bApplyingSelection = true;
   if (m_adapter == adapter)
   {
     // Adapter remains the same, perform partial refresh
@@ -60,16 +100,210 @@ void ListViewEx::SetTable(ITableExAdapter* adapter)
   }
   else
   {
-    // Adapter changed, perform full refresh
+    // Adapter changed, perform full refresh. Rows still on the clipboard
+    // are rendered now, the old adapter may not live until they are pasted.
+    if (auto rows = m_clipboardRows.lock())
+    {
+      rows->Detach(true);
+      m_clipboardRows.reset();
+    }
     m_adapter = adapter;
+    m_selection.Clear();
     m_adapter->FullRefreshList   (this);
+    m_vWidthVersions.clear();
+  }
+  m_bApplyingSelection = false;
+
+  if (m_bAutoSizeColumns)
+  {
+    UpdateColumnWidths(false);
+  }
+
+  // Items may have moved, put the selection back on the right rows
+  ApplySelection();
+}
+
+void ListViewEx::AppendRows(const std::vector<size_t>& ids, bool autoScroll)
+{
+  if (!m_adapter || ids.empty())
+    return;
+
+  m_bApplyingSelection = true;
+  m_adapter->AppendRows(this, ids);
+  m_bApplyingSelection = false;
+
+  // Appended rows may be sorted in between the marked items
+  if (IsVirtual() && !m_selection.Empty())
+  {
+    ApplySelection();
+  }
+
+  if (m_bAutoSizeColumns)
+  {
+    UpdateColumnWidths(false);
+  }
+
+  if (autoScroll && GetItemCount() > 0)
+  {
+    EnsureVisible(GetItemCount() - 1);
   }
 }
 
+void ListViewEx::SetQuickSearch(const wxString& text)
+{
+  if (!m_adapter)
+    return;
+
+  m_adapter->SetQuickSearch(text);
+  SetTable(m_adapter);
+}
+
+void ListViewEx::AutoSizeColumns()
+{
+  UpdateColumnWidths(true);
+}
+
+void ListViewEx::SetAutoSizeColumns(bool enable)
+{
+  m_bAutoSizeColumns = enable;
+  if (enable)
+  {
+    UpdateColumnWidths(false);
+  }
+}
+
+std::vector<size_t> ListViewEx::GetSelectedRowIds()
+{
+  std::vector<size_t> rowIds = GetShownSelection();
+  if (rowIds.size() != static_cast<size_t>(GetSelectedItemCount()))
+  {
+    // Some native change was not reported through item events, such as a
+    // shift-click range in a virtual list
+    SyncSelection();
+    rowIds = GetShownSelection();
+  }
+  return rowIds;
+}
+
+void ListViewEx::SelectAll()
+{
+  if (!m_adapter)
+    return;
+
+  m_selection = m_adapter->GetShownRowIds();
+
+  m_bApplyingSelection = true;
+  SetItemState(-1, wxLIST_STATE_SELECTED, wxLIST_STATE_SELECTED);
+  m_bApplyingSelection = false;
+  MarkAllItems();
+}
+
+void ListViewEx::ClearSelection()
+{
+  m_selection.Clear();
+
+  m_bApplyingSelection = true;
+  SetItemState(-1, 0, wxLIST_STATE_SELECTED);
+  m_bApplyingSelection = false;
+  MarkAllItems();
+}
+
+void ListViewEx::CopySelection()
+{
+  if (!m_adapter)
+    return;
+
+  // Rows are copied in view order; a list whose items are not all known
+  // (paged) copies the shown selection in ID order
+  std::vector<size_t> ids = GetSelectedRowIds();
+  m_adapter->SortRowIds(ids);
+  if (ids.empty() || !wxTheClipboard->Open())
+    return;
+
+  auto rows = std::make_shared<TableExClipboardRows>(m_adapter, std::move(ids));
+  wxTheClipboard->SetData(TableExClipboardRows::CreateDataObject(rows));
+  wxTheClipboard->Close();
+  m_clipboardRows = rows;
+}
+
+void ListViewEx::OnItemSelected(wxListEvent& event)
+{
+  size_t id = 0;
+  if (!m_bApplyingSelection && m_adapter
+    && m_adapter->GetRowId(event.GetIndex(), id))
+  {
+    // A plain click in a virtual list drops the other items without an
+    // event for each of them
+    if (IsVirtual() && !wxGetKeyState(WXK_CONTROL) && !wxGetKeyState(WXK_SHIFT))
+    {
+      DropShownRows();
+    }
+    m_selection.Insert(id);
+  }
+  event.Skip();
+}
+
+void ListViewEx::OnItemDeselected(wxListEvent& event)
+{
+  size_t id = 0;
+  if (!m_bApplyingSelection && m_adapter)
+  {
+    if (event.GetIndex() < 0 && IsVirtual())
+    {
+      // All items of a virtual list were deselected at once
+      DropShownRows();
+    }
+    else if (m_adapter->GetRowId(event.GetIndex(), id))
+    {
+      m_selection.Erase(id);
+    }
+  }
+  event.Skip();
+}
+
+void ListViewEx::OnKeyDown(wxKeyEvent& event)
+{
+  if (event.ControlDown() && event.GetKeyCode() == 'A')
+  {
+    SelectAll();
+    return;
+  }
+  if (event.ControlDown() && event.GetKeyCode() == 'C')
+  {
+    CopySelection();
+    return;
+  }
+  event.Skip();
+}
+
+void ListViewEx::OnCacheHint(wxListEvent& event)
+{
+  if (m_adapter)
+  {
+    m_adapter->PrepareItems(event.GetCacheFrom(), event.GetCacheTo());
+    MarkSelectedItems(event.GetCacheFrom(), event.GetCacheTo());
+  }
+}
+
+void ListViewEx::OnIdle(wxIdleEvent& event)
+{
+  if (m_adapter && m_adapter->RefineSort())
+  {
+    event.RequestMore();
+  }
+  event.Skip();
+}
+
+wxString ListViewEx::OnGetItemText(long item, long column) const
+{
+  return m_adapter ? m_adapter->GetItemText(item, column) : wxString();
+}
+
 void ListViewEx::OnItemRightClick(wxListEvent& event)
 {
   wxMenu               menu;
-  long selectedCount = GetSelectedItemCount();
+  std::vector<size_t>  rowIds = GetSelectedRowIds();
+  long selectedCount = static_cast<long>(rowIds.size());
   // Dynamically add menu item
   if      (selectedCount == 1)
   {
@@ -80,6 +314,10 @@ void ListViewEx::OnItemRightClick(wxListEvent& event)
   {
     menu.Append(MENU_ITEM_BATCH_EDIT_ITEM, "Batch Edit");
   }
+  if (selectedCount >= 1)
+  {
+    menu.Append(MENU_ITEM_COPY_ROWS      , "Copy\tCtrl+C");
+  }
 
   menu.Append(MENU_ITEM_EXPORT_CSV, "Export CSV");
   PopupMenu(&menu);
@@ -106,7 +344,15 @@ void ListViewEx::OnColumnClick(wxListEvent& event)
     m_sortAscending = true;
   }
 
-  m_adapter->SortByColumn(col, m_sortAscending);
+  // A virtual list only needs the rows it shows, so sort lazily
+  size_t lazyWindow = 0;
+  if (IsVirtual())
+  {
+    lazyWindow = static_cast<size_t>(
+      (std::max)(GetCountPerPage(), 1) * LAZY_SORT_PAGES);
+  }
+
+  m_adapter->SortByColumn(col, m_sortAscending, lazyWindow);
   SetTable(m_adapter);
 
   UpdateColumnText(col);
@@ -114,10 +360,14 @@ void ListViewEx::OnColumnClick(wxListEvent& event)
 
 void ListViewEx::OnColumnRightClick(wxListEvent& event)
 {
+  m_rightClickedCol = event.GetColumn();
+
   wxMenu menu;
   menu.Append(MENU_ITEM_SETUP_FILTER    , "Setup Filter"    );
   menu.Append(MENU_ITEM_CLEAR_FILTER    , "Clear Filter"    );
   menu.Append(MENU_ITEM_CLEAR_ALL_FILTER, "Clear All Filter");
+  menu.AppendSeparator();
+  menu.Append(MENU_ITEM_AUTO_SIZE_COLUMNS, "Auto Size Columns");
   PopupMenu(&menu);
 }
 
@@ -125,8 +375,8 @@ void ListViewEx::OnEditItem(wxCommandEvent&)
 {
   if (m_editCallback)
   {
-    long itemIndex = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-    if (itemIndex != -1)
+    long itemIndex = -1;
+    if (GetFirstSelectedItem(itemIndex))
     {
       std::vector<wxString> editData;
       editData.push_back(GetItemText(itemIndex, 0));
@@ -139,14 +389,31 @@ void ListViewEx::OnEditItem(wxCommandEvent&)
 
 void ListViewEx::OnBatchEditItem(wxCommandEvent&)
 {
-  if (m_editCallback)
+  std::vector<size_t>     rowIds = GetSelectedRowIds();
+  if (m_batchEditCallback && m_adapter)
+  {
+    if (rowIds.size() > 1)
+    {
+      // Apply all edits as one transaction and refresh only the edited rows
+      m_adapter->BeginTransaction();
+      m_batchEditCallback(rowIds, m_batchEditCallbackPara);
+
+      m_bApplyingSelection = true;
+      m_adapter->RefreshRows(this, m_adapter->CommitTransaction());
+      m_bApplyingSelection = false;
+      ApplySelection();
+    }
+  }
+  else if (m_editCallback && m_adapter)
   {
     std::vector<wxString> editData;
     long                  itemIndex = -1;
-    while (-1 != (itemIndex = GetNextItem(
-      itemIndex, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)))
+    for (size_t id : rowIds)
     {
-      editData.push_back(GetItemText(itemIndex, 0));
+      if (m_adapter->GetItemIndex(id, itemIndex))
+      {
+        editData.push_back(GetItemText(itemIndex, 0));
+      }
     }
 
     if (editData.size() > 1)
@@ -159,8 +426,8 @@ void ListViewEx::OnBatchEditItem(wxCommandEvent&)
 
 void ListViewEx::OnCopyAddress(wxCommandEvent&)
 {
-  long itemIndex = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-  if (itemIndex == -1)
+  long itemIndex = -1;
+  if (!GetFirstSelectedItem(itemIndex))
     return;
 
   // Get column 2 data (index 1 in wxListView, since index 0 is ID
@@ -173,6 +440,16 @@ void ListViewEx::OnCopyAddress(wxCommandEvent&)
   }
 }
 
+void ListViewEx::OnCopyRows(wxCommandEvent&)
+{
+  CopySelection();
+}
+
+void ListViewEx::OnAutoSizeColumns(wxCommandEvent&)
+{
+  AutoSizeColumns();
+}
+
 void ListViewEx::OnExportCSV(wxCommandEvent&)
 {
   wxFileDialog saveFileDialog(this, "Save CSV", "", "export.csv",
@@ -190,6 +467,135 @@ void ListViewEx::OnExportCSV(wxCommandEvent&)
 
 void ListViewEx::OnSetupFilter(wxCommandEvent&)
 {
+  if (!m_adapter || m_rightClickedCol < 0)
+    return;
+
+  wxListItem column;
+  column.SetMask(wxLIST_MASK_TEXT);
+  GetColumn(m_rightClickedCol, column);
+
+  // Values and histogram come from statistics the table keeps up to date,
+  // so the dialog opens without scanning the rows
+  ColumnSummary summary;
+  bool          hasSummary = m_adapter->GetColumnSummary(m_rightClickedCol, summary);
+
+  wxDialog    dialog(this, wxID_ANY, "Setup Filter - " + column.GetText(),
+    wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER);
+  wxBoxSizer *pDialogSizer = new wxBoxSizer(wxVERTICAL);
+
+  // Excel-style value list, "(Select All)" first. Past the exact limit
+  // only the most frequent values are listed; unchecking one of those
+  // then leaves it out and keeps the values not listed.
+  wxCheckListBox *pValues = nullptr;
+  if (hasSummary)
+  {
+    wxString caption = summary.exact
+      ? wxString::Format("%zu rows, %zu distinct values", summary.rows, summary.distinct)
+      : wxString::Format("%zu rows, about %zu distinct values, %zu most frequent shown",
+          summary.rows, summary.distinct, summary.values.size());
+    pDialogSizer->Add(new wxStaticText(&dialog, wxID_ANY, caption), 0, wxALL, 5);
+
+    wxArrayString items;
+    items.Add("(Select All)");
+    for (const ColumnSummary::Value& value : summary.values)
+    {
+      items.Add(wxString::Format("%s  (%zu)", value.text, value.count));
+    }
+    pValues = new wxCheckListBox(&dialog, wxID_ANY, wxDefaultPosition, wxSize(-1, 200), items);
+    for (unsigned i = 0; i < items.GetCount(); ++i)
+    {
+      pValues->Check(i);
+    }
+    pValues->Bind(wxEVT_CHECKLISTBOX, [pValues](wxCommandEvent& event)
+    {
+      if (event.GetInt() != 0)
+        return;
+
+      bool check = pValues->IsChecked(0);
+      for (unsigned i = 1; i < pValues->GetCount(); ++i)
+      {
+        pValues->Check(i, check);
+      }
+    });
+    pDialogSizer->Add(pValues, 1, wxEXPAND | wxLEFT | wxRIGHT, 5);
+  }
+
+  // Inclusive range, leave a bound empty to keep that side open and
+  // enter the same value twice to filter for equality
+  wxTextCtrl *pLower = new wxTextCtrl(&dialog, wxID_ANY);
+  wxTextCtrl *pUpper = new wxTextCtrl(&dialog, wxID_ANY);
+
+  // Numeric histogram, picking a bin fills in its range. Bins leave out
+  // their upper edge, which starts the next bin, until "To" is edited.
+  bool upperOpen = false;
+  if (hasSummary && !summary.histogram.empty())
+  {
+    wxArrayString bins;
+    for (const ColumnSummary::Bin& bin : summary.histogram)
+    {
+      bins.Add(wxString::Format("%g to below %g  (%zu)", bin.lower, bin.upper, bin.count));
+    }
+    wxListBox *pBins = new wxListBox(&dialog, wxID_ANY, wxDefaultPosition, wxSize(-1, 120), bins);
+    pBins->Bind(wxEVT_LISTBOX, [pBins, pLower, pUpper, &summary, &upperOpen](wxCommandEvent&)
+    {
+      int selection = pBins->GetSelection();
+      if (selection < 0 || static_cast<size_t>(selection) >= summary.histogram.size())
+        return;
+
+      pLower->ChangeValue(wxString::Format("%g", summary.histogram[selection].lower));
+      pUpper->ChangeValue(wxString::Format("%g", summary.histogram[selection].upper));
+      upperOpen = true;
+    });
+    pUpper->Bind(wxEVT_TEXT, [&upperOpen](wxCommandEvent&)
+    {
+      upperOpen = false;
+    });
+    pDialogSizer->Add(pBins, 0, wxEXPAND | wxALL, 5);
+  }
+
+  wxBoxSizer *pRangeSizer = new wxBoxSizer(wxHORIZONTAL);
+  pRangeSizer->Add(new wxStaticText(&dialog, wxID_ANY, "From"), 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+  pRangeSizer->Add(pLower                                     , 1, wxALL                          , 5);
+  pRangeSizer->Add(new wxStaticText(&dialog, wxID_ANY, "To"  ), 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+  pRangeSizer->Add(pUpper                                     , 1, wxALL                          , 5);
+
+  pDialogSizer->Add(pRangeSizer, 0, wxEXPAND);
+  pDialogSizer->Add(dialog.CreateStdDialogButtonSizer(wxOK | wxCANCEL), 0, wxEXPAND | wxALL, 5);
+  dialog.SetSizerAndFit(pDialogSizer);
+
+  if (dialog.ShowModal() != wxID_OK)
+    return;
+
+  m_adapter->SetRangeFilter(m_rightClickedCol,
+    pLower->GetValue().utf8_string(),
+    pUpper->GetValue().utf8_string(),
+    upperOpen);
+
+  // Everything checked keeps every value, including those not listed. A
+  // complete list keeps the checked values, a partial one leaves out the
+  // unchecked ones.
+  if (pValues)
+  {
+    std::vector<wxString> checked;
+    std::vector<wxString> unchecked;
+    for (unsigned i = 1; i < pValues->GetCount(); ++i)
+    {
+      (pValues->IsChecked(i) ? checked : unchecked).push_back(summary.values[i - 1].text);
+    }
+    if (unchecked.empty())
+    {
+      m_adapter->SetFilter(m_rightClickedCol, nullptr);
+    }
+    else if (summary.exact)
+    {
+      m_adapter->SetValueFilter(m_rightClickedCol, checked);
+    }
+    else
+    {
+      m_adapter->SetValueFilter(m_rightClickedCol, unchecked, true);
+    }
+  }
+  SetTable(m_adapter);
 }
 
 void ListViewEx::OnClearFilter(wxCommandEvent&)
@@ -210,6 +616,151 @@ void ListViewEx::OnClearAllFilters(wxCommandEvent&)
   }
 }
 
+void ListViewEx::ApplySelection()
+{
+  if (!m_adapter)
+    return;
+
+  m_bApplyingSelection = true;
+  SetItemState(-1, 0, wxLIST_STATE_SELECTED);
+  m_bApplyingSelection = false;
+  m_markedItems.Clear();
+  if (m_selection.Empty())
+  {
+    MarkAllItems();
+    return;
+  }
+
+  if (IsVirtual())
+  {
+    // Finding the item of every selected row could order a whole lazily
+    // sorted view; only the items on screen are marked now, the others
+    // as the list asks for them
+    long top = GetTopItem();
+    MarkSelectedItems(top, top + GetCountPerPage());
+    return;
+  }
+
+  m_bApplyingSelection = true;
+  long item = -1;
+  m_selection.ForEach([&](size_t id)
+  {
+    if (m_adapter->GetItemIndex(id, item))
+    {
+      SetItemState(item, wxLIST_STATE_SELECTED, wxLIST_STATE_SELECTED);
+    }
+  });
+  m_bApplyingSelection = false;
+  MarkAllItems();
+}
+
+void ListViewEx::MarkSelectedItems(long from, long to)
+{
+  to = std::min(to, static_cast<long>(GetItemCount()) - 1);
+  if (!m_adapter || from < 0 || to < from
+    || m_markedItems.ContainsRange(from, to))
+    return;
+
+  m_bApplyingSelection = true;
+  size_t id = 0;
+  for (long item = from; item <= to; ++item)
+  {
+    if (!m_markedItems.Contains(item) && m_adapter->GetRowId(item, id)
+      && m_selection.Contains(id))
+    {
+      SetItemState(item, wxLIST_STATE_SELECTED, wxLIST_STATE_SELECTED);
+    }
+  }
+  m_bApplyingSelection = false;
+  m_markedItems.InsertRange(from, to);
+}
+
+void ListViewEx::MarkAllItems()
+{
+  m_markedItems.Clear();
+  if (GetItemCount() > 0)
+  {
+    m_markedItems.InsertRange(0, GetItemCount() - 1);
+  }
+}
+
+void ListViewEx::DropShownRows()
+{
+  for (size_t id : GetShownSelection())
+  {
+    m_selection.Erase(id);
+  }
+}
+
+std::vector<size_t> ListViewEx::GetShownSelection() const
+{
+  std::vector<size_t> rowIds;
+  if (!m_adapter)
+    return rowIds;
+
+  // Selected rows hidden by a filter stay selected but are not acted upon
+  m_selection.ForEach([&](size_t id)
+  {
+    if (m_adapter->IsRowShown(id))
+    {
+      rowIds.push_back(id);
+    }
+  });
+  return rowIds;
+}
+
+bool ListViewEx::GetFirstSelectedItem(long& item)
+{
+  std::vector<size_t> rowIds = GetSelectedRowIds();
+  if (rowIds.empty())
+    return false;
+
+  // The model knows rows, not items; the first in view order is meant
+  if (rowIds.size() > 1)
+  {
+    m_adapter->SortRowIds(rowIds);
+  }
+  return !rowIds.empty() && m_adapter->GetItemIndex(rowIds.front(), item);
+}
+
+void ListViewEx::SyncSelection()
+{
+  if (!m_adapter)
+    return;
+
+  long count = GetItemCount();
+  if (IsVirtual() && count > 0 && !m_markedItems.ContainsRange(0, count - 1))
+  {
+    // Items not marked yet show nothing of the model, keep their rows
+    m_markedItems.ForEach([&](size_t item)
+    {
+      size_t id = 0;
+      if (  static_cast<long>(item) < count
+        && !IsSelected(static_cast<long>(item))
+        &&  m_adapter->GetRowId(static_cast<long>(item), id))
+      {
+        m_selection.Erase(id);
+      }
+    });
+  }
+  else
+  {
+    // Drop the shown rows from the model, keep rows hidden by filters
+    DropShownRows();
+  }
+
+  long   item = -1;
+  size_t id   = 0;
+  while (-1 != (item = GetNextItem(
+    item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)))
+  {
+    if (m_adapter->GetRowId(item, id))
+    {
+      m_selection.Insert(id);
+    }
+  }
+}
+
 void ListViewEx::UpdateColumnText(int sortedCol)
 {
   for (int i = 0; i < GetColumnCount(); ++i)
@@ -231,3 +782,45 @@ void ListViewEx::UpdateColumnText(int sortedCol)
     SetColumn(i, item);
   }
 }
+
+void ListViewEx::UpdateColumnWidths(bool force)
+{
+  if (!m_adapter)
+    return;
+
+  int columns = GetColumnCount();
+  m_vWidthVersions.resize(columns, 0);
+  ColumnWidthSample sample;
+  for (int col = 0; col < columns; ++col)
+  {
+    if (!m_adapter->GetColumnWidthSample(col, sample)
+      || (!force && sample.version == m_vWidthVersions[col]))
+      continue;
+
+    m_vWidthVersions[col] = sample.version;
+
+    // Rank the sampled values by estimated width, as the longest text is
+    // not always the widest, then measure the widest few exactly
+    std::vector<std::pair<int, size_t>> estimates;
+    for (size_t i = 0; i < sample.widest.size(); ++i)
+    {
+      estimates.emplace_back(m_glyphWidths.EstimateText(this, sample.widest[i]), i);
+    }
+    std::sort(estimates.begin(), estimates.end(),
+      [](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b)
+    {
+      return a.first > b.first;
+    });
+
+    wxListItem column;
+    column.SetMask(wxLIST_MASK_TEXT);
+    GetColumn(col, column);
+    int width = m_glyphWidths.MeasureText(this, column.GetText());
+    for (size_t i = 0; i < estimates.size() && i < AUTO_SIZE_EXACT_SAMPLES; ++i)
+    {
+      width = (std::max)(width,
+        m_glyphWidths.MeasureText(this, sample.widest[estimates[i].second]));
+    }
+    SetColumnWidth(col, (std::min)(width + AUTO_SIZE_PADDING, AUTO_SIZE_MAX_WIDTH));
+  }
+}
@@ -17,7 +17,7 @@
  * PURPOSE : Extended wxListView class that integrates with TableExAdapter
  * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
  * COMMENTS: Supports batch data updates, column sorting, data filtering,
- *           and exporting to CSV.
+ *           copying rows to the clipboard and exporting to CSV.
  *
  *****************************************************************************/
 
@@ -26,6 +26,9 @@ class ListViewEx : public wxListView
 public:
   // Callback function for handling edit operations
   using EditCallback = std::function<void(std::vector<wxString>&, void*)>;
+  // Callback function for batch edits, receives the selected row IDs and is
+  // invoked inside a single TableEx transaction
+  using BatchEditCallback = std::function<void(const std::vector<size_t>&, void*)>;
 
   // Constructor
   explicit ListViewEx      (wxWindow        *parent,
@@ -33,12 +36,49 @@ public:
                             const wxPoint   &pos   = wxDefaultPosition,
                             const wxSize    &size  = wxDefaultSize,
                             long             style = wxLC_REPORT);
+  // Destructor
+  ~ListViewEx              () override;
 
   // Set the callback function for handling edit operations
   void SetEditCallback     (EditCallback callback, void* callbackParam);
+  // Set the callback function for handling batch edit operations by row ID
+  void SetBatchEditCallback(BatchEditCallback callback, void* callbackParam);
   // Set the table adapter and refresh ListView
   void SetTable            (ITableExAdapter* adapter);
+  // Show rows just appended to the table, optionally scrolling to the end
+  void AppendRows          (const std::vector<size_t>& ids, bool autoScroll);
+  // Only show rows containing text in any column, empty text shows all
+  void SetQuickSearch      (const wxString& text);
+  // Size every column to its widest value or header, measuring a sample
+  // of the longest values the table keeps track of
+  void AutoSizeColumns     ();
+  // Keep columns sized to their content as rows change
+  void SetAutoSizeColumns  (bool enable);
 
+  // Get the selection model (row IDs, independent of item positions)
+  const IdRangeSet& GetSelection() const { return m_selection; }
+  // Get the selected row IDs that are currently shown, in ascending order.
+  // The model is first rebuilt from the native item states if they count
+  // another number of selected items.
+  std::vector<size_t> GetSelectedRowIds();
+  // Select every row currently shown
+  void SelectAll           ();
+  // Clear the selection
+  void ClearSelection      ();
+  // Put the selected rows on the clipboard as TSV and CSV, rendered when
+  // pasted
+  void CopySelection       ();
+
+  // Handle selection of a data row
+  void OnItemSelected      (wxListEvent& event);
+  // Handle deselection of a data row
+  void OnItemDeselected    (wxListEvent& event);
+  // Handle keyboard shortcuts
+  void OnKeyDown           (wxKeyEvent&  event);
+  // Handle the range of items a virtual list is about to draw
+  void OnCacheHint         (wxListEvent& event);
+  // Continue background work (lazy sorting) while the GUI is idle
+  void OnIdle              (wxIdleEvent& event);
   // Handle right-click on a data row
   void OnItemRightClick    (wxListEvent& event);
   // Handle double-click on a data row
@@ -53,6 +93,10 @@ public:
   void OnBatchEditItem     (wxCommandEvent&);
   // Handle Copy Address
   void OnCopyAddress       (wxCommandEvent&);
+  // Handle copying the selected rows
+  void OnCopyRows          (wxCommandEvent&);
+  // Handle sizing the columns to their content
+  void OnAutoSizeColumns   (wxCommandEvent&);
   // Handle exporting data to CSV
   void OnExportCSV         (wxCommandEvent&);
   // Show a dialog for updating the filter
@@ -62,8 +106,27 @@ public:
   // Clear all filters
   void OnClearAllFilters   (wxCommandEvent&);
 protected:
+  // Get the text of a virtual list cell from the adapter
+  wxString OnGetItemText   (long item, long column) const override;
   // Update column text with sorting indicator
   void UpdateColumnText    (int sortedCol);
+  // Push the selection model to the native item states
+  void ApplySelection      ();
+  // Select the unmarked items of [from, to] whose rows are in the model
+  void MarkSelectedItems   (long from, long to);
+  // Note that every item state matches the model
+  void MarkAllItems        ();
+  // Drop the rows shown in the list from the selection model
+  void DropShownRows       ();
+  // Get the selected rows of the model that are shown, in ascending order
+  std::vector<size_t> GetShownSelection() const;
+  // Get the item of the first selected row in view order, false if none
+  bool GetFirstSelectedItem(long& item);
+  // Rebuild the selection model from the native item states
+  void SyncSelection       ();
+  // Size the columns whose width sample changed since they were last
+  // sized, or every column if force
+  void UpdateColumnWidths  (bool force);
 protected:
   // Prevent direct modification of wxListView
   void InsertItem          (long, const wxString&)         = delete;
@@ -77,12 +140,38 @@ protected:
   EditCallback           m_editCallback;
   // Additional parameter for the edit callback
   void                  *m_editCallbackPara;
+  // Callback function for handling batch edit operations
+  BatchEditCallback      m_batchEditCallback;
+  // Additional parameter for the batch edit callback
+  void                  *m_batchEditCallbackPara;
   // Index of the last sorted column
   int                    m_lastSortedCol;
   // Sorting direction flag (true for ascending, false for descending)
   bool                   m_sortAscending;
   // Index of the column that was right-clicked
   int                    m_rightClickedCol;
+  // Selected row IDs, survives sorting, filtering and refreshing
+  IdRangeSet             m_selection;
+  // Set while item states are changed by code, to ignore the echo events
+  bool                   m_bApplyingSelection;
+  // Items whose native state was set from the model; a virtual list marks
+  // them as they are shown
+  IdRangeSet             m_markedItems;
+  // Rows last copied, while the clipboard still holds them unrendered
+  std::weak_ptr<TableExClipboardRows> m_clipboardRows;
+  // Columns follow their content while set
+  bool                   m_bAutoSizeColumns;
+  // Width sample version each column was last sized for
+  std::vector<uint64_t>  m_vWidthVersions;
+  // Character widths of the fonts used
+  GlyphWidthCache        m_glyphWidths;
+  // Sampled values measured exactly, the rest are estimated
+  const size_t  AUTO_SIZE_EXACT_SAMPLES          = 2;
+  // Pixels added to the widest text, and the widest a column is made
+  const int     AUTO_SIZE_PADDING                = 16;
+  const int     AUTO_SIZE_MAX_WIDTH              = 600;
+  // Rows a lazy sort orders up front, in pages of the visible item count
+  const int32_t LAZY_SORT_PAGES                  = 4;
   // Define menu item IDs
   const int32_t MENU_ITEM_SETUP_FILTER           = 32100;
   const int32_t MENU_ITEM_CLEAR_FILTER           = 32101;
@@ -91,6 +180,8 @@ protected:
   const int32_t MENU_ITEM_BATCH_EDIT_ITEM        = 32104;
   const int32_t MENU_ITEM_EXPORT_CSV             = 32105;
   const int32_t MENU_ITEM_COPY_ADDRESS           = 32106;
+  const int32_t MENU_ITEM_COPY_ROWS              = 32107;
+  const int32_t MENU_ITEM_AUTO_SIZE_COLUMNS      = 32108;
 };
 
 #endif // GUI_WXWIDGETS_MAIN_APP_LIST_VIEW_EX_H_
@@ -0,0 +1,127 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_MEMORY_RESOURCE_EX_H_
+#define   GUI_WXWIDGETS_MAIN_APP_MEMORY_RESOURCE_EX_H_
+
+#include <cstddef>
+#include <atomic>
+#include <memory_resource>
+
+/*****************************************************************************
+ *
+ * CLASS   : CountingMemoryResource
+ * PURPOSE : std::pmr::memory_resource that forwards to an upstream resource
+ *           and keeps allocation statistics
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Counters are atomic, so one instance may be shared by threads
+ *           as long as the upstream resource allows it
+ *
+ *****************************************************************************/
+
+class CountingMemoryResource : public std::pmr::memory_resource
+{
+public:
+  explicit CountingMemoryResource(
+    std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+    : m_pUpstream   (upstream)
+    , m_nBytesInUse (0)
+    , m_nPeakBytes  (0)
+    , m_nAllocations(0)
+  {
+  }
+  CountingMemoryResource(const CountingMemoryResource&)            = delete;
+  CountingMemoryResource& operator=(const CountingMemoryResource&) = delete;
+
+  // Get the resource allocations are forwarded to
+  std::pmr::memory_resource* GetUpstream   () const { return m_pUpstream;    }
+  // Bytes currently allocated
+  size_t                     GetBytesInUse () const { return m_nBytesInUse;  }
+  // Largest value GetBytesInUse has reached
+  size_t                     GetPeakBytes  () const { return m_nPeakBytes;   }
+  // Number of allocations made so far
+  size_t                     GetAllocations() const { return m_nAllocations; }
+protected:
+  void* do_allocate(size_t bytes, size_t alignment) override
+  {
+    void*  p     = m_pUpstream->allocate(bytes, alignment);
+    size_t inUse = m_nBytesInUse.fetch_add(bytes) + bytes;
+    size_t peak  = m_nPeakBytes.load();
+    while (inUse > peak && !m_nPeakBytes.compare_exchange_weak(peak, inUse))
+    {
+    }
+    ++m_nAllocations;
+    return p;
+  }
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override
+  {
+    m_nBytesInUse.fetch_sub(bytes);
+    m_pUpstream->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+  {
+    return this == &other;
+  }
+protected:
+  // Resource that actually provides memory
+  std::pmr::memory_resource       *m_pUpstream;
+  // Statistics
+  std::atomic<size_t>              m_nBytesInUse;
+  std::atomic<size_t>              m_nPeakBytes;
+  std::atomic<size_t>              m_nAllocations;
+};
+
+/*****************************************************************************
+ *
+ * STRUCT  : TableExMemoryUsage
+ * PURPOSE : Memory usage report of a TableEx
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Container sizes are estimates (element size plus node overhead),
+ *           the resource figures are exact counts of what went through the
+ *           table's memory resource
+ *
+ *****************************************************************************/
+
+struct TableExMemoryUsage
+{
+  size_t rows          = 0;  // Number of rows
+  size_t rowBytes      = 0;  // Row map nodes
+  size_t stringBytes   = 0;  // Heap buffers of strings too long to be inline
+  size_t viewBytes     = 0;  // Sorted, filtered and ID order views
+  size_t indexBytes    = 0;  // Secondary index nodes
+  size_t statsBytes    = 0;  // Column value statistics
+  size_t zoneBytes     = 0;  // Zone map blocks
+  size_t resourceBytes = 0;  // Bytes in use through the table resource
+  size_t resourcePeak  = 0;  // Peak of resourceBytes
+  size_t allocations   = 0;  // Allocations made through the table resource
+
+  // Estimated total
+  size_t Total() const
+  {
+    return rowBytes + stringBytes + viewBytes + indexBytes + statsBytes + zoneBytes;
+  }
+  // Accumulate another report, e.g. a snapshot kept next to a table
+  TableExMemoryUsage& operator+=(const TableExMemoryUsage& other)
+  {
+    rows          += other.rows;
+    rowBytes      += other.rowBytes;
+    stringBytes   += other.stringBytes;
+    viewBytes     += other.viewBytes;
+    indexBytes    += other.indexBytes;
+    statsBytes    += other.statsBytes;
+    zoneBytes     += other.zoneBytes;
+    resourceBytes += other.resourceBytes;
+    resourcePeak  += other.resourcePeak;
+    allocations   += other.allocations;
+    return *this;
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_MEMORY_RESOURCE_EX_H_
@@ -0,0 +1,573 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_PAGED_TABLE_EX_ADAPTER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_PAGED_TABLE_EX_ADAPTER_H_
+
+#include <atomic>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <future>
+#include <thread>
+#include <unordered_set>
+
+/*****************************************************************************
+ *
+ * CLASS   : PagedTableExAdapter
+ * PURPOSE : Adapter browsing rows of an ITableExDataProvider page by page
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Needs a wxLC_VIRTUAL list. At most MAX_PAGES pages of
+ *           PAGE_ROWS rows are cached (least recently drawn evicted), so
+ *           memory stays bounded whatever the size of the data. Missing
+ *           pages are requested when drawn or hinted, PREFETCH_PAGES more
+ *           in the scroll direction; they show empty until they arrive.
+ *           Arrived pages are taken in on the GUI thread from RefineSort,
+ *           which the list calls at idle time (the provider wakes it).
+ *           Only the loaded rows are known, so selecting all, looking up
+ *           items of rows not loaded and function filters are not
+ *           supported; the data is read-only. ExportToCSV reads and writes
+ *           on a thread of its own, the GUI thread only starts it.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class PagedTableExAdapter : public ITableExAdapter
+{
+public:
+  using Provider = ITableExDataProvider<C, N>;
+  using Query    = typename Provider::Query;
+  using Page     = typename Provider::Page;
+  using RowData  = std::array<ColumnData<C>, N>;
+
+  // Rows per page
+  static const size_t PAGE_ROWS      = 256;
+  // Pages kept in the cache (64K rows)
+  static const size_t MAX_PAGES      = 256;
+  // Pages requested ahead of the visible ones in the scroll direction
+  static const size_t PREFETCH_PAGES = 2;
+protected:
+  struct CachedPage
+  {
+    std::vector<size_t>            ids;
+    std::vector<RowData>           rows;
+    std::list<size_t>::iterator    lru;
+  };
+  // Pages answered by the provider. Shared with the request callbacks, so
+  // answers arriving after the adapter is gone are harmless.
+  struct Inbox
+  {
+    std::mutex                     mutex;
+    std::vector<Page>              pages;
+  };
+
+  Provider                                     *m_pProvider;
+  // Current query and its generation
+  Query                                         m_query;
+  uint64_t                                      m_nGeneration   = 1;
+  // Cached pages by page number, and their use order (most recent first)
+  mutable std::unordered_map<size_t, CachedPage> m_mapPages;
+  mutable std::list<size_t>                     m_lstLru;
+  // Pages requested and not answered yet
+  mutable std::unordered_set<size_t>            m_setPending;
+  std::shared_ptr<Inbox>                        m_pInbox;
+  // Rows of the query, an estimate until m_bRowCountExact
+  size_t                                        m_nRowCount     = 0;
+  bool                                          m_bRowCountExact = false;
+  // List showing the rows
+  wxListView                                   *m_pListView     = nullptr;
+  // First item of the last cache hint, to tell the scroll direction
+  mutable long                                  m_nLastFrom     = 0;
+  mutable bool                                  m_bScrollingDown = true;
+  // Returned by GetItemRowIds, rows are not all known
+  std::vector<size_t>                           m_vNoIds;
+  // Writes the file of the last ExportToCSV, stopped early by
+  // m_bExportCancelled when the adapter goes away
+  std::thread                                   m_threadExport;
+  std::atomic<bool>                             m_bExportCancelled{ false };
+public:
+  // The provider must outlive the adapter
+  explicit PagedTableExAdapter(Provider* provider)
+    : m_pProvider(provider)
+    , m_pInbox   (std::make_shared<Inbox>())
+  {
+  }
+  ~PagedTableExAdapter() override
+  {
+    m_bExportCancelled = true;
+    if (m_pProvider)
+    {
+      m_pProvider->CancelBefore(m_nGeneration + 1);
+    }
+    if (m_threadExport.joinable())
+    {
+      m_threadExport.join();
+    }
+  }
+  // Export every row of the current query, reading page by page on the
+  // export thread; returns once it is started. If a query change drops one
+  // of its pages, the partial file is removed.
+  void ExportToCSV(const std::string& filename) override
+  {
+    if (!m_pProvider)
+      return;
+
+    // One export at a time
+    if (m_threadExport.joinable())
+    {
+      m_threadExport.join();
+    }
+
+    std::string header;
+    for (size_t col = 0; col < N; ++col)
+    {
+      if (col > 0)
+      {
+        header += ',';
+      }
+      AppendDelimitedCell(header, m_pProvider->GetColumnInfo(col).name, ',');
+    }
+    header += '\n';
+    m_threadExport = std::thread(&PagedTableExAdapter::ExportPages, this,
+      filename, header, m_query, m_nGeneration);
+  }
+  // Function and value filters can not be handed to a provider, only
+  // range filters
+  void SetFilter(size_t, std::function<bool(const void*)>) override
+  {
+  }
+  void SetValueFilter(size_t, const std::vector<wxString>&, bool = false) override
+  {
+  }
+  void SetQuickSearch(const wxString&) override
+  {
+  }
+  // Only a window of the rows is known, no statistics can be given
+  bool GetColumnSummary(size_t, ColumnSummary&) override
+  {
+    return false;
+  }
+  bool GetColumnWidthSample(size_t, ColumnWidthSample&) override
+  {
+    return false;
+  }
+  void SetRangeFilter(size_t             col,
+                      const std::string& lower,
+                      const std::string& upper,
+                      bool               upperOpen = false) override
+  {
+    if (!m_pProvider || col >= N)
+      return;
+
+    const ColumnInfo<C>& info   = m_pProvider->GetColumnInfo(col);
+    auto&                filter = m_query.filters[col];
+    filter.active   = !lower.empty() || !upper.empty();
+    filter.hasLower = !lower.empty();
+    filter.hasUpper  = !upper.empty();
+    filter.upperOpen = !upper.empty() && upperOpen;
+    filter.lower    = ColumnData<C>::FromText(info.type, lower, info.format);
+    filter.upper    = ColumnData<C>::FromText(info.type, upper, info.format);
+    ResetQuery();
+  }
+  void ClearFilter(size_t col = -1) override
+  {
+    for (size_t i = 0; i < N; ++i)
+    {
+      if (col >= N || col == i)
+      {
+        m_query.filters[i] = typename Query::RangeFilter();
+      }
+    }
+    ResetQuery();
+  }
+  // The provider sorts the whole query, lazyWindow does not apply
+  void SortByColumn(size_t col, bool ascending = true, size_t = 0) override
+  {
+    m_query.sortCol   = col;
+    m_query.ascending = ascending;
+    ResetQuery();
+  }
+  // Take in the pages answered since the last call
+  bool RefineSort() override
+  {
+    DeliverPages();
+    return false;
+  }
+  void FullRefreshList(wxListView* listView) override
+  {
+    if (!m_pProvider || !listView)
+      return;
+
+    listView->Freeze();
+    listView->ClearAll();
+    for (size_t col = 0; col < N; ++col)
+    {
+      const ColumnInfo<C>& info = m_pProvider->GetColumnInfo(col);
+      listView->InsertColumn(col, info.name,
+        info.extraInfo.format, info.extraInfo.width);
+    }
+    listView->Thaw();
+    PartialRefreshList(listView);
+  }
+  void PartialRefreshList(wxListView* listView) override
+  {
+    if (!m_pProvider || !listView || !listView->IsVirtual())
+      return;
+
+    m_pListView = listView;
+    listView->SetItemCount(static_cast<long>(m_nRowCount));
+    listView->Refresh();
+    // Ask for the visible rows (the first page tells the row count)
+    long top = listView->GetTopItem();
+    PrepareItems(top, top + std::max(listView->GetCountPerPage(), 1));
+  }
+  // Rows may have changed at the source, drop the pages holding them
+  void RefreshRows(wxListView* listView, const std::vector<size_t>& ids) override
+  {
+    for (auto it = m_mapPages.begin(); it != m_mapPages.end(); )
+    {
+      bool stale = false;
+      for (size_t id : it->second.ids)
+      {
+        if (std::binary_search(ids.begin(), ids.end(), id))
+        {
+          stale = true;
+          break;
+        }
+      }
+      if (stale)
+      {
+        m_lstLru.erase(it->second.lru);
+        it = m_mapPages.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+    PartialRefreshList(listView);
+  }
+  // The source grew, so the row count and the last pages are asked again
+  void AppendRows(wxListView* listView, const std::vector<size_t>&) override
+  {
+    ResetQuery();
+    PartialRefreshList(listView);
+  }
+  wxString GetItemText(long item, long col) const override
+  {
+    if (item < 0 || col < 0 || static_cast<size_t>(col) >= N)
+      return wxString();
+
+    size_t pageNo = static_cast<size_t>(item) / PAGE_ROWS;
+    size_t index  = static_cast<size_t>(item) % PAGE_ROWS;
+    auto   it     = m_mapPages.find(pageNo);
+    if (it == m_mapPages.end())
+    {
+      RequestPage(pageNo);
+      return wxString();
+    }
+    m_lstLru.splice(m_lstLru.begin(), m_lstLru, it->second.lru);
+    if (index >= it->second.rows.size())
+      return wxString();
+    return it->second.rows[index][col].FormatValueW();
+  }
+  // Request the pages of items [from, to] and prefetch in scroll direction
+  void PrepareItems(long from, long to) override
+  {
+    if (from < 0 || to < from)
+      return;
+
+    if (from != m_nLastFrom)
+    {
+      m_bScrollingDown = from > m_nLastFrom;
+      m_nLastFrom      = from;
+    }
+    size_t first = static_cast<size_t>(from) / PAGE_ROWS;
+    size_t last  = static_cast<size_t>(to)   / PAGE_ROWS;
+    // Nearest pages first, the provider serves the newest request first
+    if (m_bScrollingDown)
+    {
+      for (size_t page = last + PREFETCH_PAGES; page > last; --page)
+      {
+        RequestPage(page);
+      }
+      for (size_t page = last + 1; page-- > first; )
+      {
+        RequestPage(page);
+      }
+    }
+    else
+    {
+      for (size_t page = 1; page <= PREFETCH_PAGES && page <= first; ++page)
+      {
+        RequestPage(first - page);
+      }
+      for (size_t page = first; page <= last; ++page)
+      {
+        RequestPage(page);
+      }
+    }
+  }
+  bool GetRowId(long item, size_t& id) const override
+  {
+    if (item < 0)
+      return false;
+
+    auto it = m_mapPages.find(static_cast<size_t>(item) / PAGE_ROWS);
+    size_t index = static_cast<size_t>(item) % PAGE_ROWS;
+    if (it == m_mapPages.end() || index >= it->second.ids.size())
+      return false;
+
+    id = it->second.ids[index];
+    return true;
+  }
+  // Only rows of cached pages are written
+  void WriteRows(std::string&               out,
+                 const std::vector<size_t>& ids,
+                 char                       separator) const override
+  {
+    std::unordered_map<size_t, const RowData*> rows;
+    for (const auto& pair : m_mapPages)
+    {
+      for (size_t index = 0; index < pair.second.ids.size(); ++index)
+      {
+        rows.emplace(pair.second.ids[index], &pair.second.rows[index]);
+      }
+    }
+    for (size_t id : ids)
+    {
+      auto it = rows.find(id);
+      if (it == rows.end())
+        continue;
+
+      for (size_t col = 0; col < N; ++col)
+      {
+        if (col > 0)
+        {
+          out += separator;
+        }
+        AppendDelimitedCell(out, (*it->second)[col].FormatValue(), separator);
+      }
+      out += '\n';
+    }
+  }
+  // Only rows of cached pages are found
+  bool GetItemIndex(size_t id, long& item) const override
+  {
+    for (const auto& pair : m_mapPages)
+    {
+      const std::vector<size_t>& ids = pair.second.ids;
+      auto found = std::find(ids.begin(), ids.end(), id);
+      if (found != ids.end())
+      {
+        item = static_cast<long>(pair.first * PAGE_ROWS + (found - ids.begin()));
+        return true;
+      }
+    }
+    return false;
+  }
+  const std::vector<size_t>& GetItemRowIds() const override
+  {
+    return m_vNoIds;
+  }
+  // Only rows of cached pages are known to be shown
+  bool IsRowShown(size_t id) const override
+  {
+    long item = 0;
+    return GetItemIndex(id, item);
+  }
+  IdRangeSet GetShownRowIds() const override
+  {
+    std::vector<size_t> ids;
+    for (const auto& pair : m_mapPages)
+    {
+      ids.insert(ids.end(), pair.second.ids.begin(), pair.second.ids.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return IdRangeSet::FromSorted(ids);
+  }
+  // Rows of uncached pages cannot be ordered, they keep ID order
+  void SortRowIds(std::vector<size_t>&) const override
+  {
+  }
+  void BeginTransaction() override
+  {
+  }
+  std::vector<size_t> CommitTransaction() override
+  {
+    return std::vector<size_t>();
+  }
+  // Report the memory held by cached pages
+  TableExMemoryUsage GetMemoryUsage() const override
+  {
+    const size_t INLINE_CAPACITY = std::string().capacity();
+
+    TableExMemoryUsage usage;
+    for (const auto& pair : m_mapPages)
+    {
+      usage.rows     += pair.second.rows.size();
+      usage.rowBytes += pair.second.rows.capacity() * sizeof(RowData)
+                      + pair.second.ids .capacity() * sizeof(size_t);
+      for (const RowData& row : pair.second.rows)
+      {
+        for (const ColumnData<C>& cell : row)
+        {
+          if (cell.str.capacity() > INLINE_CAPACITY)
+          {
+            usage.stringBytes += cell.str.capacity() + 1;
+          }
+        }
+      }
+    }
+    return usage;
+  }
+protected:
+  // Export thread: write the rows of a query to a CSV file
+  void ExportPages(std::string filename, std::string header, Query query, uint64_t generation)
+  {
+    std::ofstream file(filename);
+    if (!file.is_open())
+      return;
+
+    file << header;
+    const size_t EXPORT_ROWS = PAGE_ROWS * 16;
+    std::string  out;
+    for (size_t offset = 0; ; offset += EXPORT_ROWS)
+    {
+      Page page;
+      if (!m_bExportCancelled)
+      {
+        std::promise<Page> answer;
+        std::future<Page>  result = answer.get_future();
+        m_pProvider->RequestPage(query, generation, offset, EXPORT_ROWS,
+          [&answer](Page&& answered)
+        {
+          answer.set_value(std::move(answered));
+        });
+        page = result.get();
+      }
+      if (!page.ok)
+      {
+        // Dropped: the rows asked for are no longer those of the query
+        file.close();
+        std::remove(filename.c_str());
+        return;
+      }
+
+      out.clear();
+      for (const RowData& row : page.rows)
+      {
+        for (size_t col = 0; col < N; ++col)
+        {
+          if (col > 0)
+          {
+            out += ',';
+          }
+          AppendDelimitedCell(out, row[col].FormatValue(), ',');
+        }
+        out += '\n';
+      }
+      file << out;
+      if (page.rows.size() < EXPORT_ROWS)
+        break;
+    }
+  }
+  // Start a new query generation: forget cached and pending pages
+  void ResetQuery()
+  {
+    ++m_nGeneration;
+    if (m_pProvider)
+    {
+      m_pProvider->CancelBefore(m_nGeneration);
+    }
+    m_mapPages.clear();
+    m_lstLru.clear();
+    m_setPending.clear();
+    m_bRowCountExact = false;
+  }
+  // Ask the provider for a page unless it is cached, pending or past the end
+  void RequestPage(size_t pageNo) const
+  {
+    if (!m_pProvider || m_mapPages.count(pageNo) || m_setPending.count(pageNo))
+      return;
+    if (m_bRowCountExact && pageNo > 0 && pageNo * PAGE_ROWS >= m_nRowCount)
+      return;
+
+    m_setPending.insert(pageNo);
+    std::shared_ptr<Inbox> inbox = m_pInbox;
+    m_pProvider->RequestPage(m_query, m_nGeneration, pageNo * PAGE_ROWS, PAGE_ROWS,
+      [inbox](Page&& page)
+    {
+      {
+        std::lock_guard<std::mutex> lock(inbox->mutex);
+        inbox->pages.push_back(std::move(page));
+      }
+      wxWakeUpIdle();
+    });
+  }
+  // Move answered pages into the cache and redraw them
+  void DeliverPages()
+  {
+    std::vector<Page> pages;
+    {
+      std::lock_guard<std::mutex> lock(m_pInbox->mutex);
+      pages.swap(m_pInbox->pages);
+    }
+
+    bool countChanged = false;
+    for (Page& page : pages)
+    {
+      if (page.generation != m_nGeneration)
+        continue;
+
+      size_t pageNo = page.offset / PAGE_ROWS;
+      m_setPending.erase(pageNo);
+      if (!page.ok)
+        continue;
+
+      if (!m_bRowCountExact || page.totalExact)
+      {
+        countChanged     = countChanged || page.totalRows != m_nRowCount
+                                        || page.totalExact != m_bRowCountExact;
+        m_nRowCount      = page.totalRows;
+        m_bRowCountExact = page.totalExact;
+      }
+
+      auto it = m_mapPages.find(pageNo);
+      if (it == m_mapPages.end())
+      {
+        m_lstLru.push_front(pageNo);
+        it = m_mapPages.emplace(pageNo, CachedPage()).first;
+        it->second.lru = m_lstLru.begin();
+      }
+      it->second.ids .swap(page.ids);
+      it->second.rows.swap(page.rows);
+      while (m_mapPages.size() > MAX_PAGES)
+      {
+        m_mapPages.erase(m_lstLru.back());
+        m_lstLru.pop_back();
+      }
+
+      if (m_pListView && !countChanged && !it->second.rows.empty())
+      {
+        m_pListView->RefreshItems(static_cast<long>(page.offset),
+          static_cast<long>(page.offset + it->second.rows.size() - 1));
+      }
+    }
+    if (m_pListView && countChanged)
+    {
+      m_pListView->SetItemCount(static_cast<long>(m_nRowCount));
+      m_pListView->Refresh();
+    }
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_PAGED_TABLE_EX_ADAPTER_H_
@@ -0,0 +1,212 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include "TableEx.hpp"
+#include "TableExAdapter.hpp"
+#include "TableExTrace.h"
+#include "RecordingTableExAdapter.h"
+
+RecordingTableExAdapter::RecordingTableExAdapter(ITableExAdapter* adapter, TableExTraceWriter* writer)
+  : m_pAdapter(adapter)
+  , m_pWriter (writer)
+{
+}
+
+void RecordingTableExAdapter::ExportToCSV(const std::string& filename)
+{
+  m_pAdapter->ExportToCSV(filename);
+}
+
+void RecordingTableExAdapter::WriteRows(std::string&               out,
+                                        const std::vector<size_t>& ids,
+                                        char                       separator) const
+{
+  m_pAdapter->WriteRows(out, ids, separator);
+}
+
+void RecordingTableExAdapter::SetFilter(size_t col, std::function<bool(const void*)> filter)
+{
+  RecordColumnOp(filter ? TableExTraceOp::FUNCTION_FILTER : TableExTraceOp::CLEAR_FILTER, col);
+  m_pAdapter->SetFilter(col, filter);
+}
+
+void RecordingTableExAdapter::SetRangeFilter(size_t             col,
+                                             const std::string& lower,
+                                             const std::string& upper,
+                                             bool               upperOpen)
+{
+  RecordColumnOp(TableExTraceOp::RANGE_FILTER, col, { lower, upper },
+    upperOpen ? TableExTraceRecord::UPPER_OPEN : 0);
+  m_pAdapter->SetRangeFilter(col, lower, upper, upperOpen);
+}
+
+void RecordingTableExAdapter::SetValueFilter(size_t                       col,
+                                             const std::vector<wxString>& values,
+                                             bool                         exclude)
+{
+  std::vector<std::string> texts;
+  texts.reserve(values.size());
+  for (const wxString& value : values)
+  {
+    texts.push_back(value.utf8_string());
+  }
+  RecordColumnOp(TableExTraceOp::VALUE_FILTER, col, texts,
+    exclude ? TableExTraceRecord::EXCLUDE : 0);
+  m_pAdapter->SetValueFilter(col, values, exclude);
+}
+
+void RecordingTableExAdapter::ClearFilter(size_t col)
+{
+  RecordColumnOp(TableExTraceOp::CLEAR_FILTER, col);
+  m_pAdapter->ClearFilter(col);
+}
+
+void RecordingTableExAdapter::SetQuickSearch(const wxString& text)
+{
+  TableExTraceRecord record;
+  record.op = TableExTraceOp::QUICK_SEARCH;
+  record.texts.push_back(text.utf8_string());
+  m_pWriter->Write(record);
+  m_pAdapter->SetQuickSearch(text);
+}
+
+bool RecordingTableExAdapter::GetColumnSummary(size_t col, ColumnSummary& summary)
+{
+  return m_pAdapter->GetColumnSummary(col, summary);
+}
+
+bool RecordingTableExAdapter::GetColumnWidthSample(size_t col, ColumnWidthSample& sample)
+{
+  return m_pAdapter->GetColumnWidthSample(col, sample);
+}
+
+void RecordingTableExAdapter::SortByColumn(size_t col, bool ascending, size_t lazyWindow)
+{
+  TableExTraceRecord record;
+  record.op     = TableExTraceOp::SORT;
+  record.target = col;
+  record.flags  = ascending ? 1 : 0;
+  record.first  = lazyWindow;
+  m_pWriter->Write(record);
+  m_pAdapter->SortByColumn(col, ascending, lazyWindow);
+}
+
+bool RecordingTableExAdapter::RefineSort()
+{
+  return m_pAdapter->RefineSort();
+}
+
+void RecordingTableExAdapter::FullRefreshList(wxListView* listView)
+{
+  RecordRefresh(TableExTraceRefresh::FULL, listView, 0);
+  m_pAdapter->FullRefreshList(listView);
+}
+
+void RecordingTableExAdapter::PartialRefreshList(wxListView* listView)
+{
+  RecordRefresh(TableExTraceRefresh::PARTIAL, listView, 0);
+  m_pAdapter->PartialRefreshList(listView);
+}
+
+void RecordingTableExAdapter::RefreshRows(wxListView* listView, const std::vector<size_t>& ids)
+{
+  RecordRefresh(TableExTraceRefresh::ROWS, listView, ids.size());
+  m_pAdapter->RefreshRows(listView, ids);
+}
+
+void RecordingTableExAdapter::AppendRows(wxListView* listView, const std::vector<size_t>& ids)
+{
+  RecordRefresh(TableExTraceRefresh::APPEND, listView, ids.size());
+  m_pAdapter->AppendRows(listView, ids);
+}
+
+wxString RecordingTableExAdapter::GetItemText(long item, long col) const
+{
+  return m_pAdapter->GetItemText(item, col);
+}
+
+void RecordingTableExAdapter::PrepareItems(long from, long to)
+{
+  m_pAdapter->PrepareItems(from, to);
+}
+
+bool RecordingTableExAdapter::GetRowId(long item, size_t& id) const
+{
+  return m_pAdapter->GetRowId(item, id);
+}
+
+bool RecordingTableExAdapter::GetItemIndex(size_t id, long& item) const
+{
+  return m_pAdapter->GetItemIndex(id, item);
+}
+
+const std::vector<size_t>& RecordingTableExAdapter::GetItemRowIds() const
+{
+  return m_pAdapter->GetItemRowIds();
+}
+
+bool RecordingTableExAdapter::IsRowShown(size_t id) const
+{
+  return m_pAdapter->IsRowShown(id);
+}
+
+IdRangeSet RecordingTableExAdapter::GetShownRowIds() const
+{
+  return m_pAdapter->GetShownRowIds();
+}
+
+void RecordingTableExAdapter::SortRowIds(std::vector<size_t>& ids) const
+{
+  m_pAdapter->SortRowIds(ids);
+}
+
+void RecordingTableExAdapter::BeginTransaction()
+{
+  m_pAdapter->BeginTransaction();
+}
+
+std::vector<size_t> RecordingTableExAdapter::CommitTransaction()
+{
+  return m_pAdapter->CommitTransaction();
+}
+
+TableExMemoryUsage RecordingTableExAdapter::GetMemoryUsage() const
+{
+  return m_pAdapter->GetMemoryUsage();
+}
+
+void RecordingTableExAdapter::RecordColumnOp(TableExTraceOp                  op,
+                                             size_t                          col,
+                                             const std::vector<std::string>& texts,
+                                             uint64_t                        flags)
+{
+  TableExTraceRecord record;
+  record.op     = op;
+  record.target = col;
+  record.flags  = flags;
+  record.texts  = texts;
+  m_pWriter->Write(record);
+}
+
+void RecordingTableExAdapter::RecordRefresh(TableExTraceRefresh kind, wxListView* listView, size_t rows)
+{
+  if (!listView)
+    return;
+
+  TableExTraceRecord record;
+  record.op     = TableExTraceOp::REFRESH;
+  record.flags  = static_cast<uint64_t>(kind);
+  record.target = rows;
+  record.first  = static_cast<uint64_t>((std::max)(listView->GetTopItem(), 0L));
+  record.count  = static_cast<uint64_t>((std::max)(listView->GetCountPerPage(), 1));
+  m_pWriter->Write(record);
+}
@@ -0,0 +1,89 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_RECORDING_TABLE_EX_ADAPTER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_RECORDING_TABLE_EX_ADAPTER_H_
+
+/*****************************************************************************
+ *
+ * CLASS   : RecordingTableExAdapter
+ * PURPOSE : Adapter recording the sorts, filters and refreshes a list asks
+ *           of another adapter
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Every call is passed on to the wrapped adapter. Give the list
+ *           this adapter while a TableExRecorder records the table, with
+ *           its writer, so that a replay sees the list operations in
+ *           between the row writes. Refreshes are recorded as they start,
+ *           with the items visible then.
+ *
+ *****************************************************************************/
+
+class RecordingTableExAdapter : public ITableExAdapter
+{
+public:
+  RecordingTableExAdapter(ITableExAdapter* adapter, TableExTraceWriter* writer);
+
+  void            ExportToCSV(const std::string& filename) override;
+  void              WriteRows(std::string& out,
+                              const std::vector<size_t>& ids,
+                              char separator) const override;
+  void              SetFilter(size_t col, std::function<bool(
+                                          const void*)> filter) override;
+  void         SetRangeFilter(size_t col,
+                              const std::string& lower,
+                              const std::string& upper,
+                              bool upperOpen = false) override;
+  void         SetValueFilter(size_t col,
+                              const std::vector<wxString>& values,
+                              bool exclude = false) override;
+  void            ClearFilter(size_t col = -1) override;
+  void         SetQuickSearch(const wxString& text) override;
+  bool       GetColumnSummary(size_t col,
+                              ColumnSummary& summary) override;
+  bool   GetColumnWidthSample(size_t col,
+                              ColumnWidthSample& sample) override;
+  void           SortByColumn(size_t col,
+                              bool ascending = true,
+                              size_t lazyWindow = 0) override;
+  bool             RefineSort(                    ) override;
+  void     FullRefreshList   (wxListView* listView) override;
+  void  PartialRefreshList   (wxListView* listView) override;
+  void         RefreshRows   (wxListView* listView,
+                              const std::vector<size_t>& ids) override;
+  void          AppendRows   (wxListView* listView,
+                              const std::vector<size_t>& ids) override;
+  wxString     GetItemText   (long item, long col) const override;
+  void        PrepareItems   (long from, long to) override;
+  bool            GetRowId   (long item, size_t& id) const override;
+  bool        GetItemIndex   (size_t id, long& item) const override;
+  const std::vector<size_t>&
+              GetItemRowIds  (                    ) const override;
+  bool           IsRowShown  (size_t id) const override;
+  IdRangeSet   GetShownRowIds(                    ) const override;
+  void             SortRowIds(std::vector<size_t>& ids) const override;
+  void    BeginTransaction   (                    ) override;
+  std::vector<size_t>
+         CommitTransaction   (                    ) override;
+  TableExMemoryUsage
+            GetMemoryUsage   (                    ) const override;
+protected:
+  // Record an operation on a column, with texts
+  void RecordColumnOp(TableExTraceOp                  op,
+                      size_t                          col,
+                      const std::vector<std::string>& texts = std::vector<std::string>(),
+                      uint64_t                        flags = 0);
+  // Record a refresh starting now, of rows rows
+  void RecordRefresh (TableExTraceRefresh kind, wxListView* listView, size_t rows);
+protected:
+  ITableExAdapter       *m_pAdapter;
+  TableExTraceWriter    *m_pWriter;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_RECORDING_TABLE_EX_ADAPTER_H_
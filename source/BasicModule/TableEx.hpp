@@ -12,14 +12,227 @@
 #define   GUI_WXWIDGETS_MAIN_APP_TABLE_VIEW_EX_H_
 
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
 #include <array>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <set>
+#include <iterator>
 #include <functional>
+#include <utility>
+#include <memory_resource>
+#include "IdRangeSet.h"
+#include "ColumnSketch.h"
+#include "TrigramIndex.h"
+#include "TextWidthStats.h"
+#include "MemoryResourceEx.hpp"
 
 #ifdef _MSC_VER
 #define snprintf _snprintf_s
 #endif
 
+/*****************************************************************************
+ *
+ * FUNCTION: Utf8ToWide / WideToUtf8
+ * PURPOSE : Transcoding between UTF-8 cell storage and wide strings
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: ASCII runs are handled 8 bytes at a time. wchar_t may be
+ *           UTF-16 (Windows, surrogate pairs) or UTF-32. Malformed input
+ *           is replaced with U+FFFD.
+ *
+ *****************************************************************************/
+
+inline std::wstring Utf8ToWide(const char* data, size_t size)
+{
+  const uint64_t ASCII_MASK = 0x8080808080808080ULL;
+
+  // Never more code units than input bytes
+  std::wstring result(size, L'\0');
+  wchar_t*             out = size ? &result[0] : nullptr;
+  const unsigned char* p   = reinterpret_cast<const unsigned char*>(data);
+  const unsigned char* end = p + size;
+
+  while (p < end)
+  {
+    // Widen runs of 8 ASCII bytes without decoding
+    uint64_t word;
+    while (end - p >= 8
+      && (memcpy(&word, p, 8), (word & ASCII_MASK) == 0))
+    {
+      for (int i = 0; i < 8; ++i)
+      {
+        out[i] = static_cast<wchar_t>(p[i]);
+      }
+      p   += 8;
+      out += 8;
+    }
+    if (p >= end)
+      break;
+
+    uint32_t c = *p;
+    if (c < 0x80)
+    {
+      *out++ = static_cast<wchar_t>(c);
+      ++p;
+      continue;
+    }
+
+    // Decode one multi-byte sequence
+    size_t   length = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC0) ? 2 : 0;
+    uint32_t cp     = (length == 4) ? (c & 0x07)
+                    : (length == 3) ? (c & 0x0F) : (c & 0x1F);
+    bool     valid  = length != 0 && c < 0xF5
+                   && static_cast<size_t>(end - p) >= length;
+    for (size_t i = 1; valid && i < length; ++i)
+    {
+      valid = (p[i] & 0xC0) == 0x80;
+      cp    = (cp << 6) | (p[i] & 0x3F);
+    }
+    // Reject overlong forms, surrogates and values above U+10FFFF
+    static const uint32_t MIN_CODE_POINT[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    valid = valid && cp >= MIN_CODE_POINT[length] && cp <= 0x10FFFF
+                  && (cp < 0xD800 || cp > 0xDFFF);
+    if (!valid)
+    {
+      *out++ = static_cast<wchar_t>(0xFFFD);
+      ++p;
+      continue;
+    }
+    p += length;
+
+    if (sizeof(wchar_t) == 2 && cp >= 0x10000)
+    {
+      cp -= 0x10000;
+      *out++ = static_cast<wchar_t>(0xD800 + (cp >> 10));
+      *out++ = static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+    }
+    else
+    {
+      *out++ = static_cast<wchar_t>(cp);
+    }
+  }
+
+  result.resize(out ? static_cast<size_t>(out - &result[0]) : 0);
+  return result;
+}
+
+inline std::wstring Utf8ToWide(const std::string& str)
+{
+  return Utf8ToWide(str.data(), str.size());
+}
+
+inline std::string WideToUtf8(const wchar_t* data, size_t size)
+{
+  std::string result;
+  result.reserve(size);
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    uint32_t cp = static_cast<uint32_t>(data[i]);
+    if (cp < 0x80)
+    {
+      result.push_back(static_cast<char>(cp));
+      continue;
+    }
+
+    // Combine UTF-16 surrogate pairs, lone surrogates become U+FFFD
+    if (cp >= 0xD800 && cp <= 0xDFFF)
+    {
+      if (sizeof(wchar_t) == 2 && cp < 0xDC00 && i + 1 < size
+        && data[i + 1] >= 0xDC00 && data[i + 1] <= 0xDFFF)
+      {
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (data[++i] - 0xDC00);
+      }
+      else
+      {
+        cp = 0xFFFD;
+      }
+    }
+    if (cp > 0x10FFFF)
+    {
+      cp = 0xFFFD;
+    }
+
+    if (cp < 0x800)
+    {
+      result.push_back(static_cast<char>(0xC0 |  (cp >> 6)));
+    }
+    else if (cp < 0x10000)
+    {
+      result.push_back(static_cast<char>(0xE0 |  (cp >> 12)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    }
+    else
+    {
+      result.push_back(static_cast<char>(0xF0 |  (cp >> 18)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    }
+    result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+  return result;
+}
+
+inline std::string WideToUtf8(const std::wstring& wstr)
+{
+  return WideToUtf8(wstr.data(), wstr.size());
+}
+
+/*****************************************************************************
+ *
+ * FUNCTION: SplitCsvLine
+ * PURPOSE : Split one CSV line into its fields
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Fields may be quoted, "" inside quotes is an escaped quote.
+ *           A trailing CR is dropped.
+ *
+ *****************************************************************************/
+
+inline void SplitCsvLine(const std::string& line, std::vector<std::string>& fields)
+{
+  fields.clear();
+  std::string field;
+  bool        quoted = false;
+  for (size_t i = 0; i < line.size(); ++i)
+  {
+    char c = line[i];
+    if (quoted)
+    {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+      {
+        field.push_back('"');
+        ++i;
+      }
+      else if (c == '"')
+      {
+        quoted = false;
+      }
+      else
+      {
+        field.push_back(c);
+      }
+    }
+    else if (c == '"')
+    {
+      quoted = true;
+    }
+    else if (c == ',')
+    {
+      fields.push_back(field);
+      field.clear();
+    }
+    else if (c != '\r')
+    {
+      field.push_back(c);
+    }
+  }
+  fields.push_back(field);
+}
+
 /*****************************************************************************
  *
  * STRUCT  : ColumnInfo
@@ -85,8 +298,7 @@ struct ColumnData
     float          f;
     double         d;
   }                value;    // Storing numeric data
-  std::string      str;      // Storing       string
-  std::wstring     wstr;     // Storing wide  string
+  std::string      str;      // Storing string as UTF-8 (STRING and WSTRING)
 
   // Constructors
   ColumnData(                         ) : type(ColumnType::INT32      ) { value.i32    = 0;  }
@@ -97,225 +309,2500 @@ struct ColumnData
   ColumnData(float                   v) : type(ColumnType::FLOAT      ) { value.f      = v;  }
   ColumnData(double                  v) : type(ColumnType::DOUBLE     ) { value.d      = v;  }
   ColumnData(const std::string&      v) : type(ColumnType::STRING     ),      str       (v) {}
-  ColumnData(const std::wstring&     v) : type(ColumnType::WSTRING    ),      wstr      (v) {}
+  ColumnData(const char*             v) : type(ColumnType::STRING     ),      str       (v) {}
+  ColumnData(const std::wstring&     v) : type(ColumnType::WSTRING    ),      str       (WideToUtf8(v)) {}
+  ColumnData(const wchar_t*          v) : type(ColumnType::WSTRING    ),      str       (WideToUtf8(v, wcslen(v))) {}
+
+  // Check if this value is stored in str
+  bool IsString() const
+  {
+    return type == ColumnType::STRING || type == ColumnType::WSTRING;
+  }
 
-  // Format value based on column format
+  // Format value based on column format (UTF-8)
   std::string FormatValue() const
   {
-    if (type == ColumnType::STRING)
+    if (IsString())
       return str;
-    if (type == ColumnType::WSTRING)
-      return std::string(wstr.begin(), wstr.end());
-    if (!columnInfo)
-      return "";
 
     const size_t     BUFFER_SIZE = 256;
     char      buffer[BUFFER_SIZE];
-
-    snprintf(buffer,
-      BUFFER_SIZE,
-      columnInfo->format.c_str(),
-      value.d);
-    return std::string(buffer);
+    return std::string(buffer, FormatNumber(buffer, BUFFER_SIZE));
   }
 
   // Format value for wide character output
   std::wstring FormatValueW() const
   {
-    if (type == ColumnType::STRING)
-      return std::wstring(str.begin(), str.end());
-    if (type == ColumnType::WSTRING)
-      return wstr;
-    if (!columnInfo)
-      return L"";
+    if (IsString())
+      return Utf8ToWide(str);
+
+    // Formatted numbers are ASCII, widening them needs no decoding
+    const size_t     BUFFER_SIZE = 256;
+    char      buffer[BUFFER_SIZE];
+    size_t    length = FormatNumber(buffer, BUFFER_SIZE);
+    return std::wstring(buffer, buffer + length);
+  }
+
+  // Format a numeric value into buffer, returns the length written
+  size_t FormatNumber(char* buffer, size_t size) const
+  {
+    if (!columnInfo || size == 0)
+      return 0;
+
+    const char* format = columnInfo->format.c_str();
+    int         length = 0;
+    switch (type)
+    {
+    case ColumnType::INT32:  length = snprintf(buffer, size, format, value.i32); break;
+    case ColumnType::INT64:  length = snprintf(buffer, size, format, value.i64); break;
+    case ColumnType::UINT32: length = snprintf(buffer, size, format, value.u32); break;
+    case ColumnType::UINT64: length = snprintf(buffer, size, format, value.u64); break;
+    case ColumnType::FLOAT:  length = snprintf(buffer, size, format, value.f  ); break;
+    case ColumnType::DOUBLE: length = snprintf(buffer, size, format, value.d  ); break;
+    default:                 break;
+    }
+    if (length < 0)
+      return 0;
+    return (static_cast<size_t>(length) < size) ? length : size - 1;
+  }
+
+  // Get a numeric value as double, false for strings
+  bool ToNumber(double& number) const
+  {
+    switch (type)
+    {
+    case ColumnType::INT32:  number = static_cast<double>(value.i32); return true;
+    case ColumnType::INT64:  number = static_cast<double>(value.i64); return true;
+    case ColumnType::UINT32: number = static_cast<double>(value.u32); return true;
+    case ColumnType::UINT64: number = static_cast<double>(value.u64); return true;
+    case ColumnType::FLOAT:  number = static_cast<double>(value.f  ); return true;
+    case ColumnType::DOUBLE: number =                     value.d   ; return true;
+    default:                 return false;
+    }
+  }
+
+  // Hash of the value, equal values (same type) hash equal
+  uint64_t Hash() const
+  {
+    uint64_t bits = 0;
+    switch (type)
+    {
+    case ColumnType::INT32:  bits = static_cast<uint64_t>(static_cast<int64_t>(value.i32)); break;
+    case ColumnType::INT64:  bits = static_cast<uint64_t>(value.i64);                       break;
+    case ColumnType::UINT32: bits = value.u32;                                              break;
+    case ColumnType::UINT64: bits = value.u64;                                              break;
+    case ColumnType::FLOAT:  { uint32_t f = 0; memcpy(&f, &value.f, sizeof(f)); bits = f; } break;
+    case ColumnType::DOUBLE: memcpy(&bits, &value.d, sizeof(bits));                         break;
+    default:                 bits = std::hash<std::string>()(str);                          break;
+    }
+    return MixHash(bits);
+  }
 
-    const     size_t BUFFER_SIZE = 256;
-    wchar_t   buffer[BUFFER_SIZE];
+  // Parse text into a value of the given type, hex formats are read as hex
+  static ColumnData FromText(ColumnType         type,
+                             const std::string& text,
+                             const std::string& format = "")
+  {
+    int base = (format.find_first_of("xX") != std::string::npos) ? 16 : 10;
+    const char* p = text.c_str();
 
-    swprintf(buffer,
-      BUFFER_SIZE,
-      std::wstring(columnInfo->format.begin(), columnInfo->format.end()).c_str(),
-      value.d);
-    return std::wstring(buffer);
+    switch (type)
+    {
+    case ColumnType::INT32:
+      return ColumnData(static_cast<int32_t >(strtol  (p, nullptr, base)));
+    case ColumnType::INT64:
+      return ColumnData(static_cast<int64_t >(strtoll (p, nullptr, base)));
+    case ColumnType::UINT32:
+      return ColumnData(static_cast<uint32_t>(strtoul (p, nullptr, base)));
+    case ColumnType::UINT64:
+      return ColumnData(static_cast<uint64_t>(strtoull(p, nullptr, base)));
+    case ColumnType::FLOAT:
+      return ColumnData(strtof(p, nullptr));
+    case ColumnType::DOUBLE:
+      return ColumnData(strtod(p, nullptr));
+    case ColumnType::WSTRING:
+    {
+      ColumnData result(text);
+      result.type = ColumnType::WSTRING;
+      return result;
+    }
+    case ColumnType::STRING:
+    default:
+      return ColumnData(text);
+    }
   }
 };
 
 /*****************************************************************************
  *
- * STRUCT  : TableEx
- * PURPOSE : Template-based table element processing class
+ * STRUCT  : ColumnDataCompare
+ * PURPOSE : Ordering of ColumnData values, used by sorting and indexes
  * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
- * COMMENTS: Support batch creation, updating, sorting and filtering
+ * COMMENTS: Both values are expected to have the same ColumnType
  *
  *****************************************************************************/
 
-template <typename C, size_t N>
-class TableEx
+template <typename C>
+struct ColumnDataCompare
+{
+  using ColumnType = typename ColumnInfo<C>::ColumnType;
+
+  // Three-way comparison: negative if a < b, zero if equal, positive if a > b
+  static int Compare(const ColumnData<C>& a, const ColumnData<C>& b)
+  {
+    switch (a.type)
+    {
+    case ColumnType::INT32:   return ThreeWay(a.value.i32, b.value.i32);
+    case ColumnType::INT64:   return ThreeWay(a.value.i64, b.value.i64);
+    case ColumnType::UINT32:  return ThreeWay(a.value.u32, b.value.u32);
+    case ColumnType::UINT64:  return ThreeWay(a.value.u64, b.value.u64);
+    case ColumnType::FLOAT:   return ThreeWay(a.value.f  , b.value.f  );
+    case ColumnType::DOUBLE:  return ThreeWay(a.value.d  , b.value.d  );
+    // UTF-8 byte order is code point order
+    case ColumnType::STRING:
+    case ColumnType::WSTRING: return a.str.compare(b.str);
+    default:
+      // Unsupported compare type
+      return 0;
+    }
+  }
+  // Strict weak ordering for ordered containers
+  bool operator()(const ColumnData<C>& a, const ColumnData<C>& b) const
+  {
+    return Compare(a, b) < 0;
+  }
+private:
+  template <typename T>
+  static int ThreeWay(const T& a, const T& b)
+  {
+    return (a < b) ? -1 : ((b < a) ? 1 : 0);
+  }
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : ColumnStats
+ * PURPOSE : Value statistics of one column, kept up to date row by row
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Each distinct value is counted exactly until there are more
+ *           than EXACT_VALUES of them. From then on a HyperLogLog estimates
+ *           the distinct count, a count-min sketch the frequencies, and only
+ *           the TOP_VALUES most frequent values are kept (with estimated
+ *           counts). Numeric columns also keep an equi-width histogram of
+ *           HISTOGRAM_BINS bins that doubles its bin width whenever a value
+ *           falls outside. Add and Remove cost O(log EXACT_VALUES), so
+ *           reading the statistics never needs a scan of the rows.
+ *
+ *****************************************************************************/
+
+template <typename C>
+class ColumnStats
 {
 public:
-  using RowData = std::array<ColumnData<C>, N>;
-protected:
-  // Column metadata
-  std::array<ColumnInfo<C>, N>     m_arrColumnInfo;
-  // Store rows using a map for ID lookup
-  std::map<size_t, RowData>        m_vRows;
-  // Cached sorted rows
-  std::vector<RowData>             m_vSortedRows;
-  // Indicates if sorting is valid
-  bool                             m_bSortedValid = false;
-public:
-  // Get column metadata by index (returns reference to avoid copy overhead)
-  const ColumnInfo<C>& GetColumnInfo(size_t col) const
+  using ColumnType = typename ColumnInfo<C>::ColumnType;
+  // Values with their (estimated) counts, in value order
+  using ValueMap   = std::pmr::map<ColumnData<C>, size_t, ColumnDataCompare<C>>;
+
+  // Distinct values counted exactly
+  static const size_t EXACT_VALUES   = 1024;
+  // Most frequent values kept once counting is estimated
+  static const size_t TOP_VALUES     = 64;
+  // Bins of the numeric histogram
+  static const size_t HISTOGRAM_BINS = 64;
+
+  // Histogram bin covering [lower, upper)
+  struct Bin
+  {
+    double                   lower;
+    double                   upper;
+    size_t                   count;
+  };
+
+  explicit ColumnStats(
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : m_mapValues(resource)
+    , m_hll      (resource)
+    , m_countMin (resource)
+    , m_vBins    (resource)
   {
-    static ColumnInfo<C> dummyColumn = {};
-    return (col < N) ? m_arrColumnInfo[col] : dummyColumn;
   }
-  // Set column metadata
-  void SetColumnInfo(size_t col, const ColumnInfo<C>& info)
+  // Count a value
+  void Add(const ColumnData<C>& value)
   {
-    if (col < N)
+    ++m_nValues;
+    UpdateHistogram(value, true);
+    if (m_bExact)
     {
-      m_arrColumnInfo[col] = info;
+      auto it = m_mapValues.find(value);
+      if (it != m_mapValues.end())
+      {
+        ++it->second;
+        return;
+      }
+      m_mapValues.emplace(value, 1);
+      if (m_mapValues.size() > EXACT_VALUES)
+      {
+        SwitchToSketches();
+      }
+      return;
     }
+
+    uint64_t hash = value.Hash();
+    m_hll     .Add(hash);
+    m_countMin.Add(hash);
+    UpdateCandidate(value, m_countMin.Estimate(hash));
   }
-  // Set filter function for a specific column
-  void SetFilter(size_t col, std::function<bool(const void*)> filter)
+  // Take back a value counted before
+  void Remove(const ColumnData<C>& value)
   {
-    if (col < N)
+    if (m_nValues == 0)
+      return;
+
+    --m_nValues;
+    UpdateHistogram(value, false);
+    if (m_bExact)
     {
-      m_arrColumnInfo[col].filter = filter;
+      auto it = m_mapValues.find(value);
+      if (it != m_mapValues.end() && --it->second == 0)
+      {
+        m_mapValues.erase(it);
+      }
+      return;
+    }
+
+    uint64_t hash = value.Hash();
+    m_countMin.Remove(hash);
+    auto it = m_mapValues.find(value);
+    if (it != m_mapValues.end())
+    {
+      it->second      = m_countMin.Estimate(hash);
+      m_nMinCandidate = (std::min)(m_nMinCandidate, it->second);
+      if (it->second == 0)
+      {
+        m_mapValues.erase(it);
+      }
     }
   }
-  // Clear filter for a specific column or all columns if col is out of range
-  void ClearFilter(size_t col = -1)
+  // Forget every value and count exactly again
+  void Clear()
   {
-    if (col < N)
+    m_mapValues.clear();
+    m_bExact        = true;
+    m_nValues       = 0;
+    m_nMinCandidate = 0;
+    m_hll     .Clear();
+    m_countMin.Clear();
+    // Give the bins back, they may come from an arena about to be released
+    std::pmr::vector<size_t>(m_vBins.get_allocator()).swap(m_vBins);
+    m_dBinLower     = 0.0;
+    m_dBinWidth     = 0.0;
+  }
+  // Check if counts are exact, rather than estimated by sketches
+  bool IsExact() const
+  {
+    return m_bExact;
+  }
+  // Number of values counted
+  size_t GetValueCount() const
+  {
+    return m_nValues;
+  }
+  // Number of distinct values, estimated unless IsExact. The estimate still
+  // includes values that were updated away.
+  size_t GetDistinctCount() const
+  {
+    return m_bExact ? m_mapValues.size()
+                    : (std::max)(m_hll.Estimate(), m_mapValues.size());
+  }
+  // Number of times a value was counted, an upper bound unless IsExact
+  size_t GetFrequency(const ColumnData<C>& value) const
+  {
+    if (m_bExact)
     {
-      m_arrColumnInfo[col].filter = nullptr;
+      auto it = m_mapValues.find(value);
+      return (it != m_mapValues.end()) ? it->second : 0;
     }
-    else
+    return m_countMin.Estimate(value.Hash());
+  }
+  // Every value when IsExact, otherwise the most frequent ones
+  const ValueMap& GetValues() const
+  {
+    return m_mapValues;
+  }
+  // Histogram of a numeric column from its first to its last non-empty bin
+  std::vector<Bin> GetHistogram() const
+  {
+    std::vector<Bin> bins;
+    size_t first = 0;
+    size_t last  = m_vBins.size();
+    while (first < last && m_vBins[first] == 0)
     {
-      for (auto& colInfo : m_arrColumnInfo)
-      {
-        colInfo.filter = nullptr;
-      }
+      ++first;
+    }
+    while (last > first && m_vBins[last - 1] == 0)
+    {
+      --last;
+    }
+    for (size_t i = first; i < last; ++i)
+    {
+      double lower = m_dBinLower + m_dBinWidth * static_cast<double>(i);
+      bins.push_back({ lower, lower + m_dBinWidth, m_vBins[i] });
     }
+    return bins;
   }
-  // Insert or update a row
-  void UpsertRow(size_t id, std::array<ColumnData<C>, N> row)
+  // Bytes held by the statistics
+  size_t GetBytes() const
   {
-    // Link column info
-    for (size_t i = 0; i < N; ++i)
+    // A red-black tree node carries a color and three links on top of its value
+    const size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+    size_t bytes = m_mapValues.size()
+      * (sizeof(typename ValueMap::value_type) + TREE_NODE_OVERHEAD);
+    for (const auto& pair : m_mapValues)
     {
-      row[i].columnInfo = &m_arrColumnInfo[i];
+      bytes += pair.first.str.capacity() > std::string().capacity()
+             ? pair.first.str.capacity() + 1 : 0;
     }
-
-    m_vRows[id] = row;
-
-    // Invalidate sorted data
-    m_bSortedValid = false;
-  }
-  // Sort rows by a specific column
-  void SortByColumn(size_t col, bool ascending = true)
-  {
-    std::vector<std::pair<size_t, RowData>> sortedRows(
-      m_vRows.begin(), m_vRows.end());
-
-    std::sort(
-      sortedRows.begin(),
-      sortedRows.end(),
-      [col, ascending](
-        const std::pair<size_t, RowData>& a,
-        const std::pair<size_t, RowData>& b)
-    {
-      const ColumnData<C>& left   = a.second[col];
-      const ColumnData<C>& right  = b.second[col];
-
-      switch (left.type)
-      {
-      case ColumnInfo<C>::ColumnType::INT32:
-        return ascending ? left.value.i32   < right.value.i32
-                         : left.value.i32   > right.value.i32;
-      case ColumnInfo<C>::ColumnType::INT64:
-        return ascending ? left.value.i64   < right.value.i64
-                         : left.value.i64   > right.value.i64;
-      case ColumnInfo<C>::ColumnType::UINT32:
-        return ascending ? left.value.u32   < right.value.u32
-                         : left.value.u32   > right.value.u32;
-      case ColumnInfo<C>::ColumnType::UINT64:
-        return ascending ? left.value.u64   < right.value.u64
-                         : left.value.u64   > right.value.u64;
-      case ColumnInfo<C>::ColumnType::FLOAT:
-        return ascending ? left.value.f     < right.value.f
-                         : left.value.f     > right.value.f;
-      case ColumnInfo<C>::ColumnType::DOUBLE:
-        return ascending ? left.value.d     < right.value.d
-                         : left.value.d     > right.value.d;
-      case ColumnInfo<C>::ColumnType::STRING:
-        return ascending ? left.str         < right.str
-                         : left.str         > right.str;
-      case ColumnInfo<C>::ColumnType::WSTRING:
-        return ascending ? left.wstr        < right.wstr
-                         : left.wstr        > right.wstr;
-      default:
-        // Unsupported sort type
-        return false;
-      }
+    return bytes + m_hll.GetBytes() + m_countMin.GetBytes()
+         + m_vBins.capacity() * sizeof(size_t);
+  }
+protected:
+  // Too many distinct values: move the counts into the sketches and keep
+  // only the most frequent values
+  void SwitchToSketches()
+  {
+    std::vector<typename ValueMap::const_iterator> values;
+    values.reserve(m_mapValues.size());
+    for (auto it = m_mapValues.cbegin(); it != m_mapValues.cend(); ++it)
+    {
+      uint64_t hash = it->first.Hash();
+      m_hll     .Add(hash);
+      m_countMin.Add(hash, static_cast<uint32_t>(it->second));
+      values.push_back(it);
+    }
+    std::nth_element(values.begin(), values.begin() + TOP_VALUES, values.end(),
+      [](typename ValueMap::const_iterator a, typename ValueMap::const_iterator b)
+    {
+      return a->second > b->second;
     });
 
-    m_vSortedRows.clear();
-    for (const auto& pair : sortedRows)
+    ValueMap top(m_mapValues.get_allocator());
+    m_nMinCandidate = SIZE_MAX;
+    for (size_t i = 0; i < TOP_VALUES; ++i)
     {
-      m_vSortedRows.push_back(pair.second);
+      top.emplace(values[i]->first, values[i]->second);
+      m_nMinCandidate = (std::min)(m_nMinCandidate, values[i]->second);
     }
-
-    m_bSortedValid = true;
+    m_mapValues.swap(top);
+    m_bExact = false;
   }
-  // Iterate over rows and apply a function
-  void ForEach(std::function<void(const RowData&)> func) const
+  // Keep a value among the most frequent ones if its estimate is high enough.
+  // m_nMinCandidate is a lower bound of the smallest kept estimate, so the
+  // kept values are only scanned when a value may displace one of them.
+  void UpdateCandidate(const ColumnData<C>& value, size_t estimate)
   {
-    if (m_bSortedValid)
+    auto it = m_mapValues.find(value);
+    if (it != m_mapValues.end())
+    {
+      it->second = estimate;
+      return;
+    }
+    if (m_mapValues.size() < TOP_VALUES)
     {
-      for (const auto& row : m_vSortedRows)
+      m_mapValues.emplace(value, estimate);
+      m_nMinCandidate = (std::min)(m_nMinCandidate, estimate);
+      return;
+    }
+    if (estimate <= m_nMinCandidate)
+      return;
+
+    auto   smallest = m_mapValues.begin();
+    size_t second   = SIZE_MAX;
+    for (auto candidate = m_mapValues.begin(); candidate != m_mapValues.end(); ++candidate)
+    {
+      if (candidate->second < smallest->second)
       {
-        bool filtered = false;
-        for (size_t i = 0; i < N; ++i)
-        {
-          if (  m_arrColumnInfo[i].filter
-            && !m_arrColumnInfo[i].filter(&row[i]))
-          {
-            filtered = true;
-            break;
-          }
-        }
-        if (!filtered)
-        {
-          func(row);
-        }
+        second   = smallest->second;
+        smallest = candidate;
+      }
+      else if (candidate != smallest)
+      {
+        second   = (std::min)(second, candidate->second);
       }
     }
-    else
+    if (estimate <= smallest->second)
     {
-      for (const auto& pair : m_vRows)
+      m_nMinCandidate = smallest->second;
+      return;
+    }
+    m_mapValues.erase(smallest);
+    m_mapValues.emplace(value, estimate);
+    m_nMinCandidate = (std::min)(second, estimate);
+  }
+  // Count a numeric value in or out of the histogram
+  void UpdateHistogram(const ColumnData<C>& value, bool add)
+  {
+    double number = 0.0;
+    if (!value.ToNumber(number) || !std::isfinite(number))
+      return;
+
+    const double bins = static_cast<double>(HISTOGRAM_BINS);
+    if (m_vBins.empty())
+    {
+      if (!add)
+        return;
+
+      // Integers start with unit bins, floating point values with bins
+      // 1/64 of the magnitude of the first value
+      bool integral = value.type != ColumnType::FLOAT && value.type != ColumnType::DOUBLE;
+      m_vBins.assign(HISTOGRAM_BINS, 0);
+      m_dBinWidth = (integral || number == 0.0) ? 1.0
+                  : std::ldexp(1.0, std::ilogb(number) - 6);
+      m_dBinLower = std::floor(number / m_dBinWidth) * m_dBinWidth;
+    }
+
+    // Widen until the value falls inside, merging pairs of bins
+    const size_t HALF = HISTOGRAM_BINS / 2;
+    for (int i = 0; i < 2048 && (number < m_dBinLower
+      || number >= m_dBinLower + m_dBinWidth * bins); ++i)
+    {
+      if (number >= m_dBinLower)
       {
-        const auto& row = pair.second;
-        bool filtered = false;
-        for (size_t i = 0; i < N; ++i)
+        for (size_t bin = 0; bin < HALF; ++bin)
         {
-          if (  m_arrColumnInfo[i].filter
-            && !m_arrColumnInfo[i].filter(&row[i]))
-          {
-            filtered = true;
-            break;
-          }
+          m_vBins[bin] = m_vBins[2 * bin] + m_vBins[2 * bin + 1];
         }
-        if (!filtered)
+        std::fill(m_vBins.begin() + HALF, m_vBins.end(), 0);
+      }
+      else
+      {
+        for (size_t bin = HALF; bin-- > 0; )
         {
-          func(row);
+          m_vBins[HALF + bin] = m_vBins[2 * bin] + m_vBins[2 * bin + 1];
         }
+        std::fill(m_vBins.begin(), m_vBins.begin() + HALF, 0);
+        m_dBinLower -= m_dBinWidth * bins;
       }
+      m_dBinWidth *= 2.0;
+    }
+
+    double offset = (number - m_dBinLower) / m_dBinWidth;
+    size_t bin    = (offset <= 0.0) ? 0 : (std::min)(static_cast<size_t>(offset), HISTOGRAM_BINS - 1);
+    if (add)
+    {
+      ++m_vBins[bin];
+    }
+    else if (m_vBins[bin] > 0)
+    {
+      --m_vBins[bin];
     }
   }
+
+  // Exact counts, or the most frequent values with estimated counts
+  ValueMap                         m_mapValues;
+  bool                             m_bExact        = true;
+  // Values counted
+  size_t                           m_nValues       = 0;
+  // Sketches, used once m_bExact is false
+  HyperLogLog                      m_hll;
+  CountMinSketch                   m_countMin;
+  // Lower bound of the smallest estimate in m_mapValues
+  size_t                           m_nMinCandidate = 0;
+  // Numeric histogram, bin i covers m_dBinLower + i * m_dBinWidth onwards
+  std::pmr::vector<size_t>         m_vBins;
+  double                           m_dBinLower     = 0.0;
+  double                           m_dBinWidth     = 0.0;
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : ITableExLookup
+ * PURPOSE : Reference rows found by key, behind the lookup columns of a
+ *           TableEx
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Implemented by TableExLookup over another TableEx. Every
+ *           change of the reference rows advances the version, so a table
+ *           can tell which of its rows a change reached.
+ *
+ *****************************************************************************/
+
+template <typename C>
+class ITableExLookup
+{
+public:
+  // Get a cell of the reference row with a key, nullptr if there is none
+  virtual const ColumnData<C>* Resolve     (const ColumnData<C>& key,
+                                            size_t               col) const = 0;
+  // Version of the reference rows, increases with every change
+  virtual uint64_t             GetVersion  (                          ) const = 0;
+  // Check if the reference row with a key changed after a version
+  virtual bool                 ChangedSince(const ColumnData<C>& key,
+                                            uint64_t             version) const = 0;
+  virtual                     ~ITableExLookup(                        )       = default;
+};
+
+/*****************************************************************************
+ *
+ * STRUCT  : TableEx
+ * PURPOSE : Template-based table element processing class
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Support batch creation, updating, sorting and filtering.
+ *           Rows, views, indexes and zone maps allocate from one
+ *           std::pmr::memory_resource given at construction, so a table
+ *           may live in an arena that is released in one shot.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class TableEx
+{
+public:
+  using RowData = std::array<ColumnData<C>, N>;
+  using RowMap  = std::pmr::map<size_t, RowData>;
+  using RowNode = typename RowMap::value_type;
+  // Row pointers in view order
+  using NodeVector = std::pmr::vector<const RowNode*>;
+  // A row with its looked up sort value, see SortLookupRange
+  using KeyedNode  = std::pair<const ColumnData<C>*, const RowNode*>;
+  // Secondary index of one column: (value, row ID) entries, ties broken on
+  // the ID so the entry of one row is found in O(log n) on repeated values
+  using IndexEntry = std::pair<ColumnData<C>, size_t>;
+  struct IndexEntryCompare
+  {
+    bool operator()(const IndexEntry& a, const IndexEntry& b) const
+    {
+      int result = ColumnDataCompare<C>::Compare(a.first, b.first);
+      return result != 0 ? result < 0 : a.second < b.second;
+    }
+  };
+  using IndexMap = std::pmr::set<IndexEntry, IndexEntryCompare>;
+  // Told of a row change before it is applied, with the row before it
+  // (nullptr when inserted) and after it; must not modify the table
+  using RowListener   = std::function<void(size_t, const RowData*, const RowData&)>;
+  // Told when the table is cleared
+  using ClearListener = std::function<void()>;
+  // Told when the outermost transaction begins (true) and commits (false)
+  using TransactionListener = std::function<void(bool)>;
+
+  // Row IDs covered by one zone map block
+  static const size_t ZONE_BLOCK_IDS = 4096;
+  // An index is used when it matches at most 1 / INDEX_MAX_FRACTION rows
+  static const size_t INDEX_MAX_FRACTION = 8;
+  // Positions ordered at once when a lazily sorted view is read
+  static const size_t LAZY_SORT_PAGE     = 256;
+  // Largest partition RefineSortStep sorts in one go
+  static const size_t SORT_STEP_ROWS     = 65536;
+
+  // Inclusive range filter on one column, a missing bound is open.
+  // upperOpen leaves the upper bound itself out, as a histogram bin does.
+  struct RangeFilter
+  {
+    bool                         active    = false;
+    bool                         hasLower  = false;
+    bool                         hasUpper  = false;
+    bool                         upperOpen = false;
+    ColumnData<C>                lower;
+    ColumnData<C>                upper;
+
+    // Check if a value lies beyond the upper bound
+    bool PastUpper(const ColumnData<C>& value) const
+    {
+      if (!hasUpper)
+        return false;
+
+      int result = ColumnDataCompare<C>::Compare(value, upper);
+      return upperOpen ? result >= 0 : result > 0;
+    }
+  };
+  // Min/max of every column over one block of row IDs
+  struct ZoneEntry
+  {
+    RowData                      minValue;
+    RowData                      maxValue;
+  };
+  // Access path chosen by the filter planner
+  struct FilterPlan
+  {
+    enum class Access
+    {
+      SCAN,       // Visit every row
+      ZONE_SCAN,  // Visit rows of blocks whose zone map may match
+      INDEX,      // Visit rows found in a secondary index
+      TEXT_SEARCH // Visit rows found by the quick search
+    };
+    Access                       access        = Access::SCAN;
+    size_t                       col           = N;  // Index column
+    size_t                       estimatedRows = 0;
+  };
+  // Random access iterator over the rows of the current view
+  class ViewIterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = RowData;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const RowData*;
+    using reference         = const RowData&;
+
+    ViewIterator() : m_pNode(nullptr) {}
+    explicit ViewIterator(const RowNode* const* node) : m_pNode(node) {}
+
+    reference     operator* (                 ) const { return (*m_pNode)->second;        }
+    pointer       operator->(                 ) const { return &(*m_pNode)->second;       }
+    reference     operator[](difference_type n) const { return m_pNode[n]->second;        }
+    // ID of the row the iterator points at
+    size_t        Id        (                 ) const { return (*m_pNode)->first;         }
+
+    ViewIterator& operator++(                 )       { ++m_pNode;     return *this;      }
+    ViewIterator& operator--(                 )       { --m_pNode;     return *this;      }
+    ViewIterator  operator++(int              )       { return ViewIterator(m_pNode++);   }
+    ViewIterator  operator--(int              )       { return ViewIterator(m_pNode--);   }
+    ViewIterator& operator+=(difference_type n)       { m_pNode += n;  return *this;      }
+    ViewIterator& operator-=(difference_type n)       { m_pNode -= n;  return *this;      }
+    ViewIterator  operator+ (difference_type n) const { return ViewIterator(m_pNode + n); }
+    ViewIterator  operator- (difference_type n) const { return ViewIterator(m_pNode - n); }
+    difference_type operator-(const ViewIterator& o) const { return m_pNode - o.m_pNode;  }
+
+    bool operator==(const ViewIterator& o) const { return m_pNode == o.m_pNode; }
+    bool operator!=(const ViewIterator& o) const { return m_pNode != o.m_pNode; }
+    bool operator< (const ViewIterator& o) const { return m_pNode <  o.m_pNode; }
+    bool operator> (const ViewIterator& o) const { return m_pNode >  o.m_pNode; }
+    bool operator<=(const ViewIterator& o) const { return m_pNode <= o.m_pNode; }
+    bool operator>=(const ViewIterator& o) const { return m_pNode >= o.m_pNode; }
+  private:
+    const RowNode* const*        m_pNode;
+  };
+  // One column of the current view, indexed by view position
+  class ColumnSpan
+  {
+  public:
+    ColumnSpan(const RowNode* const* nodes, size_t size, size_t col)
+      : m_pNodes(nodes), m_nSize(size), m_nCol(col) {}
+
+    const ColumnData<C>& operator[](size_t pos) const { return m_pNodes[pos]->second[m_nCol]; }
+    size_t               size      (          ) const { return m_nSize;                         }
+    bool                 empty     (          ) const { return m_nSize == 0;                    }
+  private:
+    const RowNode* const*        m_pNodes;
+    size_t                       m_nSize;
+    size_t                       m_nCol;
+  };
+  using const_iterator = ViewIterator;
+protected:
+  // Resource every container below allocates from, counting what it hands out
+  CountingMemoryResource           m_memory;
+  // Column metadata
+  std::array<ColumnInfo<C>, N>     m_arrColumnInfo;
+  // Store rows using a map for ID lookup
+  RowMap                           m_vRows;
+  // Cached sorted rows (map nodes are stable, so only pointers are kept).
+  // A lazy sort only partially orders them; m_setSortBounds holds positions
+  // p with every row before p ordered before every row from p on, and the
+  // least of those at p, and m_sortedPositions the positions already in
+  // final order.
+  mutable NodeVector               m_vSortedRows;
+  mutable std::pmr::set<size_t>    m_setSortBounds;
+  mutable IdRangeSet               m_sortedPositions;
+  // Indicates if sorting is valid
+  bool                             m_bSortedValid = false;
+  // Rows in ID order for positional access to an unsorted view
+  mutable NodeVector               m_vIdOrderRows;
+  mutable bool                     m_bIdOrderValid = false;
+  // Rows passing the filters in view order, built on demand
+  mutable NodeVector               m_vFilteredRows;
+  mutable bool                     m_bFilteredValid = false;
+  // Nesting depth of BeginTransaction / CommitTransaction
+  size_t                           m_nTransactionDepth = 0;
+  // IDs written inside the current transaction
+  std::vector<size_t>              m_vDirtyIds;
+  // Indicates the current transaction inserted rows that were not present
+  bool                             m_bTransactionInserted = false;
+  // Indicates the current transaction only added rows after the last ID,
+  // which m_vAppendedRows holds; views are then extended, not rebuilt
+  bool                             m_bTransactionAppendOnly = true;
+  NodeVector                       m_vAppendedRows;
+  // Column and direction of the last sort
+  size_t                           m_nSortedCol           = 0;
+  bool                             m_bSortedAscending     = true;
+  // Indicates a sort key changed after sorting, so positions are out of order
+  bool                             m_bSortOrderStale      = false;
+  // Range filters per column
+  std::array<RangeFilter, N>       m_arrRangeFilters;
+  // Secondary indexes, only maintained for columns with m_arrIndexed set
+  std::array<bool, N>              m_arrIndexed           = {};
+  std::array<IndexMap, N>          m_arrIndexes;
+  // Value statistics, only maintained for columns with m_arrHasStats set
+  std::array<bool, N>              m_arrHasStats          = {};
+  std::array<ColumnStats<C>, N>    m_arrStats;
+  // Formatted lengths, only maintained for columns with m_arrHasWidthStats
+  // set; rebuilt on read when stale, hence mutable
+  std::array<bool, N>              m_arrHasWidthStats     = {};
+  mutable std::array<TextWidthStats, N> m_arrWidthStats;
+  // Trigram index over the formatted text of the columns with
+  // m_arrTextIndexed set, the quick search text (folded) and its rows.
+  // A view copy (AssignView) has no index and searches those columns by
+  // scanning, m_bTextIndexBuilt tells which.
+  std::array<bool, N>              m_arrTextIndexed       = {};
+  TrigramIndex                     m_textIndex;
+  bool                             m_bTextIndexBuilt      = true;
+  std::string                      m_strQuickSearch;
+  IdRangeSet                       m_quickSearchIds;
+  std::vector<std::string>         m_vTexts;
+  std::vector<std::string>         m_vOldTexts;
+  // Zone maps keyed by block number (row ID / ZONE_BLOCK_IDS)
+  bool                             m_bZoneMapsEnabled     = false;
+  std::pmr::map<size_t, ZoneEntry> m_mapZones;
+  // Lookup column: its value is the refCol cell of the reference row
+  // whose key is in keyCol, resolved on every read through GetCell
+  struct LookupColumn
+  {
+    const ITableExLookup<C>     *source          = nullptr;
+    size_t                       keyCol          = 0;
+    size_t                       refCol          = 0;
+    // Read when no reference row has the key
+    ColumnData<C>                missing;
+    // Reference versions taken in by the last two SyncLookups
+    uint64_t                     version         = 0;
+    uint64_t                     previousVersion = 0;
+  };
+  std::array<LookupColumn, N>      m_arrLookups;
+  // Row listeners with their handles, not copied with the table
+  struct Listener
+  {
+    size_t                       handle;
+    RowListener                  onUpsert;
+    ClearListener                onClear;
+    TransactionListener          onTransaction;
+  };
+  std::vector<Listener>            m_vListeners;
+  size_t                           m_nNextListener        = 1;
+public:
+  explicit TableEx(
+    std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+    : m_memory       (upstream)
+    , m_vRows        (&m_memory)
+    , m_vSortedRows  (&m_memory)
+    , m_setSortBounds(&m_memory)
+    , m_vIdOrderRows (&m_memory)
+    , m_vFilteredRows(&m_memory)
+    , m_vAppendedRows(&m_memory)
+    , m_arrIndexes   (MakeIndexes(std::make_index_sequence<N>()))
+    , m_arrStats     (MakeStats  (std::make_index_sequence<N>()))
+    , m_mapZones     (&m_memory)
+  {
+  }
+  // Copying must re-point column info and sorted rows at our own storage.
+  // A copy allocates from the same upstream resource unless one is given.
+  TableEx(const TableEx& other)
+    : TableEx(other.m_memory.GetUpstream())
+  {
+    *this = other;
+  }
+  TableEx(const TableEx& other, std::pmr::memory_resource* upstream)
+    : TableEx(upstream)
+  {
+    *this = other;
+  }
+  TableEx& operator=(const TableEx& other)
+  {
+    if (this == &other)
+      return *this;
+
+    AssignView(other);
+    m_arrIndexed           = other.m_arrIndexed;
+    m_arrIndexes           = other.m_arrIndexes;
+    m_arrHasStats          = other.m_arrHasStats;
+    m_arrStats             = other.m_arrStats;
+    m_arrHasWidthStats     = other.m_arrHasWidthStats;
+    m_arrWidthStats        = other.m_arrWidthStats;
+    m_textIndex            = other.m_textIndex;
+    m_bTextIndexBuilt      = other.m_bTextIndexBuilt;
+    m_bZoneMapsEnabled     = other.m_bZoneMapsEnabled;
+    m_mapZones             = other.m_mapZones;
+    return *this;
+  }
+  // Copy the rows and what defines the view (columns, sort, filters, quick
+  // search, lookups) but no statistics, indexes or zone maps, which a copy
+  // taken to be diffed against would only maintain for nothing. Its
+  // filters and quick search are then evaluated by scanning.
+  void AssignView(const TableEx& other)
+  {
+    if (this == &other)
+      return;
+
+    m_arrColumnInfo = other.m_arrColumnInfo;
+    m_vRows         = other.m_vRows;
+    for (auto& pair : m_vRows)
+    {
+      for (size_t i = 0; i < N; ++i)
+      {
+        pair.second[i].columnInfo = &m_arrColumnInfo[i];
+      }
+    }
+
+    m_vSortedRows.clear();
+    if (other.m_bSortedValid)
+    {
+      m_vSortedRows.reserve(other.m_vSortedRows.size());
+      for (const RowNode* node : other.m_vSortedRows)
+      {
+        m_vSortedRows.push_back(&*m_vRows.find(node->first));
+      }
+    }
+    m_setSortBounds        = other.m_setSortBounds;
+    m_sortedPositions      = other.m_sortedPositions;
+    m_bSortedValid         = other.m_bSortedValid;
+    m_vIdOrderRows.clear();
+    m_bIdOrderValid        = false;
+    m_vFilteredRows.clear();
+    m_bFilteredValid       = false;
+    m_nSortedCol           = other.m_nSortedCol;
+    m_bSortedAscending     = other.m_bSortedAscending;
+    m_bSortOrderStale      = other.m_bSortOrderStale;
+    m_arrRangeFilters      = other.m_arrRangeFilters;
+    for (size_t col = 0; col < N; ++col)
+    {
+      DropIndex        (col);
+      EnableColumnStats(col, false);
+      EnableWidthStats (col, false);
+    }
+    m_arrTextIndexed       = other.m_arrTextIndexed;
+    m_textIndex.Clear();
+    m_bTextIndexBuilt      = false;
+    m_strQuickSearch       = other.m_strQuickSearch;
+    m_quickSearchIds       = other.m_quickSearchIds;
+    m_bZoneMapsEnabled     = false;
+    m_mapZones.clear();
+    m_arrLookups           = other.m_arrLookups;
+    for (size_t i = 0; i < N; ++i)
+    {
+      m_arrLookups[i].missing.columnInfo = &m_arrColumnInfo[i];
+    }
+    m_nTransactionDepth    = 0;
+    m_bTransactionInserted = false;
+    m_bTransactionAppendOnly = true;
+    m_vDirtyIds.clear();
+    m_vAppendedRows.clear();
+  }
+  // Remove all rows and give back every block taken from the resource, so
+  // an arena under the table can be released right after
+  void Clear()
+  {
+    NodeVector(&m_memory).swap(m_vSortedRows);
+    NodeVector(&m_memory).swap(m_vIdOrderRows);
+    NodeVector(&m_memory).swap(m_vFilteredRows);
+    NodeVector(&m_memory).swap(m_vAppendedRows);
+    m_setSortBounds.clear();
+    m_sortedPositions.Clear();
+    m_bSortedValid    = false;
+    m_bIdOrderValid   = false;
+    m_bFilteredValid  = false;
+    m_bSortOrderStale = false;
+    for (IndexMap& index : m_arrIndexes)
+    {
+      index.clear();
+    }
+    for (ColumnStats<C>& stats : m_arrStats)
+    {
+      stats.Clear();
+    }
+    for (TextWidthStats& stats : m_arrWidthStats)
+    {
+      stats.Clear();
+    }
+    m_textIndex.Clear();
+    m_quickSearchIds.Clear();
+    m_mapZones.clear();
+    m_vRows.clear();
+    for (const Listener& listener : m_vListeners)
+    {
+      if (listener.onClear)
+      {
+        listener.onClear();
+      }
+    }
+  }
+  // Register listeners told of every row change, of Clear and of
+  // transactions, returns a handle for RemoveRowListener. Listeners stay
+  // with this table when it is copied.
+  size_t AddRowListener(RowListener         onUpsert,
+                        ClearListener       onClear       = nullptr,
+                        TransactionListener onTransaction = nullptr)
+  {
+    m_vListeners.push_back({ m_nNextListener,
+      std::move(onUpsert), std::move(onClear), std::move(onTransaction) });
+    return m_nNextListener++;
+  }
+  // Unregister listeners by the handle AddRowListener returned
+  void RemoveRowListener(size_t handle)
+  {
+    m_vListeners.erase(std::remove_if(m_vListeners.begin(), m_vListeners.end(),
+      [handle](const Listener& listener) { return listener.handle == handle; }),
+      m_vListeners.end());
+  }
+  // Get the resource the table allocates from
+  std::pmr::memory_resource* GetMemoryResource() const
+  {
+    return m_memory.GetUpstream();
+  }
+  // Report how much memory the table uses. Walks every cell to measure
+  // string buffers, so call it for diagnostics rather than per frame.
+  TableExMemoryUsage GetMemoryUsage() const
+  {
+    // A red-black tree node carries a color and three links on top of its value
+    const size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+    const size_t INLINE_CAPACITY    = std::string().capacity();
+
+    TableExMemoryUsage usage;
+    usage.rows     = m_vRows.size();
+    usage.rowBytes = m_vRows.size() * (sizeof(RowNode) + TREE_NODE_OVERHEAD);
+    for (const auto& pair : m_vRows)
+    {
+      for (const ColumnData<C>& cell : pair.second)
+      {
+        if (cell.str.capacity() > INLINE_CAPACITY)
+        {
+          usage.stringBytes += cell.str.capacity() + 1;
+        }
+      }
+    }
+    usage.viewBytes = (m_vSortedRows.capacity() + m_vIdOrderRows.capacity()
+      + m_vFilteredRows.capacity()) * sizeof(const RowNode*)
+      + m_setSortBounds.size() * (sizeof(size_t) + TREE_NODE_OVERHEAD);
+    for (const IndexMap& index : m_arrIndexes)
+    {
+      usage.indexBytes += index.size()
+        * (sizeof(typename IndexMap::value_type) + TREE_NODE_OVERHEAD);
+    }
+    usage.indexBytes += m_textIndex.GetBytes()
+      + m_quickSearchIds.RangeCount() * (2 * sizeof(size_t) + TREE_NODE_OVERHEAD);
+    for (size_t col = 0; col < N; ++col)
+    {
+      usage.statsBytes += m_arrHasStats[col] ? m_arrStats[col].GetBytes() : 0;
+      usage.statsBytes += m_arrHasWidthStats[col] ? m_arrWidthStats[col].GetBytes() : 0;
+    }
+    usage.zoneBytes = m_mapZones.size()
+      * (sizeof(typename std::pmr::map<size_t, ZoneEntry>::value_type) + TREE_NODE_OVERHEAD);
+    usage.resourceBytes = m_memory.GetBytesInUse();
+    usage.resourcePeak  = m_memory.GetPeakBytes();
+    usage.allocations   = m_memory.GetAllocations();
+    return usage;
+  }
+  // Get column metadata by index (returns reference to avoid copy overhead)
+  const ColumnInfo<C>& GetColumnInfo(size_t col) const
+  {
+    static ColumnInfo<C> dummyColumn = {};
+    return (col < N) ? m_arrColumnInfo[col] : dummyColumn;
+  }
+  // Set column metadata
+  void SetColumnInfo(size_t col, const ColumnInfo<C>& info)
+  {
+    if (col < N)
+    {
+      m_arrColumnInfo[col] = info;
+      m_bFilteredValid     = false;
+      m_arrLookups[col].missing.type = info.type;
+      // The format may have changed the displayed lengths
+      if (m_arrHasWidthStats[col] && !m_vRows.empty())
+      {
+        m_arrWidthStats[col].Clear();
+        RebuildWidthStats(col);
+      }
+    }
+  }
+  // Set filter function for a specific column
+  void SetFilter(size_t col, std::function<bool(const void*)> filter)
+  {
+    if (col < N)
+    {
+      m_arrColumnInfo[col].filter = filter;
+      m_bFilteredValid            = false;
+    }
+  }
+  // Set an inclusive range filter, nullptr leaves that side open.
+  // Pass the same value as both bounds for an equality filter, or
+  // upperOpen to keep values below upper only.
+  void SetRangeFilter(size_t               col,
+                      const ColumnData<C>* lower,
+                      const ColumnData<C>* upper,
+                      bool                 upperOpen = false)
+  {
+    if (col >= N)
+      return;
+
+    RangeFilter& range = m_arrRangeFilters[col];
+    range.active    = lower || upper;
+    range.hasLower  = lower != nullptr;
+    range.hasUpper  = upper != nullptr;
+    range.upperOpen = upper && upperOpen;
+    range.lower     = lower ? *lower : ColumnData<C>();
+    range.upper     = upper ? *upper : ColumnData<C>();
+    m_bFilteredValid = false;
+  }
+  // Clear filter for a specific column or all columns if col is out of range
+  void ClearFilter(size_t col = -1)
+  {
+    m_bFilteredValid = false;
+    if (col < N)
+    {
+      m_arrColumnInfo[col].filter = nullptr;
+      m_arrRangeFilters[col]      = RangeFilter();
+    }
+    else
+    {
+      for (auto& colInfo : m_arrColumnInfo)
+      {
+        colInfo.filter = nullptr;
+      }
+      for (auto& range : m_arrRangeFilters)
+      {
+        range = RangeFilter();
+      }
+    }
+  }
+  // Build and maintain a sorted secondary index on a column
+  void CreateIndex(size_t col)
+  {
+    if (col >= N || m_arrIndexed[col] || m_arrLookups[col].source)
+      return;
+
+    m_arrIndexed[col] = true;
+    for (const auto& pair : m_vRows)
+    {
+      m_arrIndexes[col].emplace(pair.second[col], pair.first);
+    }
+  }
+  // Drop the secondary index of a column
+  void DropIndex(size_t col)
+  {
+    if (col >= N)
+      return;
+
+    m_arrIndexed[col] = false;
+    m_arrIndexes[col].clear();
+  }
+  // Check if a column has a secondary index
+  bool HasIndex(size_t col) const
+  {
+    return col < N && m_arrIndexed[col];
+  }
+  // Maintain value statistics (distinct values, frequencies, histogram)
+  // of a column from now on; enabling counts the existing rows once
+  void EnableColumnStats(size_t col, bool enable = true)
+  {
+    if (col >= N || m_arrHasStats[col] == enable || (enable && m_arrLookups[col].source))
+      return;
+
+    m_arrHasStats[col] = enable;
+    m_arrStats[col].Clear();
+    if (!enable)
+      return;
+
+    for (const auto& pair : m_vRows)
+    {
+      m_arrStats[col].Add(pair.second[col]);
+    }
+  }
+  // Check if a column has value statistics
+  bool HasColumnStats(size_t col) const
+  {
+    return col < N && m_arrHasStats[col];
+  }
+  // Get the value statistics of a column, empty unless HasColumnStats
+  const ColumnStats<C>& GetColumnStats(size_t col) const
+  {
+    return m_arrStats[(col < N) ? col : 0];
+  }
+  // Maintain the lengths of the formatted values of a column from now on,
+  // for sizing it; enabling measures the existing rows once
+  void EnableWidthStats(size_t col, bool enable = true)
+  {
+    if (col >= N || m_arrHasWidthStats[col] == enable || (enable && m_arrLookups[col].source))
+      return;
+
+    m_arrHasWidthStats[col] = enable;
+    m_arrWidthStats[col].Clear();
+    if (enable)
+    {
+      RebuildWidthStats(col);
+    }
+  }
+  // Check if a column has width statistics
+  bool HasWidthStats(size_t col) const
+  {
+    return col < N && m_arrHasWidthStats[col];
+  }
+  // Get the width statistics of a column, empty unless HasWidthStats.
+  // Rebuilt here if updates took out the longest values it knew.
+  const TextWidthStats& GetWidthStats(size_t col) const
+  {
+    col = (col < N) ? col : 0;
+    if (m_arrHasWidthStats[col] && m_arrWidthStats[col].IsStale())
+    {
+      m_arrWidthStats[col].Clear();
+      RebuildWidthStats(col);
+    }
+    return m_arrWidthStats[col];
+  }
+  // Index the formatted text of a column for SetQuickSearch
+  void EnableTextIndex(size_t col, bool enable = true)
+  {
+    if (col >= N || m_arrTextIndexed[col] == enable || (enable && m_arrLookups[col].source))
+      return;
+
+    m_arrTextIndexed[col] = enable;
+    m_textIndex.Clear();
+    m_bTextIndexBuilt     = true;
+    for (const auto& pair : m_vRows)
+    {
+      if (CollectTexts(pair.second, m_vTexts))
+      {
+        m_textIndex.Insert(pair.first, m_vTexts);
+      }
+    }
+    SetQuickSearch(m_strQuickSearch);
+  }
+  // Check if a column is searched through the text index
+  bool HasTextIndex(size_t col) const
+  {
+    return col < N && m_arrTextIndexed[col];
+  }
+  // Only show rows where a text-indexed column (any column if none is)
+  // contains text, as displayed and ignoring ASCII case. The matches are
+  // looked up in the trigram index, then kept up to date by UpsertRow.
+  // Empty text ends the search; ClearFilter leaves it alone.
+  void SetQuickSearch(const std::string& text)
+  {
+    m_strQuickSearch = TrigramIndex::Fold(text);
+    m_quickSearchIds.Clear();
+    m_bFilteredValid = false;
+    if (m_strQuickSearch.empty())
+      return;
+
+    // Without an indexed column, or without the index in a view copy,
+    // every row is checked
+    std::vector<size_t> ids;
+    if (!m_bTextIndexBuilt || std::find(m_arrTextIndexed.begin(),
+      m_arrTextIndexed.end(), true) == m_arrTextIndexed.end())
+    {
+      for (const auto& pair : m_vRows)
+      {
+        if (MatchesQuickSearch(pair.second))
+        {
+          ids.push_back(pair.first);
+        }
+      }
+      m_quickSearchIds = IdRangeSet::FromSorted(ids);
+      return;
+    }
+
+    // Long patterns only narrow down the rows, check those left
+    bool       exact      = false;
+    IdRangeSet candidates = m_textIndex.Search(m_strQuickSearch, exact);
+    if (exact)
+    {
+      m_quickSearchIds = std::move(candidates);
+      return;
+    }
+    candidates.ForEach([&](size_t id)
+    {
+      auto it = m_vRows.find(id);
+      if (it != m_vRows.end() && MatchesQuickSearch(it->second))
+      {
+        ids.push_back(id);
+      }
+    });
+    m_quickSearchIds = IdRangeSet::FromSorted(ids);
+  }
+  // Get the quick search text (folded), empty if none
+  const std::string& GetQuickSearch() const
+  {
+    return m_strQuickSearch;
+  }
+  // Enable or disable per-block min/max zone maps
+  void EnableZoneMaps(bool enable = true)
+  {
+    m_bZoneMapsEnabled = enable;
+    RebuildZoneMaps();
+  }
+  // Check if zone maps are kept
+  bool HasZoneMaps() const
+  {
+    return m_bZoneMapsEnabled;
+  }
+  // Recompute exact zone maps (updates only ever widen a block's bounds)
+  void RebuildZoneMaps()
+  {
+    m_mapZones.clear();
+    if (!m_bZoneMapsEnabled)
+      return;
+
+    for (const auto& pair : m_vRows)
+    {
+      WidenZone(pair.first, pair.second);
+    }
+  }
+  // Get a row by ID, nullptr if it does not exist
+  const RowData* GetRow(size_t id) const
+  {
+    auto it = m_vRows.find(id);
+    return (it != m_vRows.end()) ? &it->second : nullptr;
+  }
+  // Get the number of rows, ignoring filters
+  size_t GetRowCount() const
+  {
+    return m_vRows.size();
+  }
+  // Get the largest row ID, false if the table is empty
+  bool GetLastId(size_t& id) const
+  {
+    if (m_vRows.empty())
+      return false;
+
+    id = m_vRows.rbegin()->first;
+    return true;
+  }
+  // Check if the view is in the order of a column rather than by ID
+  bool IsSorted() const
+  {
+    return m_bSortedValid;
+  }
+  // Get the column and direction of the current sort, false if not sorted
+  bool GetSortOrder(size_t& col, bool& ascending) const
+  {
+    col       = m_nSortedCol;
+    ascending = m_bSortedAscending;
+    return m_bSortedValid;
+  }
+  // Make col a lookup column: its value is the refCol cell of the row of
+  // lookup whose key is the keyCol value, resolved when read, so reference
+  // data is not copied into every row and a change of it reaches every row
+  // at once. Upserted rows may hold anything in col (a default ColumnData
+  // costs nothing); declare the column with the type of refCol, keyCol with
+  // the type of the reference keys. Reads through GetCell, the filters and
+  // sorting see the looked up value; GetRow, iteration and Column see what
+  // was stored. Lookup columns are not indexed, counted or searched by
+  // SetQuickSearch. nullptr makes col a plain column again. The lookup
+  // must outlive its use by this table.
+  void SetLookupColumn(size_t                   col,
+                       const ITableExLookup<C>* lookup,
+                       size_t                   keyCol,
+                       size_t                   refCol)
+  {
+    if (col >= N || keyCol >= N || keyCol == col || m_arrLookups[keyCol].source)
+      return;
+
+    if (lookup)
+    {
+      DropIndex        (col);
+      EnableColumnStats(col, false);
+      EnableWidthStats (col, false);
+      EnableTextIndex  (col, false);
+    }
+    LookupColumn& column      = m_arrLookups[col];
+    column.source             = lookup;
+    column.keyCol             = keyCol;
+    column.refCol             = refCol;
+    column.missing            = ColumnData<C>();
+    column.missing.type       = m_arrColumnInfo[col].type;
+    column.missing.value.u64  = 0;
+    column.missing.columnInfo = &m_arrColumnInfo[col];
+    column.version            = lookup ? lookup->GetVersion() : 0;
+    column.previousVersion    = column.version;
+    m_bFilteredValid          = false;
+    if (m_bSortedValid && m_nSortedCol == col)
+    {
+      m_bSortOrderStale = true;
+    }
+  }
+  // Check if a column is a lookup column
+  bool IsLookupColumn(size_t col) const
+  {
+    return col < N && m_arrLookups[col].source;
+  }
+  // Get the value of a cell of a row, looked up for a lookup column
+  const ColumnData<C>& GetCell(const RowData& row, size_t col) const
+  {
+    const LookupColumn& lookup = m_arrLookups[col];
+    if (!lookup.source)
+      return row[col];
+
+    const ColumnData<C>* cell = lookup.source->Resolve(row[lookup.keyCol], lookup.refCol);
+    return cell ? *cell : lookup.missing;
+  }
+  // Take in the reference changes since the last call. A filter on a
+  // changed lookup column is applied again, so the view may change (reset
+  // is set); a sort by one keeps its positions until the next SortByColumn,
+  // as after row updates. Returns true if any looked up value may have
+  // changed, LookupChanged then tells which rows.
+  bool SyncLookups(bool& reset)
+  {
+    bool changed = false;
+    reset = false;
+    for (size_t col = 0; col < N; ++col)
+    {
+      LookupColumn& lookup = m_arrLookups[col];
+      if (!lookup.source)
+        continue;
+
+      uint64_t version = lookup.source->GetVersion();
+      lookup.previousVersion = lookup.version;
+      if (version == lookup.version)
+        continue;
+
+      lookup.version = version;
+      changed        = true;
+      if (m_arrRangeFilters[col].active || m_arrColumnInfo[col].filter)
+      {
+        m_bFilteredValid = false;
+        reset            = true;
+      }
+      if (m_bSortedValid && m_nSortedCol == col)
+      {
+        m_bSortOrderStale = true;
+      }
+    }
+    return changed;
+  }
+  // Check if a looked up value of a row changed between the last two
+  // SyncLookups
+  bool LookupChanged(const RowData& row) const
+  {
+    for (const LookupColumn& lookup : m_arrLookups)
+    {
+      if (lookup.source && lookup.version != lookup.previousVersion
+        && lookup.source->ChangedSince(row[lookup.keyCol], lookup.previousVersion))
+        return true;
+    }
+    return false;
+  }
+  // Check if any filter is set
+  bool HasActiveFilters() const
+  {
+    if (!m_strQuickSearch.empty())
+      return true;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+      if (m_arrRangeFilters[i].active || m_arrColumnInfo[i].filter)
+        return true;
+    }
+    return false;
+  }
+  // Get the row at a position of the current view. An unfiltered, lazily
+  // sorted view only orders the page around pos before returning it.
+  const RowNode* GetViewNode(size_t pos) const
+  {
+    if (HasActiveFilters())
+    {
+      const NodeVector& nodes = ViewNodes();
+      return (pos < nodes.size()) ? nodes[pos] : nullptr;
+    }
+    if (pos >= m_vRows.size())
+      return nullptr;
+
+    if (m_bSortedValid)
+    {
+      size_t first = pos - pos % LAZY_SORT_PAGE;
+      EnsureSorted(first, first + LAZY_SORT_PAGE);
+      return m_vSortedRows[pos];
+    }
+    return IdOrderNodes()[pos];
+  }
+  // Number of rows in the current view (filtered)
+  size_t size() const
+  {
+    return HasActiveFilters() ? ViewNodes().size() : m_vRows.size();
+  }
+  // Check if the current view is empty
+  bool empty() const
+  {
+    return size() == 0;
+  }
+  // Row at a position of the current view, pos must be below size()
+  const RowData& operator[](size_t pos) const
+  {
+    return GetViewNode(pos)->second;
+  }
+  // Row ID at a position of the current view, pos must be below size()
+  size_t IdAt(size_t pos) const
+  {
+    return GetViewNode(pos)->first;
+  }
+  // Find the view position of a row, false if it is not in the view. A
+  // lazily sorted view is not ordered for it: the row's partition is found
+  // by its first (least) rows, and if still out of order, the rows placed
+  // before it are counted.
+  bool FindViewPosition(size_t id, size_t& pos) const
+  {
+    auto it = m_vRows.find(id);
+    if (it == m_vRows.end() || !PassesFilters(it->first, it->second))
+      return false;
+
+    const RowNode*    node     = &*it;
+    bool              filtered = HasActiveFilters();
+    const NodeVector& nodes    = filtered       ? ViewNodes()
+                               : m_bSortedValid ? m_vSortedRows : IdOrderNodes();
+    if (!m_bSortedValid)
+    {
+      pos = std::lower_bound(nodes.begin(), nodes.end(), id,
+        [](const RowNode* other, size_t key) { return other->first < key; })
+        - nodes.begin();
+      return true;
+    }
+    if (m_bSortOrderStale)
+    {
+      // Updated rows sit out of order, only a scan finds them
+      auto found = std::find(nodes.begin(), nodes.end(), node);
+      pos = found - nodes.begin();
+      return found != nodes.end();
+    }
+
+    WithSortOrder([&](auto before)
+    {
+      size_t lo = 0;
+      size_t hi = nodes.size();
+      if (!filtered)
+      {
+        for (auto bound = std::next(m_setSortBounds.begin());
+          *bound < nodes.size() && !before(node, nodes[*bound]); ++bound)
+        {
+          lo = *bound;
+        }
+        hi = *m_setSortBounds.upper_bound(lo);
+      }
+      if (filtered || m_sortedPositions.ContainsRange(lo, hi - 1))
+      {
+        pos = std::lower_bound(nodes.begin() + lo, nodes.begin() + hi, node, before)
+          - nodes.begin();
+      }
+      else
+      {
+        pos = lo + std::count_if(nodes.begin() + lo, nodes.begin() + hi,
+          [&](const RowNode* other) { return before(other, node); });
+      }
+    });
+    return true;
+  }
+  // Put row IDs in view order, dropping those not in the view. The rows
+  // are compared with each other, as a fresh sort would order them, so a
+  // lazy sort is left as it is.
+  void SortIdsInViewOrder(std::vector<size_t>& ids) const
+  {
+    std::vector<const RowNode*> nodes;
+    nodes.reserve(ids.size());
+    for (size_t id : ids)
+    {
+      auto it = m_vRows.find(id);
+      if (it != m_vRows.end() && PassesFilters(it->first, it->second))
+      {
+        nodes.push_back(&*it);
+      }
+    }
+    if (m_bSortedValid && m_bSortOrderStale)
+    {
+      // Updated rows sit out of order, the view itself is walked
+      std::sort(ids.begin(), ids.end());
+      IdRangeSet wanted = IdRangeSet::FromSorted(ids);
+      nodes.clear();
+      for (const RowNode* node : HasActiveFilters() ? ViewNodes() : m_vSortedRows)
+      {
+        if (wanted.Contains(node->first))
+        {
+          nodes.push_back(node);
+        }
+      }
+    }
+    else if (m_bSortedValid)
+    {
+      WithSortOrder([&](auto before)
+      {
+        std::sort(nodes.begin(), nodes.end(), before);
+      });
+    }
+    else
+    {
+      std::sort(nodes.begin(), nodes.end(),
+        [](const RowNode* a, const RowNode* b) { return a->first < b->first; });
+    }
+    ids.clear();
+    for (const RowNode* node : nodes)
+    {
+      ids.push_back(node->first);
+    }
+  }
+  // Iterators over the current view. Taking them completes a lazy sort;
+  // any modification of the table invalidates them.
+  ViewIterator begin() const
+  {
+    return ViewIterator(ViewNodes().data());
+  }
+  ViewIterator end() const
+  {
+    const NodeVector& nodes = ViewNodes();
+    return ViewIterator(nodes.data() + nodes.size());
+  }
+  // One column of the current view
+  ColumnSpan Column(size_t col) const
+  {
+    const NodeVector& nodes = ViewNodes();
+    return ColumnSpan(nodes.data(), (col < N) ? nodes.size() : 0, col);
+  }
+  // Check a row against all filters, including the quick search
+  bool PassesFilters(size_t id, const RowData& row) const
+  {
+    return (m_strQuickSearch.empty() || m_quickSearchIds.Contains(id))
+      && PassesFilters(row);
+  }
+  // Check a row against all column filters
+  bool PassesFilters(const RowData& row) const
+  {
+    for (size_t i = 0; i < N; ++i)
+    {
+      if (  m_arrRangeFilters[i].active
+        && !InRange(m_arrRangeFilters[i], GetCell(row, i)))
+      {
+        return false;
+      }
+      if (  m_arrColumnInfo[i].filter
+        && !m_arrColumnInfo[i].filter(&GetCell(row, i)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  // Choose how the current filters will be evaluated: an index is used when
+  // it yields at most 1 / INDEX_MAX_FRACTION of the rows, zone maps when
+  // enabled and the view is in ID order, otherwise a full scan
+  FilterPlan PlanFilter() const
+  {
+    FilterPlan plan;
+    plan.estimatedRows = m_vRows.size();
+
+    // The quick search rows are known already, use them when they are few
+    size_t budget = m_vRows.size() / INDEX_MAX_FRACTION;
+    if (!m_strQuickSearch.empty() && m_quickSearchIds.Count() <= budget)
+    {
+      plan.access        = FilterPlan::Access::TEXT_SEARCH;
+      plan.estimatedRows = m_quickSearchIds.Count();
+      budget             = plan.estimatedRows;
+    }
+
+    bool anyRange = false;
+    for (const auto& range : m_arrRangeFilters)
+    {
+      anyRange = anyRange || range.active;
+    }
+    if (!anyRange)
+      return plan;
+
+    // Probe each usable index, giving up once it is no better than the best
+    for (size_t col = 0; col < N; ++col)
+    {
+      if (!m_arrIndexed[col] || !m_arrRangeFilters[col].active)
+        continue;
+
+      size_t count = 0;
+      if (CountIndexRange(col, budget, count))
+      {
+        plan.access        = FilterPlan::Access::INDEX;
+        plan.col           = col;
+        plan.estimatedRows = count;
+        budget             = count;
+      }
+    }
+    if (plan.access != FilterPlan::Access::SCAN)
+      return plan;
+
+    if (m_bZoneMapsEnabled && !m_bSortedValid)
+    {
+      size_t blocks = 0;
+      for (const auto& zone : m_mapZones)
+      {
+        blocks += ZoneMayMatch(zone.second) ? 1 : 0;
+      }
+      plan.access        = FilterPlan::Access::ZONE_SCAN;
+      plan.estimatedRows = (std::min)(blocks * ZONE_BLOCK_IDS, m_vRows.size());
+    }
+    return plan;
+  }
+  // Start a batch of updates; nested calls are folded into the outermost one
+  void BeginTransaction()
+  {
+    if (m_nTransactionDepth++ == 0)
+    {
+      m_vDirtyIds.clear();
+      m_vAppendedRows.clear();
+      m_bTransactionInserted   = false;
+      m_bTransactionAppendOnly = true;
+      NotifyTransaction(true);
+    }
+  }
+  // Finish a batch of updates and return the sorted, unique IDs it touched.
+  // Updated rows keep their sorted position until the next SortByColumn,
+  // only inserting new rows invalidates the sorted cache (once). A batch
+  // that only appends rows after the last ID (a growing log) is merged
+  // into the current views instead, at a cost that follows the batch size.
+  std::vector<size_t> CommitTransaction()
+  {
+    if (m_nTransactionDepth == 0 || --m_nTransactionDepth > 0)
+      return std::vector<size_t>();
+
+    NotifyTransaction(false);
+    if (m_bTransactionInserted && m_bTransactionAppendOnly)
+    {
+      MergeAppendedRows();
+    }
+    else
+    {
+      if (m_bTransactionInserted)
+      {
+        m_bSortedValid = false;
+      }
+      if (!m_vDirtyIds.empty())
+      {
+        m_bFilteredValid = false;
+      }
+    }
+    m_vAppendedRows.clear();
+
+    std::vector<size_t> dirtyIds;
+    dirtyIds.swap(m_vDirtyIds);
+    std::sort(dirtyIds.begin(), dirtyIds.end());
+    dirtyIds.erase(
+      std::unique(dirtyIds.begin(), dirtyIds.end()), dirtyIds.end());
+    return dirtyIds;
+  }
+  // Check if a transaction is currently open
+  bool InTransaction() const
+  {
+    return m_nTransactionDepth > 0;
+  }
+  // Insert or update a row
+  void UpsertRow(size_t id, std::array<ColumnData<C>, N> row)
+  {
+    // Link column info
+    for (size_t i = 0; i < N; ++i)
+    {
+      row[i].columnInfo = &m_arrColumnInfo[i];
+    }
+
+    auto it = m_vRows.find(id);
+    bool inserted = (it == m_vRows.end());
+    bool appended = false;
+    for (const Listener& listener : m_vListeners)
+    {
+      listener.onUpsert(id, inserted ? nullptr : &it->second, row);
+    }
+    if (inserted)
+    {
+      it = m_vRows.emplace_hint(m_vRows.end(), id, row);
+      // A row after the last ID extends the ID order instead of reordering
+      appended = std::next(it) == m_vRows.end();
+      if (appended && m_bIdOrderValid)
+      {
+        m_vIdOrderRows.push_back(&*it);
+      }
+      else
+      {
+        m_bIdOrderValid = false;
+      }
+    }
+    else
+    {
+      if (m_bSortedValid && ColumnDataCompare<C>::Compare(
+        GetCell(it->second, m_nSortedCol), GetCell(row, m_nSortedCol)) != 0)
+      {
+        m_bSortOrderStale = true;
+      }
+      for (size_t col = 0; col < N; ++col)
+      {
+        if (m_arrIndexed[col])
+        {
+          EraseIndexEntry(col, it->second[col], id);
+        }
+        if (m_arrHasStats[col])
+        {
+          m_arrStats[col].Remove(it->second[col]);
+        }
+        if (m_arrHasWidthStats[col])
+        {
+          m_arrWidthStats[col].Remove(it->second[col].FormatValue());
+        }
+      }
+      if (m_bTextIndexBuilt)
+      {
+        CollectTexts(it->second, m_vOldTexts);
+      }
+      it->second = row;
+    }
+
+    for (size_t col = 0; col < N; ++col)
+    {
+      if (m_arrIndexed[col])
+      {
+        m_arrIndexes[col].emplace(row[col], id);
+      }
+      if (m_arrHasStats[col])
+      {
+        m_arrStats[col].Add(row[col]);
+      }
+      if (m_arrHasWidthStats[col])
+      {
+        m_arrWidthStats[col].Add(it->second[col].FormatValue());
+      }
+    }
+    if (m_bZoneMapsEnabled)
+    {
+      WidenZone(id, it->second);
+    }
+    if (m_bTextIndexBuilt && CollectTexts(it->second, m_vTexts))
+    {
+      // An updated row only moves between the postings of changed windows
+      if (inserted)
+      {
+        m_textIndex.Insert(id, m_vTexts);
+      }
+      else
+      {
+        m_textIndex.Update(id, m_vOldTexts, m_vTexts);
+      }
+    }
+    if (!m_strQuickSearch.empty())
+    {
+      if (MatchesQuickSearch(it->second))
+      {
+        m_quickSearchIds.Insert(id);
+      }
+      else
+      {
+        m_quickSearchIds.Erase(id);
+      }
+    }
+
+    if (m_nTransactionDepth > 0)
+    {
+      // Defer invalidation to CommitTransaction
+      m_vDirtyIds.push_back(id);
+      m_bTransactionInserted   = m_bTransactionInserted || inserted;
+      m_bTransactionAppendOnly = m_bTransactionAppendOnly && appended;
+      if (appended)
+      {
+        m_vAppendedRows.push_back(&*it);
+      }
+      return;
+    }
+
+    // Invalidate sorted data
+    m_bSortedValid   = false;
+    m_bFilteredValid = false;
+  }
+  // Sort rows by a specific column. With a lazyWindow only the first
+  // lazyWindow positions are ordered now; the rest is ordered on demand by
+  // GetViewNode / EnsureSorted or step by step by RefineSortStep.
+  void SortByColumn(size_t col, bool ascending = true, size_t lazyWindow = 0)
+  {
+    if (col >= N)
+      return;
+
+    m_vSortedRows.clear();
+    m_vSortedRows.reserve(m_vRows.size());
+    for (const auto& pair : m_vRows)
+    {
+      m_vSortedRows.push_back(&pair);
+    }
+
+    m_nSortedCol       = col;
+    m_bSortedAscending = ascending;
+    m_bSortOrderStale  = false;
+    m_bSortedValid     = true;
+    m_bFilteredValid   = false;
+
+    size_t count = m_vSortedRows.size();
+    m_setSortBounds.clear();
+    m_setSortBounds.insert(0);
+    m_setSortBounds.insert(count);
+    m_sortedPositions.Clear();
+
+    if ((lazyWindow == 0 || lazyWindow >= count) && m_arrLookups[col].source)
+    {
+      SortLookupRange(0, count,
+        [](auto first, auto last, auto before)
+      {
+        std::sort(first, last, before);
+      });
+    }
+    else if (lazyWindow == 0 || lazyWindow >= count)
+    {
+      std::sort(
+        m_vSortedRows.begin(),
+        m_vSortedRows.end(),
+        [col, ascending](
+          const RowNode* a,
+          const RowNode* b)
+      {
+        return SortedBefore(a, b, col, ascending);
+      });
+    }
+    else if (m_arrLookups[col].source)
+    {
+      SortLookupRange(0, count,
+        [lazyWindow](auto first, auto last, auto before)
+      {
+        std::nth_element(first, first + lazyWindow, last, before);
+        std::sort(first, first + lazyWindow, before);
+      });
+      m_setSortBounds.insert(lazyWindow);
+      count = lazyWindow;
+    }
+    else
+    {
+      // Top-K: the first window in final order, the rest left unordered
+      // behind its least row, like every partition
+      auto before = [col, ascending](const RowNode* a, const RowNode* b)
+      {
+        return SortedBefore(a, b, col, ascending);
+      };
+      std::nth_element(
+        m_vSortedRows.begin(),
+        m_vSortedRows.begin() + lazyWindow,
+        m_vSortedRows.end(),
+        before);
+      std::sort(
+        m_vSortedRows.begin(),
+        m_vSortedRows.begin() + lazyWindow,
+        before);
+      m_setSortBounds.insert(lazyWindow);
+      count = lazyWindow;
+    }
+
+    if (count > 0)
+    {
+      m_sortedPositions.InsertRange(0, count - 1);
+    }
+  }
+  // Check if a lazy sort has been completed
+  bool IsSortComplete() const
+  {
+    return !m_bSortedValid
+      || m_sortedPositions.Count() == m_vSortedRows.size();
+  }
+  // Put the sorted view positions [first, last) into final order
+  void EnsureSorted(size_t first, size_t last) const
+  {
+    last = (std::min)(last, m_vSortedRows.size());
+    if (!m_bSortedValid || first >= last
+      || m_sortedPositions.ContainsRange(first, last - 1))
+      return;
+
+    // Partition around both ends, then sort the partitions in between
+    SplitSortAt(first);
+    SplitSortAt(last);
+    for (auto it = m_setSortBounds.find(first); *it < last; )
+    {
+      size_t lo = *it;
+      size_t hi = *++it;
+      SortPartition(lo, hi);
+    }
+  }
+  // Do a bounded amount of work towards completing a lazy sort,
+  // returns true while work remains
+  bool RefineSortStep(size_t maxRows = SORT_STEP_ROWS) const
+  {
+    if (IsSortComplete())
+      return false;
+
+    // Sort the first unsorted partition if small, otherwise halve it
+    for (auto it = m_setSortBounds.begin(); *it < m_vSortedRows.size(); )
+    {
+      size_t lo = *it;
+      size_t hi = *++it;
+      if (m_sortedPositions.ContainsRange(lo, hi - 1))
+        continue;
+
+      if (hi - lo <= maxRows)
+      {
+        SortPartition(lo, hi);
+      }
+      else
+      {
+        SplitSortAt(lo + (hi - lo) / 2);
+      }
+      break;
+    }
+    return !IsSortComplete();
+  }
+  // Iterate over rows together with their IDs and apply a function
+  void ForEachWithId(std::function<void(size_t, const RowData&)> func) const
+  {
+    for (ViewIterator it = begin(), last = end(); it != last; ++it)
+    {
+      func(it.Id(), *it);
+    }
+  }
+  // Iterate over rows and apply a function
+  void ForEach(std::function<void(const RowData&)> func) const
+  {
+    for (const RowData& row : *this)
+    {
+      func(row);
+    }
+  }
+  // Iterate over every row in ID order, ignoring filters and sorting
+  void ForEachRowWithId(std::function<void(size_t, const RowData&)> func) const
+  {
+    for (const auto& pair : m_vRows)
+    {
+      func(pair.first, pair.second);
+    }
+  }
+protected:
+  // Put the rows appended by a transaction into the sorted and filtered
+  // views. Appended IDs follow every existing one, so an ID-ordered view
+  // just grows at its end; a sorted view gets them merged in.
+  void MergeAppendedRows()
+  {
+    NodeVector& appended = m_vAppendedRows;
+    if (m_bSortedValid && m_bSortOrderStale)
+    {
+      m_bSortedValid   = false;
+      m_bFilteredValid = false;
+      return;
+    }
+
+    if (m_bSortedValid)
+    {
+      WithSortOrder([&](auto before)
+      {
+        std::sort(appended.begin(), appended.end(), before);
+        MergeIntoSortedRows(before);
+
+        // The filtered view is in final order, the passing rows are
+        // merged into it
+        if (m_bFilteredValid)
+        {
+          NodeVector passed(&m_memory);
+          for (const RowNode* node : appended)
+          {
+            if (PassesFilters(node->first, node->second))
+            {
+              passed.push_back(node);
+            }
+          }
+          size_t size = m_vFilteredRows.size();
+          m_vFilteredRows.resize(size + passed.size());
+          MergeRowsBackward(m_vFilteredRows, 0, size, m_vFilteredRows.size(),
+            passed.data(), passed.size(), before);
+        }
+      });
+      return;
+    }
+
+    if (m_bFilteredValid)
+    {
+      for (const RowNode* node : appended)
+      {
+        if (PassesFilters(node->first, node->second))
+        {
+          m_vFilteredRows.push_back(node);
+        }
+      }
+    }
+  }
+  // Merge the sorted appended rows into the lazily sorted view. A row
+  // joins the last partition whose first (least) row it does not precede;
+  // a sorted partition takes it in order, an unsorted one at its end. The
+  // partitions are walked from the back, so only those after the first
+  // row joined are moved and none is sorted for it.
+  template <typename F>
+  void MergeIntoSortedRows(F before)
+  {
+    NodeVector& nodes    = m_vSortedRows;
+    NodeVector& appended = m_vAppendedRows;
+    size_t      oldSize  = nodes.size();
+    size_t      count    = appended.size();
+    if (count == 0)
+      return;
+
+    nodes.resize(oldSize + count);
+    if (oldSize == 0)
+    {
+      std::copy(appended.begin(), appended.end(), nodes.begin());
+      m_setSortBounds.insert(count);
+      m_sortedPositions.InsertRange(0, count - 1);
+      return;
+    }
+
+    // New [lo, hi) of each partition moved, and whether it is sorted
+    std::vector<std::pair<size_t, size_t>> moved;
+    std::vector<bool>                      sorted;
+    size_t end = nodes.size();
+    size_t hi  = oldSize;
+    auto   it  = m_setSortBounds.find(oldSize);
+    while (count > 0)
+    {
+      size_t lo    = *--it;
+      size_t first = (lo == 0) ? 0 : std::lower_bound(appended.begin(),
+        appended.begin() + count, nodes[lo], before) - appended.begin();
+      bool   inOrder = m_sortedPositions.ContainsRange(lo, hi - 1);
+      if (inOrder)
+      {
+        MergeRowsBackward(nodes, lo, hi, end,
+          appended.data() + first, count - first, before);
+      }
+      else
+      {
+        size_t joined = count - first;
+        std::move_backward(nodes.begin() + lo, nodes.begin() + hi,
+          nodes.begin() + (end - joined));
+        std::copy(appended.begin() + first, appended.begin() + count,
+          nodes.begin() + (end - joined));
+      }
+      moved.emplace_back(lo + first, end);
+      sorted.push_back(inOrder);
+      end   = lo + first;
+      hi    = lo;
+      count = first;
+    }
+
+    // Bounds and sorted positions from the first partition moved on
+    m_setSortBounds.erase(std::next(it), m_setSortBounds.end());
+    m_sortedPositions.EraseRange(*it, oldSize - 1);
+    for (size_t i = 0; i < moved.size(); ++i)
+    {
+      m_setSortBounds.insert(moved[i].first);
+      m_setSortBounds.insert(moved[i].second);
+      if (sorted[i])
+      {
+        m_sortedPositions.InsertRange(moved[i].first, moved[i].second - 1);
+      }
+    }
+  }
+  // Merge count sorted rows into the sorted [lo, hi) of nodes, writing the
+  // result backwards so that it ends at end (end - hi rows further on).
+  // Each row's place is searched for, the rows in between are moved as a
+  // block, and rows before the first one merged not at all if they stay.
+  template <typename F>
+  static void MergeRowsBackward(NodeVector&           nodes,
+                                size_t                lo,
+                                size_t                hi,
+                                size_t                end,
+                                const RowNode* const* rows,
+                                size_t                count,
+                                F                     before)
+  {
+    size_t read = hi;
+    while (count > 0)
+    {
+      const RowNode* row   = rows[--count];
+      size_t         place = std::lower_bound(nodes.begin() + lo,
+        nodes.begin() + read, row, before) - nodes.begin();
+      std::move_backward(nodes.begin() + place, nodes.begin() + read,
+        nodes.begin() + end);
+      end  -= read - place;
+      read  = place;
+      nodes[--end] = row;
+    }
+    if (end != read)
+    {
+      std::move_backward(nodes.begin() + lo, nodes.begin() + read,
+        nodes.begin() + end);
+    }
+  }
+  // Build the per-column indexes on our own resource
+  template <size_t... I>
+  std::array<IndexMap, N> MakeIndexes(std::index_sequence<I...>)
+  {
+    return {{ ((void)I, IndexMap(&m_memory))... }};
+  }
+  // Build the per-column statistics on our own resource
+  template <size_t... I>
+  std::array<ColumnStats<C>, N> MakeStats(std::index_sequence<I...>)
+  {
+    return {{ ((void)I, ColumnStats<C>(&m_memory))... }};
+  }
+  // Rows of the current view in order
+  const NodeVector& ViewNodes() const
+  {
+    if (HasActiveFilters())
+    {
+      if (!m_bFilteredValid)
+      {
+        BuildFilteredView();
+      }
+      return m_vFilteredRows;
+    }
+    if (m_bSortedValid)
+    {
+      EnsureSorted(0, m_vSortedRows.size());
+      return m_vSortedRows;
+    }
+    return IdOrderNodes();
+  }
+  // Rows in ID order
+  const NodeVector& IdOrderNodes() const
+  {
+    if (!m_bIdOrderValid)
+    {
+      m_vIdOrderRows.clear();
+      m_vIdOrderRows.reserve(m_vRows.size());
+      for (const auto& pair : m_vRows)
+      {
+        m_vIdOrderRows.push_back(&pair);
+      }
+      m_bIdOrderValid = true;
+    }
+    return m_vIdOrderRows;
+  }
+  // Collect the rows passing the filters through the planned access path
+  void BuildFilteredView() const
+  {
+    NodeVector& hits = m_vFilteredRows;
+    hits.clear();
+
+    FilterPlan plan = PlanFilter();
+    if ((plan.access == FilterPlan::Access::INDEX
+      || plan.access == FilterPlan::Access::TEXT_SEARCH)
+      && !(m_bSortedValid && m_bSortOrderStale))
+    {
+      // Fetch the few matching rows and put them in view order
+      hits.reserve(plan.estimatedRows);
+      if (plan.access == FilterPlan::Access::INDEX)
+      {
+        CollectIndexRange(plan.col, hits);
+      }
+      else
+      {
+        CollectQuickSearchRows(hits);
+      }
+      if (m_bSortedValid)
+      {
+        WithSortOrder([&](auto before)
+        {
+          std::sort(hits.begin(), hits.end(), before);
+        });
+      }
+      else
+      {
+        std::sort(hits.begin(), hits.end(),
+          [](const RowNode* a, const RowNode* b)
+        {
+          return a->first < b->first;
+        });
+      }
+    }
+    else if (plan.access == FilterPlan::Access::ZONE_SCAN)
+    {
+      // Skip whole blocks whose min/max cannot satisfy the filters
+      for (const auto& zone : m_mapZones)
+      {
+        if (!ZoneMayMatch(zone.second))
+          continue;
+
+        size_t first = zone.first * ZONE_BLOCK_IDS;
+        for (auto it = m_vRows.lower_bound(first);
+          it != m_vRows.end() && it->first - first < ZONE_BLOCK_IDS; ++it)
+        {
+          if (PassesFilters(it->first, it->second))
+          {
+            hits.push_back(&*it);
+          }
+        }
+      }
+    }
+    else
+    {
+      if (m_bSortedValid)
+      {
+        EnsureSorted(0, m_vSortedRows.size());
+      }
+      for (const RowNode* node : m_bSortedValid ? m_vSortedRows : IdOrderNodes())
+      {
+        if (PassesFilters(node->first, node->second))
+        {
+          hits.push_back(node);
+        }
+      }
+    }
+    m_bFilteredValid = true;
+  }
+  // Make pos a partition bound of the lazily sorted view (nth_element).
+  // The least row of [lo, pos) is put back at lo, where FindViewPosition
+  // and MergeIntoSortedRows expect it.
+  void SplitSortAt(size_t pos) const
+  {
+    if (m_setSortBounds.count(pos))
+      return;
+
+    auto   hiIt = m_setSortBounds.upper_bound(pos);
+    size_t hi   = *hiIt;
+    size_t lo   = *std::prev(hiIt);
+    if (!m_sortedPositions.ContainsRange(lo, hi - 1))
+    {
+      if (m_arrLookups[m_nSortedCol].source)
+      {
+        SortLookupRange(lo, hi,
+          [lo, pos](auto first, auto last, auto before)
+        {
+          std::nth_element(first, first + (pos - lo), last, before);
+          std::iter_swap(first, std::min_element(first, first + (pos - lo), before));
+        });
+      }
+      else
+      {
+        size_t col       = m_nSortedCol;
+        bool   ascending = m_bSortedAscending;
+        auto   before    = [col, ascending](const RowNode* a, const RowNode* b)
+        {
+          return SortedBefore(a, b, col, ascending);
+        };
+        std::nth_element(
+          m_vSortedRows.begin() + lo,
+          m_vSortedRows.begin() + pos,
+          m_vSortedRows.begin() + hi,
+          before);
+        std::iter_swap(m_vSortedRows.begin() + lo, std::min_element(
+          m_vSortedRows.begin() + lo, m_vSortedRows.begin() + pos, before));
+      }
+    }
+    m_setSortBounds.insert(pos);
+  }
+  // Fully order the partition [lo, hi) between two bounds
+  void SortPartition(size_t lo, size_t hi) const
+  {
+    if (lo >= hi || m_sortedPositions.ContainsRange(lo, hi - 1))
+      return;
+
+    if (m_arrLookups[m_nSortedCol].source)
+    {
+      SortLookupRange(lo, hi,
+        [](auto first, auto last, auto before)
+      {
+        std::sort(first, last, before);
+      });
+    }
+    else
+    {
+      size_t col       = m_nSortedCol;
+      bool   ascending = m_bSortedAscending;
+      std::sort(
+        m_vSortedRows.begin() + lo,
+        m_vSortedRows.begin() + hi,
+        [col, ascending](const RowNode* a, const RowNode* b)
+      {
+        return SortedBefore(a, b, col, ascending);
+      });
+    }
+    m_sortedPositions.InsertRange(lo, hi - 1);
+  }
+  // Order of two rows in a sorted view, ties are broken by row ID
+  static bool SortedBefore(const RowNode* a,
+                           const RowNode* b,
+                           size_t         col,
+                           bool           ascending)
+  {
+    int result = ColumnDataCompare<C>::Compare(a->second[col], b->second[col]);
+    if (result == 0)
+      return a->first < b->first;
+    return ascending ? result < 0 : result > 0;
+  }
+  // Call func with the order of the sorted view. A lookup column is
+  // compared by its looked up values, resolved at every comparison, which
+  // suits the few rows of a merge or an index fetch; large ranges go
+  // through SortLookupRange.
+  template <typename F>
+  void WithSortOrder(F func) const
+  {
+    size_t col       = m_nSortedCol;
+    bool   ascending = m_bSortedAscending;
+    if (m_arrLookups[col].source)
+    {
+      func([this, col, ascending](const RowNode* a, const RowNode* b)
+      {
+        int result = ColumnDataCompare<C>::Compare(
+          GetCell(a->second, col), GetCell(b->second, col));
+        if (result == 0)
+          return a->first < b->first;
+        return ascending ? result < 0 : result > 0;
+      });
+      return;
+    }
+    func([col, ascending](const RowNode* a, const RowNode* b)
+    {
+      return SortedBefore(a, b, col, ascending);
+    });
+  }
+  // Reorder [lo, hi) of the sorted view by its lookup column with
+  // algorithm, run over a copy keyed by the looked up values so that each
+  // row is resolved once rather than at every comparison
+  template <typename F>
+  void SortLookupRange(size_t lo, size_t hi, F algorithm) const
+  {
+    size_t col       = m_nSortedCol;
+    bool   ascending = m_bSortedAscending;
+    std::vector<KeyedNode> keyed;
+    keyed.reserve(hi - lo);
+    for (size_t i = lo; i < hi; ++i)
+    {
+      keyed.emplace_back(&GetCell(m_vSortedRows[i]->second, col), m_vSortedRows[i]);
+    }
+    algorithm(keyed.begin(), keyed.end(),
+      [ascending](const KeyedNode& a, const KeyedNode& b)
+    {
+      int result = ColumnDataCompare<C>::Compare(*a.first, *b.first);
+      if (result == 0)
+        return a.second->first < b.second->first;
+      return ascending ? result < 0 : result > 0;
+    });
+    for (size_t i = lo; i < hi; ++i)
+    {
+      m_vSortedRows[i] = keyed[i - lo].second;
+    }
+  }
+  // Check a value against a range filter
+  static bool InRange(const RangeFilter& range, const ColumnData<C>& value)
+  {
+    if (range.hasLower && ColumnDataCompare<C>::Compare(value, range.lower) < 0)
+      return false;
+    if (range.PastUpper(value))
+      return false;
+    return true;
+  }
+  // Check if a block's min/max overlaps every active range filter
+  bool ZoneMayMatch(const ZoneEntry& zone) const
+  {
+    for (size_t col = 0; col < N; ++col)
+    {
+      // Zone maps hold the stored values, not the looked up ones
+      const RangeFilter& range = m_arrRangeFilters[col];
+      if (!range.active || m_arrLookups[col].source)
+        continue;
+      if (range.hasLower && ColumnDataCompare<C>::Compare(
+        zone.maxValue[col], range.lower) < 0)
+        return false;
+      if (range.PastUpper(zone.minValue[col]))
+        return false;
+    }
+    return true;
+  }
+  // Extend the zone map block of a row to cover its values
+  void WidenZone(size_t id, const RowData& row)
+  {
+    auto inserted = m_mapZones.emplace(id / ZONE_BLOCK_IDS, ZoneEntry());
+    ZoneEntry& zone = inserted.first->second;
+    for (size_t col = 0; col < N; ++col)
+    {
+      if (inserted.second
+        || ColumnDataCompare<C>::Compare(row[col], zone.minValue[col]) < 0)
+        zone.minValue[col] = row[col];
+      if (inserted.second
+        || ColumnDataCompare<C>::Compare(row[col], zone.maxValue[col]) > 0)
+        zone.maxValue[col] = row[col];
+    }
+  }
+  // Get the index entries matching the range filter of a column
+  std::pair<typename IndexMap::const_iterator,
+            typename IndexMap::const_iterator> IndexRange(size_t col) const
+  {
+    const IndexMap&    index = m_arrIndexes[col];
+    const RangeFilter& range = m_arrRangeFilters[col];
+    return std::make_pair(
+      range.hasLower ? index.lower_bound(IndexEntry(range.lower, 0)) : index.begin(),
+      !range.hasUpper ? index.end()
+        : range.upperOpen ? index.lower_bound(IndexEntry(range.upper, 0))
+                          : index.upper_bound(IndexEntry(range.upper, SIZE_MAX)));
+  }
+  // Count index entries matching a column's range, false if above limit
+  bool CountIndexRange(size_t col, size_t limit, size_t& count) const
+  {
+    auto bounds = IndexRange(col);
+    count = 0;
+    for (auto it = bounds.first; it != bounds.second; ++it)
+    {
+      if (++count > limit)
+        return false;
+    }
+    return true;
+  }
+  // Collect the rows found through an index that pass all filters
+  void CollectIndexRange(size_t col, NodeVector& hits) const
+  {
+    auto bounds = IndexRange(col);
+    for (auto it = bounds.first; it != bounds.second; ++it)
+    {
+      auto row = m_vRows.find(it->second);
+      if (row != m_vRows.end() && PassesFilters(row->first, row->second))
+      {
+        hits.push_back(&*row);
+      }
+    }
+  }
+  // Count the formatted value of every row of a column
+  void RebuildWidthStats(size_t col) const
+  {
+    for (const auto& pair : m_vRows)
+    {
+      m_arrWidthStats[col].Add(pair.second[col].FormatValue());
+    }
+  }
+  // Collect the quick search rows that pass all filters, in ID order
+  void CollectQuickSearchRows(NodeVector& hits) const
+  {
+    for (const auto& range : m_quickSearchIds.GetRanges())
+    {
+      for (auto it = m_vRows.lower_bound(range.first);
+        it != m_vRows.end() && it->first <= range.second; ++it)
+      {
+        if (PassesFilters(it->second))
+        {
+          hits.push_back(&*it);
+        }
+      }
+    }
+  }
+  // Get the folded text of the text-indexed columns of a row, false if no
+  // column is text-indexed
+  bool CollectTexts(const RowData& row, std::vector<std::string>& texts) const
+  {
+    texts.clear();
+    for (size_t col = 0; col < N; ++col)
+    {
+      if (m_arrTextIndexed[col])
+      {
+        texts.push_back(TrigramIndex::Fold(row[col].FormatValue()));
+      }
+    }
+    return !texts.empty();
+  }
+  // Check if the quick search text is in a searched column of a row
+  bool MatchesQuickSearch(const RowData& row) const
+  {
+    bool anyIndexed = std::find(m_arrTextIndexed.begin(),
+      m_arrTextIndexed.end(), true) != m_arrTextIndexed.end();
+    for (size_t col = 0; col < N; ++col)
+    {
+      if ((!anyIndexed || m_arrTextIndexed[col]) && !m_arrLookups[col].source
+        && TrigramIndex::Fold(row[col].FormatValue()).find(m_strQuickSearch) != std::string::npos)
+        return true;
+    }
+    return false;
+  }
+  // Tell the listeners that the outermost transaction begins or commits
+  void NotifyTransaction(bool begin) const
+  {
+    for (const Listener& listener : m_vListeners)
+    {
+      if (listener.onTransaction)
+      {
+        listener.onTransaction(begin);
+      }
+    }
+  }
+  // Remove the index entry of one row
+  void EraseIndexEntry(size_t col, const ColumnData<C>& value, size_t id)
+  {
+    m_arrIndexes[col].erase(IndexEntry(value, id));
+  }
 };
 
 #endif // GUI_WXWIDGETS_MAIN_APP_TABLE_VIEW_EX_H_
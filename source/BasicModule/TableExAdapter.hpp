@@ -11,7 +11,13 @@
 #ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_VIEW_EX_ADAPTER_H_
 #define   GUI_WXWIDGETS_MAIN_APP_TABLE_VIEW_EX_ADAPTER_H_
 
+#include <atomic>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory_resource>
 
 /*****************************************************************************
  * TableExtraInfo for wxListView InsertColumn
@@ -22,6 +28,98 @@ struct TableExtraInfo
   int      width;
 };
 
+/*****************************************************************************
+ *
+ * STRUCT  : ColumnSummary
+ * PURPOSE : Distinct values and histogram of a column for an autofilter
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Unless exact, values holds only the most frequent values and
+ *           their counts and distinct are estimates
+ *
+ *****************************************************************************/
+
+struct ColumnSummary
+{
+  struct Value
+  {
+    wxString               text;
+    size_t                 count;
+  };
+  // Bin covering [lower, upper)
+  struct Bin
+  {
+    double                 lower;
+    double                 upper;
+    size_t                 count;
+  };
+
+  // Values as displayed, in value order
+  std::vector<Value>       values;
+  // Histogram of a numeric column, empty for strings
+  std::vector<Bin>         histogram;
+  // Rows counted and distinct values among them
+  size_t                   rows     = 0;
+  size_t                   distinct = 0;
+  bool                     exact    = true;
+};
+
+/*****************************************************************************
+ *
+ * STRUCT  : ColumnWidthSample
+ * PURPOSE : The longest values of a column, to size it by
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Covers every row of the table, filtered out or not, so that a
+ *           column keeps its width while filters change
+ *
+ *****************************************************************************/
+
+struct ColumnWidthSample
+{
+  // Longest distinct values as displayed, longest first
+  std::vector<wxString>    widest;
+  // Characters in the longest value
+  size_t                   maxLength = 0;
+  // Changes whenever the sample may have, equal means nothing to measure
+  uint64_t                 version   = 0;
+};
+
+/*****************************************************************************
+ *
+ * FUNCTION: AppendDelimitedCell
+ * PURPOSE : Append one cell of a CSV (',') or TSV ('\t') line
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: CSV cells holding a separator, quote or line break are quoted;
+ *           TSV has no quoting, so tabs and line breaks become spaces
+ *
+ *****************************************************************************/
+
+inline void AppendDelimitedCell(std::string& out, const std::string& cell, char separator)
+{
+  if (separator != ',')
+  {
+    for (char ch : cell)
+    {
+      out += (ch == '\t' || ch == '\r' || ch == '\n') ? ' ' : ch;
+    }
+    return;
+  }
+  if (cell.find_first_of(",\"\r\n") == std::string::npos)
+  {
+    out += cell;
+    return;
+  }
+  out += '"';
+  for (char ch : cell)
+  {
+    if (ch == '"')
+    {
+      out += '"';
+    }
+    out += ch;
+  }
+  out += '"';
+}
+
 /*****************************************************************************
  *
  * CLASS   : ITableExAdapter
@@ -35,13 +133,48 @@ class ITableExAdapter
 {
 public:
   virtual void            ExportToCSV(const std::string& filename)      = 0;
+  virtual void              WriteRows(std::string& out,
+                                      const std::vector<size_t>& ids,
+                                      char separator) const             = 0;
   virtual void              SetFilter(size_t col, std::function<bool(
                                                   const void*)> filter) = 0;
+  virtual void         SetRangeFilter(size_t col,
+                                      const std::string& lower,
+                                      const std::string& upper,
+                                      bool upperOpen = false)           = 0;
+  virtual void         SetValueFilter(size_t col,
+                                      const std::vector<wxString>& values,
+                                      bool exclude = false)             = 0;
   virtual void            ClearFilter(size_t col = -1)                  = 0;
+  virtual void         SetQuickSearch(const wxString& text)             = 0;
+  virtual bool       GetColumnSummary(size_t col,
+                                      ColumnSummary& summary)           = 0;
+  virtual bool   GetColumnWidthSample(size_t col,
+                                      ColumnWidthSample& sample)        = 0;
   virtual void           SortByColumn(size_t col,
-                                      bool ascending = true)            = 0;
+                                      bool ascending = true,
+                                      size_t lazyWindow = 0)            = 0;
+  virtual bool             RefineSort(                    )             = 0;
   virtual void     FullRefreshList   (wxListView* listView)             = 0;
   virtual void  PartialRefreshList   (wxListView* listView)             = 0;
+  virtual void         RefreshRows   (wxListView* listView,
+                                      const std::vector<size_t>& ids)   = 0;
+  virtual void          AppendRows   (wxListView* listView,
+                                      const std::vector<size_t>& ids)   = 0;
+  virtual wxString     GetItemText   (long item, long col) const        = 0;
+  virtual void        PrepareItems   (long from, long to)               = 0;
+  virtual bool            GetRowId   (long item, size_t& id) const      = 0;
+  virtual bool        GetItemIndex   (size_t id, long& item) const      = 0;
+  virtual const std::vector<size_t>&
+                      GetItemRowIds  (                    ) const       = 0;
+  virtual bool           IsRowShown  (size_t id) const                  = 0;
+  virtual IdRangeSet   GetShownRowIds(                    ) const       = 0;
+  virtual void             SortRowIds(std::vector<size_t>& ids) const   = 0;
+  virtual void    BeginTransaction   (                    )             = 0;
+  virtual std::vector<size_t>
+                 CommitTransaction   (                    )             = 0;
+  virtual TableExMemoryUsage
+                    GetMemoryUsage   (                    ) const       = 0;
   virtual      ~ITableExAdapter      (                    )       = default;
 };
 
@@ -57,15 +190,35 @@ public:
 template <typename C, size_t N>
 class TableExAdapter : public ITableExAdapter
 {
+protected:
+  // Arena holding the snapshot, released whole each time it is retaken
+  std::pmr::monotonic_buffer_resource      m_snapshotArena;
 public:
   TableEx<C, N>     *table;                 // TableEx object actually used
   TableEx<C, N>      previousTableSnapshot; // Used to compare data changes
+protected:
+  // List item -> row ID; in virtual mode built only when needed
+  mutable std::vector<size_t>              m_vItemIds;
+  // Row ID -> list item
+  mutable std::unordered_map<size_t, long> m_mapItemIndex;
+  // Indicates the list is virtual (items are drawn through GetItemText)
+  bool                                     m_bVirtual      = false;
+  // Indicates m_vItemIds matches the current view, always true unless virtual
+  mutable bool                             m_bItemIdsValid = true;
+  // Converted cell texts of recently drawn rows, keyed by row ID
+  mutable std::unordered_map<size_t, std::array<wxString, N>> m_mapCellCache;
+  // Rows kept in m_mapCellCache before it is dropped (a few screens)
+  static const size_t                      CELL_CACHE_ROWS = 1024;
+  // Rows WriteRows renders per task
+  static const size_t                      WRITE_CHUNK_ROWS = 16384;
+public:
 
   // Constructor
   explicit TableExAdapter(TableEx<C, N> *t)
     : table(t)
-    , previousTableSnapshot(*t)
+    , previousTableSnapshot(&m_snapshotArena)
   {
+    previousTableSnapshot.AssignView(*t);
   }
 
   // Export data to CSV file
@@ -88,33 +241,345 @@ public:
     file << "\n";
 
     // Write row data
-    table->ForEach([&file](const typename TableEx<C, N>::RowData& row)
+    for (const auto& row : *table)
     {
       for (size_t col = 0; col < N; ++col)
       {
-        file << row[col].FormatValueW();
+        file << table->GetCell(row, col).FormatValue();
         if (col < N - 1)
           file << ",";
       }
       file << "\n";
-    });
+    }
 
     file.close();
   }
+  // Append the rows with the given IDs as CSV (',') or TSV ('\t') lines,
+  // skipping IDs no longer in the table. Chunks of rows are rendered on
+  // worker threads; the caller must not modify the table meanwhile.
+  void WriteRows(std::string&               out,
+                 const std::vector<size_t>& ids,
+                 char                       separator) const override
+  {
+    if (!table)
+      return;
+
+    size_t chunks  = (ids.size() + WRITE_CHUNK_ROWS - 1) / WRITE_CHUNK_ROWS;
+    size_t threads = (std::min)(static_cast<size_t>(
+      (std::max)(std::thread::hardware_concurrency(), 1u)), chunks);
+    if (threads <= 1)
+    {
+      WriteRowRange(out, ids.data(), ids.data() + ids.size(), separator);
+      return;
+    }
+
+    // One round of chunks at a time, so at most a round is held twice
+    std::vector<std::string> parts(threads);
+    for (size_t round = 0; round < chunks; round += threads)
+    {
+      size_t              count = (std::min)(threads, chunks - round);
+      std::atomic<size_t> next(0);
+      auto worker = [&]()
+      {
+        for (size_t part = next++; part < count; part = next++)
+        {
+          size_t first = (round + part) * WRITE_CHUNK_ROWS;
+          size_t last  = (std::min)(first + WRITE_CHUNK_ROWS, ids.size());
+          parts[part].clear();
+          WriteRowRange(parts[part], ids.data() + first, ids.data() + last, separator);
+        }
+      };
+      std::vector<std::thread> pool;
+      for (size_t i = 1; i < count; ++i)
+      {
+        pool.emplace_back(worker);
+      }
+      worker();
+      for (std::thread& thread : pool)
+      {
+        thread.join();
+      }
+      for (size_t part = 0; part < count; ++part)
+      {
+        out += parts[part];
+      }
+    }
+  }
   // Set filter function for a specific column
   void SetFilter(size_t col, std::function<bool(const void*)> filter)
   {
     table->SetFilter(col, filter);
   }
+  // Set an inclusive range filter from text, an empty bound is open;
+  // upperOpen leaves the upper bound itself out
+  void SetRangeFilter(size_t             col,
+                      const std::string& lower,
+                      const std::string& upper,
+                      bool               upperOpen = false) override
+  {
+    if (!table || col >= N)
+      return;
+
+    const ColumnInfo<C>& info = table->GetColumnInfo(col);
+    ColumnData<C> lowerValue  = ColumnData<C>::FromText(info.type, lower, info.format);
+    ColumnData<C> upperValue  = ColumnData<C>::FromText(info.type, upper, info.format);
+    table->SetRangeFilter(col,
+      lower.empty() ? nullptr : &lowerValue,
+      upper.empty() ? nullptr : &upperValue,
+      upperOpen);
+  }
+  // Keep the rows whose cell, as displayed, is one of values, or with
+  // exclude those whose cell is none of them
+  void SetValueFilter(size_t                       col,
+                      const std::vector<wxString>& values,
+                      bool                         exclude = false) override
+  {
+    if (!table || col >= N)
+      return;
+
+    auto texts = std::make_shared<std::unordered_set<std::string>>();
+    for (const wxString& value : values)
+    {
+      texts->insert(value.utf8_string());
+    }
+    table->SetFilter(col, [texts, exclude](const void* cell)
+    {
+      return (texts->count(static_cast<const ColumnData<C>*>(cell)->FormatValue()) > 0) != exclude;
+    });
+  }
   // Clear filter for a specific column or all columns if col is out of range
   void ClearFilter(size_t col = -1)
   {
     table->ClearFilter(col);
   }
-  // Sort rows by a specific column
-  void SortByColumn(size_t col, bool ascending = true)
+  // Only show rows containing text, empty text shows all
+  void SetQuickSearch(const wxString& text) override
+  {
+    if (table)
+    {
+      table->SetQuickSearch(text.utf8_string());
+    }
+  }
+  // Summarize a column from its statistics. The first call for a column
+  // enables them, counting the rows once; the table keeps them up to date
+  // from then on, so later calls cost O(distinct values shown).
+  bool GetColumnSummary(size_t col, ColumnSummary& summary) override
+  {
+    // Lookup columns keep no statistics, their values live elsewhere
+    if (!table || col >= N || table->IsLookupColumn(col))
+      return false;
+
+    table->EnableColumnStats(col);
+    const ColumnStats<C>& stats = table->GetColumnStats(col);
+    summary = ColumnSummary();
+    summary.rows     = stats.GetValueCount();
+    summary.distinct = stats.GetDistinctCount();
+    summary.exact    = stats.IsExact();
+    summary.values.reserve(stats.GetValues().size());
+    for (const auto& pair : stats.GetValues())
+    {
+      // Stored values may outlive the column info they were linked to
+      ColumnData<C> value = pair.first;
+      value.columnInfo    = &table->GetColumnInfo(col);
+      summary.values.push_back({ wxString(value.FormatValueW()), pair.second });
+    }
+    for (const auto& bin : stats.GetHistogram())
+    {
+      summary.histogram.push_back({ bin.lower, bin.upper, bin.count });
+    }
+    return true;
+  }
+  // Sample the longest values of a column. The first call for a column
+  // enables its width statistics, measuring the rows once; after that the
+  // table keeps them up to date and the sample comes at no scan.
+  bool GetColumnWidthSample(size_t col, ColumnWidthSample& sample) override
+  {
+    if (!table || col >= N || table->IsLookupColumn(col))
+      return false;
+
+    table->EnableWidthStats(col);
+    const TextWidthStats& stats = table->GetWidthStats(col);
+    sample           = ColumnWidthSample();
+    sample.maxLength = stats.GetMaxLength();
+    sample.version   = stats.GetVersion();
+    for (const TextWidthStats::Value& value : stats.GetWidest())
+    {
+      sample.widest.push_back(wxString::FromUTF8(value.text.data(), value.text.size()));
+    }
+    return true;
+  }
+  // Sort rows by a specific column, lazyWindow > 0 only orders the first
+  // lazyWindow rows now and the rest on demand
+  void SortByColumn(size_t col, bool ascending = true, size_t lazyWindow = 0) override
+  {
+    table->SortByColumn(col, ascending, lazyWindow);
+  }
+  // Continue a lazy sort in idle time, returns true while work remains
+  bool RefineSort() override
+  {
+    return table && table->RefineSortStep();
+  }
+  // Get the text of a cell, used by virtual lists
+  wxString GetItemText(long item, long col) const override
+  {
+    size_t id = 0;
+    if (col < 0 || static_cast<size_t>(col) >= N || !GetRowId(item, id))
+      return wxString();
+
+    // Repaints reuse the texts converted the first time the row was drawn
+    auto cached = m_mapCellCache.find(id);
+    if (cached != m_mapCellCache.end())
+      return cached->second[col];
+
+    const typename TableEx<C, N>::RowData* row = table->GetRow(id);
+    if (!row)
+      return wxString();
+
+    if (m_mapCellCache.size() >= CELL_CACHE_ROWS)
+    {
+      m_mapCellCache.clear();
+    }
+    std::array<wxString, N>& texts = m_mapCellCache[id];
+    for (size_t i = 0; i < N; ++i)
+    {
+      texts[i] = table->GetCell(*row, i).FormatValueW();
+    }
+    return texts[col];
+  }
+  // Order the rows of items [from, to] ahead of drawing them
+  void PrepareItems(long from, long to) override
+  {
+    if (table && m_bVirtual && !table->HasActiveFilters() && from >= 0 && to >= from)
+    {
+      table->EnsureSorted(from, static_cast<size_t>(to) + 1);
+    }
+  }
+  // Get the row ID displayed by a list item
+  bool GetRowId(long item, size_t& id) const override
+  {
+    if (!m_bItemIdsValid)
+    {
+      const typename TableEx<C, N>::RowNode* node =
+        (table && item >= 0) ? table->GetViewNode(item) : nullptr;
+      if (!node)
+        return false;
+
+      id = node->first;
+      return true;
+    }
+    if (item < 0 || static_cast<size_t>(item) >= m_vItemIds.size())
+      return false;
+
+    id = m_vItemIds[item];
+    return true;
+  }
+  // Get the list item displaying a row ID. A virtual list looks the row up
+  // in the view, which leaves a lazy sort lazy.
+  bool GetItemIndex(size_t id, long& item) const override
+  {
+    if (!m_bItemIdsValid)
+    {
+      size_t pos = 0;
+      if (!table || !table->FindViewPosition(id, pos))
+        return false;
+
+      item = static_cast<long>(pos);
+      return true;
+    }
+    auto it = m_mapItemIndex.find(id);
+    if (it == m_mapItemIndex.end())
+      return false;
+
+    item = it->second;
+    return true;
+  }
+  // Get the row IDs of all list items in display order
+  const std::vector<size_t>& GetItemRowIds() const override
   {
-    table->SortByColumn(col, ascending);
+    EnsureItemIds();
+    return m_vItemIds;
+  }
+  // Check if a row is shown, without finding its item
+  bool IsRowShown(size_t id) const override
+  {
+    if (m_bItemIdsValid)
+      return m_mapItemIndex.find(id) != m_mapItemIndex.end();
+
+    const typename TableEx<C, N>::RowData* row = table ? table->GetRow(id) : nullptr;
+    return row && table->PassesFilters(id, *row);
+  }
+  // Get the IDs of all shown rows, in ID order
+  IdRangeSet GetShownRowIds() const override
+  {
+    std::vector<size_t> ids;
+    if (m_bItemIdsValid)
+    {
+      ids = m_vItemIds;
+      std::sort(ids.begin(), ids.end());
+    }
+    else if (table)
+    {
+      bool filtered = table->HasActiveFilters();
+      ids.reserve(table->GetRowCount());
+      table->ForEachRowWithId([&](size_t id, const typename TableEx<C, N>::RowData& row)
+      {
+        if (!filtered || table->PassesFilters(id, row))
+        {
+          ids.push_back(id);
+        }
+      });
+    }
+    return IdRangeSet::FromSorted(ids);
+  }
+  // Put shown row IDs in display order, dropping the others
+  void SortRowIds(std::vector<size_t>& ids) const override
+  {
+    if (!m_bItemIdsValid)
+    {
+      // Compare the rows rather than finish ordering a lazily sorted view
+      if (table)
+      {
+        table->SortIdsInViewOrder(ids);
+      }
+      return;
+    }
+    std::vector<std::pair<long, size_t>> items;
+    for (size_t id : ids)
+    {
+      auto it = m_mapItemIndex.find(id);
+      if (it != m_mapItemIndex.end())
+      {
+        items.emplace_back(it->second, id);
+      }
+    }
+    std::sort(items.begin(), items.end());
+    ids.clear();
+    for (const auto& item : items)
+    {
+      ids.push_back(item.second);
+    }
+  }
+  // Start a batch of row updates on the table
+  void BeginTransaction() override
+  {
+    if (table)
+      table->BeginTransaction();
+  }
+  // Finish a batch of row updates, returns the IDs that were written
+  std::vector<size_t> CommitTransaction() override
+  {
+    return table ? table->CommitTransaction() : std::vector<size_t>();
+  }
+  // Report the memory of the table plus the snapshot kept for diffing
+  TableExMemoryUsage GetMemoryUsage() const override
+  {
+    TableExMemoryUsage usage;
+    if (table)
+    {
+      usage = table->GetMemoryUsage();
+    }
+    usage += previousTableSnapshot.GetMemoryUsage();
+    return usage;
   }
   // Full Refresh: Clear all data and reload
   void FullRefreshList(wxListView* listView) override
@@ -135,20 +600,32 @@ public:
         table->GetColumnInfo(col).extraInfo.width);
     }
 
+    m_bVirtual = listView->IsVirtual();
+    if (m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      listView->Thaw();
+      return;
+    }
+
     // Insert all data
     int rowIndex = 0;
-    table->ForEach([&](const typename TableEx<C, N>::RowData& row)
+    m_vItemIds.clear();
+    m_vItemIds.reserve(table->size());
+    for (auto it = table->begin(), last = table->end(); it != last; ++it)
     {
-      long itemIndex = listView->InsertItem(rowIndex, row[0].FormatValueW());
+      long itemIndex = listView->InsertItem(rowIndex, table->GetCell(*it, 0).FormatValueW());
       for (size_t col = 1; col < N; ++col)
       {
-        listView->SetItem(itemIndex, col, row[col].FormatValueW());
+        listView->SetItem(itemIndex, col, table->GetCell(*it, col).FormatValueW());
       }
+      m_vItemIds.push_back(it.Id());
       ++rowIndex;
-    });
+    }
+    RebuildItemIndex();
 
     // Record the latest data snapshot
-    previousTableSnapshot = *table;
+    TakeSnapshot();
     listView->Thaw();
   }
   // Partial Refresh: Only update changed rows
@@ -157,62 +634,299 @@ public:
     if (!table || !listView)
       return;
 
+    if (m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      return;
+    }
+
     listView->Freeze();
 
-    // Read new data
-    std::vector<typename TableEx<C, N>::RowData> newData;
-    table->ForEach([&](const typename TableEx<C, N>::RowData& row)
-    {
-      newData.push_back(row);
-    });
-    // Read old data
-    std::vector<typename TableEx<C, N>::RowData> oldData;
-    previousTableSnapshot.ForEach([&](const typename TableEx<C, N>::RowData& row)
-    {
-      oldData.push_back(row);
-    });
+    // Walk new and old views in place, no rows are copied
+    const TableEx<C, N>& newData = *table;
+    const TableEx<C, N>& oldData = previousTableSnapshot;
+    auto   newRow  = newData.begin();
+    auto   oldRow  = oldData.begin();
+    size_t newSize = newData.size();
+    size_t oldSize = oldData.size();
 
     // Calculate the number of rows
-    size_t minSize = (newData.size() < oldData.size()) ? newData.size() : oldData.size();
-    size_t maxSize = (newData.size() > oldData.size()) ? newData.size() : oldData.size();
+    size_t minSize = (newSize < oldSize) ? newSize : oldSize;
+
+    std::vector<size_t> newIds;
+    newIds.reserve(newSize);
 
     // Update existing row data column by column
-    for (size_t rowIndex = 0; rowIndex < minSize; ++rowIndex)
+    for (size_t rowIndex = 0; rowIndex < minSize; ++rowIndex, ++newRow, ++oldRow)
+    {
+      for (size_t col = 0; col < N; ++col)
       {
-        for (size_t col = 0; col < N; ++col)
-        {
-          wxString newValue = newData[rowIndex][col].FormatValueW();
-          wxString oldValue = oldData[rowIndex][col].FormatValueW();
+        const ColumnData<C>& newValue = newData.GetCell(*newRow, col);
+        const ColumnData<C>& oldValue = oldData.GetCell(*oldRow, col);
 
-          if (newValue != oldValue) // **只有该列数据不同才更新**
-          {
-            listView->SetItem(rowIndex, col, newValue);
-          }
+        if (newValue.type != oldValue.type
+          || ColumnDataCompare<C>::Compare(newValue, oldValue) != 0) // **只有该列数据不同才更新**
+        {
+          listView->SetItem(rowIndex, col, newValue.FormatValueW());
         }
       }
+      newIds.push_back(newRow.Id());
+    }
 
     // If the new data is more than the old data, insert a new row
-    for (size_t rowIndex = minSize; rowIndex < newData.size(); ++rowIndex)
+    for (size_t rowIndex = minSize; rowIndex < newSize; ++rowIndex, ++newRow)
     {
       long itemIndex = listView->InsertItem(
-        rowIndex, newData[rowIndex][0].FormatValueW());
+        rowIndex, newData.GetCell(*newRow, 0).FormatValueW());
       for (size_t col = 1; col < N; ++col)
       {
         listView->SetItem(
-          itemIndex, col, newData[rowIndex][col].FormatValueW());
+          itemIndex, col, newData.GetCell(*newRow, col).FormatValueW());
       }
+      newIds.push_back(newRow.Id());
     }
 
     // If the old data is more than the new data, delete the extra rows
-    for (size_t rowIndex = newData.size(); rowIndex < oldData.size(); ++rowIndex)
+    for (size_t rowIndex = newSize; rowIndex < oldSize; ++rowIndex)
     {
-      listView->DeleteItem(newData.size());
+      listView->DeleteItem(newSize);
     }
 
     // Record the latest data snapshot
-    previousTableSnapshot = *table;
+    m_vItemIds.swap(newIds);
+    RebuildItemIndex();
+    TakeSnapshot();
+    listView->Thaw();
+  }
+  // Targeted Refresh: Only rewrite the items showing the given row IDs
+  void RefreshRows(wxListView* listView, const std::vector<size_t>& ids) override
+  {
+    if (!table || !listView || ids.empty())
+      return;
+
+    if (m_bVirtual)
+    {
+      // Only the visible items are redrawn
+      RefreshVirtualList(listView);
+      return;
+    }
+
+    // Rows that appear, disappear or are new change the item layout,
+    // which only a partial refresh can handle
+    for (size_t id : ids)
+    {
+      const typename TableEx<C, N>::RowData* row = table->GetRow(id);
+      bool shown   = m_mapItemIndex.find(id) != m_mapItemIndex.end();
+      bool visible = row && table->PassesFilters(id, *row);
+      if (shown != visible)
+      {
+        PartialRefreshList(listView);
+        return;
+      }
+    }
+
+    listView->Freeze();
+
+    // The snapshot mirrors what is displayed, so only shown rows go into it
+    previousTableSnapshot.BeginTransaction();
+    for (size_t id : ids)
+    {
+      auto it = m_mapItemIndex.find(id);
+      if (it == m_mapItemIndex.end())
+        continue;
+
+      const typename TableEx<C, N>::RowData& row = *table->GetRow(id);
+      for (size_t col = 0; col < N; ++col)
+      {
+        listView->SetItem(it->second, col, table->GetCell(row, col).FormatValueW());
+      }
+      previousTableSnapshot.UpsertRow(id, row);
+    }
+    previousTableSnapshot.CommitTransaction();
+
     listView->Thaw();
   }
+  // Append Refresh: Add items for new rows whose IDs follow every shown
+  // row, without diffing the rest. Virtual lists only update their item
+  // count; a sorted view needs a partial refresh to place the rows.
+  void AppendRows(wxListView* listView, const std::vector<size_t>& ids) override
+  {
+    if (!table || !listView || ids.empty())
+      return;
+
+    if (m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      return;
+    }
+    if (!m_vItemIds.empty() && ids.front() <= m_vItemIds.back())
+    {
+      PartialRefreshList(listView);
+      return;
+    }
+
+    // A sorted view has the rows merged in; they are inserted in view
+    // order, each at its position, so the items before it stay put
+    std::vector<size_t> shown = ids;
+    table->SortIdsInViewOrder(shown);
+
+    listView->Freeze();
+    previousTableSnapshot.BeginTransaction();
+    size_t firstMoved = m_vItemIds.size();
+    for (size_t id : shown)
+    {
+      const typename TableEx<C, N>::RowData* row = table->GetRow(id);
+      size_t                                 pos = m_vItemIds.size();
+      if (table->IsSorted() && !table->FindViewPosition(id, pos))
+        continue;
+
+      pos = (std::min)(pos, m_vItemIds.size());
+      long itemIndex = listView->InsertItem(
+        static_cast<long>(pos), table->GetCell(*row, 0).FormatValueW());
+      for (size_t col = 1; col < N; ++col)
+      {
+        listView->SetItem(itemIndex, col, table->GetCell(*row, col).FormatValueW());
+      }
+      m_vItemIds.insert(m_vItemIds.begin() + pos, id);
+      firstMoved = (std::min)(firstMoved, pos);
+      previousTableSnapshot.UpsertRow(id, *row);
+    }
+    for (size_t item = firstMoved; item < m_vItemIds.size(); ++item)
+    {
+      m_mapItemIndex[m_vItemIds[item]] = static_cast<long>(item);
+    }
+    previousTableSnapshot.CommitTransaction();
+    listView->Thaw();
+  }
+  // Lookup Refresh: Take in reference changes (TableEx::SyncLookups) and
+  // redraw only the items whose looked up values changed, of a virtual
+  // list only the visible ones. A filter on a changed lookup column may
+  // change the view, which then gets the usual refresh.
+  void RefreshLookups(wxListView* listView)
+  {
+    bool reset = false;
+    if (!table || !listView || !table->SyncLookups(reset))
+      return;
+
+    if (reset && m_bVirtual)
+    {
+      RefreshVirtualList(listView);
+      return;
+    }
+    if (reset)
+    {
+      // Rows kept by the diff are compared by their current lookups, so
+      // the changed ones are still rewritten below
+      PartialRefreshList(listView);
+    }
+
+    if (m_bVirtual)
+    {
+      long first = (std::max)(listView->GetTopItem(), 0L);
+      long last  = (std::min)(first + listView->GetCountPerPage() + 1,
+                              static_cast<long>(listView->GetItemCount()));
+      for (long item = first; item < last; ++item)
+      {
+        const typename TableEx<C, N>::RowNode* node = table->GetViewNode(item);
+        if (node && table->LookupChanged(node->second))
+        {
+          m_mapCellCache.erase(node->first);
+          listView->RefreshItem(item);
+        }
+      }
+      return;
+    }
+
+    // Every item of a report list holds its texts, so all dependents are
+    // rewritten; the snapshot resolves through the same lookups already
+    listView->Freeze();
+    for (size_t item = 0; item < m_vItemIds.size(); ++item)
+    {
+      const typename TableEx<C, N>::RowData* row = table->GetRow(m_vItemIds[item]);
+      if (!row || !table->LookupChanged(*row))
+        continue;
+
+      for (size_t col = 0; col < N; ++col)
+      {
+        if (table->IsLookupColumn(col))
+        {
+          listView->SetItem(static_cast<long>(item), col, table->GetCell(*row, col).FormatValueW());
+        }
+      }
+    }
+    listView->Thaw();
+  }
+protected:
+  // Copy the table into the snapshot. The old snapshot is cleared and its
+  // arena released first, so taking a snapshot costs one pass of bump
+  // allocations instead of a free and a malloc per row.
+  void TakeSnapshot()
+  {
+    previousTableSnapshot.Clear();
+    m_snapshotArena.release();
+    previousTableSnapshot.AssignView(*table);
+  }
+  // Append the rows of IDs [first, last) as delimited lines
+  void WriteRowRange(std::string&  out,
+                     const size_t* first,
+                     const size_t* last,
+                     char          separator) const
+  {
+    for (; first != last; ++first)
+    {
+      const auto* row = table->GetRow(*first);
+      if (!row)
+        continue;
+
+      for (size_t col = 0; col < N; ++col)
+      {
+        if (col > 0)
+        {
+          out += separator;
+        }
+        AppendDelimitedCell(out, table->GetCell(*row, col).FormatValue(), separator);
+      }
+      out += '\n';
+    }
+  }
+  // Virtual Refresh: Update the item count and redraw the visible items.
+  // Items map straight onto table view positions, so no per-item state is
+  // built and a lazy sort of an unfiltered view stays lazy.
+  void RefreshVirtualList(wxListView* listView)
+  {
+    m_mapCellCache.clear();
+    m_bItemIdsValid = false;
+    m_vItemIds.clear();
+    m_mapItemIndex.clear();
+
+    listView->SetItemCount(static_cast<long>(table->size()));
+    listView->Refresh();
+  }
+  // Build the item <-> row ID mapping of a virtual list on first use
+  void EnsureItemIds() const
+  {
+    if (m_bItemIdsValid || !table)
+      return;
+
+    m_vItemIds.clear();
+    m_vItemIds.reserve(table->size());
+    for (auto it = table->begin(), last = table->end(); it != last; ++it)
+    {
+      m_vItemIds.push_back(it.Id());
+    }
+    RebuildItemIndex();
+    m_bItemIdsValid = true;
+  }
+  // Rebuild the row ID -> list item lookup from m_vItemIds
+  void RebuildItemIndex() const
+  {
+    m_mapItemIndex.clear();
+    m_mapItemIndex.reserve(m_vItemIds.size());
+    for (size_t item = 0; item < m_vItemIds.size(); ++item)
+    {
+      m_mapItemIndex[m_vItemIds[item]] = static_cast<long>(item);
+    }
+  }
 };
 
 #endif // GUI_WXWIDGETS_MAIN_APP_TABLE_VIEW_EX_ADAPTER_H_
@@ -0,0 +1,108 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <wx/wx.h>
+#include <wx/dataobj.h>
+#include "TableEx.hpp"
+#include "TableExAdapter.hpp"
+#include "TableExDataObject.h"
+
+TableExClipboardRows::TableExClipboardRows(ITableExAdapter* adapter, std::vector<size_t>&& ids)
+  : m_adapter    (adapter)
+  , m_vIds       (std::move(ids))
+  , m_arrRendered{ false, false }
+{
+}
+
+const std::string& TableExClipboardRows::Render(Format format)
+{
+  size_t index = static_cast<size_t>(format);
+  if (m_arrRendered[index])
+    return m_arrText[index];
+
+  m_arrRendered[index] = true;
+  if (m_adapter)
+  {
+    m_adapter->WriteRows(m_arrText[index], m_vIds,
+      (format == Format::CSV) ? ',' : '\t');
+  }
+  if (m_arrRendered[0] && m_arrRendered[1])
+  {
+    std::vector<size_t>().swap(m_vIds);
+  }
+  return m_arrText[index];
+}
+
+void TableExClipboardRows::Detach(bool keepData)
+{
+  if (keepData)
+  {
+    Render(Format::TSV);
+    Render(Format::CSV);
+  }
+  m_adapter = nullptr;
+}
+
+wxDataObject* TableExClipboardRows::CreateDataObject(
+  const std::shared_ptr<TableExClipboardRows>& rows)
+{
+  wxDataObjectComposite* composite = new wxDataObjectComposite();
+  composite->Add(new TableExTextDataObject(rows), true);
+  composite->Add(new TableExCsvDataObject (rows));
+  return composite;
+}
+
+TableExTextDataObject::TableExTextDataObject(std::shared_ptr<TableExClipboardRows> rows)
+  : m_pRows      (std::move(rows))
+  , m_nTextLength(0)
+  , m_bHasLength (false)
+{
+}
+
+size_t TableExTextDataObject::GetTextLength() const
+{
+  if (!m_bHasLength)
+  {
+    // Count what GetText would convert to; invalid UTF-8 converts to
+    // nothing there as well
+    const std::string& text = m_pRows->Render(TableExClipboardRows::Format::TSV);
+    size_t length = wxConvUTF8.ToWChar(nullptr, 0, text.data(), text.size());
+    m_nTextLength = (length == wxCONV_FAILED) ? 0 : length;
+    m_bHasLength  = true;
+  }
+  // Room for the trailing NUL, as the base class counts it
+  return m_nTextLength + 1;
+}
+
+wxString TableExTextDataObject::GetText() const
+{
+  const std::string& text = m_pRows->Render(TableExClipboardRows::Format::TSV);
+  return wxString::FromUTF8(text.data(), text.size());
+}
+
+TableExCsvDataObject::TableExCsvDataObject(std::shared_ptr<TableExClipboardRows> rows)
+#ifdef __WXMSW__
+  : wxCustomDataObject(wxDataFormat("Csv"))
+#else
+  : wxCustomDataObject(wxDataFormat("text/csv"))
+#endif
+  , m_pRows(std::move(rows))
+{
+}
+
+size_t TableExCsvDataObject::GetSize() const
+{
+  return m_pRows->Render(TableExClipboardRows::Format::CSV).size();
+}
+
+void* TableExCsvDataObject::GetData() const
+{
+  return const_cast<char*>(m_pRows->Render(TableExClipboardRows::Format::CSV).data());
+}
@@ -0,0 +1,110 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_DATA_OBJECT_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_DATA_OBJECT_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <wx/dataobj.h>
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExClipboardRows
+ * PURPOSE : Rows put on the clipboard, rendered as text when pasted
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Copying only keeps the row IDs. A format is rendered from the
+ *           adapter the first time a paste target asks for it and kept
+ *           from then on, so the rows are as they were at the first paste.
+ *           Rendering runs on the GUI thread (clipboard requests arrive
+ *           there), which leaves the adapter free to use worker threads.
+ *           The data objects share it with the list, which must Detach it
+ *           before the adapter goes away.
+ *
+ *****************************************************************************/
+
+class TableExClipboardRows
+{
+public:
+  enum class Format
+  {
+    TSV,
+    CSV
+  };
+
+  TableExClipboardRows(ITableExAdapter* adapter, std::vector<size_t>&& ids);
+
+  // Text of the rows in a format, rendered on first use
+  const std::string& Render   (Format format);
+  // Stop using the adapter; formats not rendered yet are rendered first
+  // if keepData, otherwise they paste empty
+  void               Detach   (bool keepData);
+  // Number of rows copied
+  size_t             GetRowCount() const { return m_vIds.size(); }
+
+  // Clipboard object offering the rows as text (TSV) and as CSV
+  static wxDataObject* CreateDataObject(const std::shared_ptr<TableExClipboardRows>& rows);
+protected:
+  ITableExAdapter       *m_adapter;
+  // Row IDs in view order, released once every format is rendered
+  std::vector<size_t>    m_vIds;
+  // Rendered text by Format, valid when m_arrRendered is set
+  std::string            m_arrText[2];
+  bool                   m_arrRendered[2];
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExTextDataObject
+ * PURPOSE : Plain text (TSV) clipboard format of TableExClipboardRows
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Overrides the text accessors, so the text is only built when
+ *           asked for. The length is worked out from the UTF-8 text once,
+ *           without a wide copy, so only GetText converts the rows.
+ *
+ *****************************************************************************/
+
+class TableExTextDataObject : public wxTextDataObject
+{
+public:
+  explicit TableExTextDataObject(std::shared_ptr<TableExClipboardRows> rows);
+
+  size_t   GetTextLength() const override;
+  wxString GetText      () const override;
+protected:
+  std::shared_ptr<TableExClipboardRows> m_pRows;
+  // Length of the converted text in characters, valid once m_bHasLength
+  mutable size_t                        m_nTextLength;
+  mutable bool                          m_bHasLength;
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExCsvDataObject
+ * PURPOSE : CSV clipboard format of TableExClipboardRows (UTF-8)
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Registered as "Csv" on Windows, as spreadsheets there expect,
+ *           and as "text/csv" elsewhere
+ *
+ *****************************************************************************/
+
+class TableExCsvDataObject : public wxCustomDataObject
+{
+public:
+  explicit TableExCsvDataObject(std::shared_ptr<TableExClipboardRows> rows);
+
+  size_t   GetSize      () const override;
+  void*    GetData      () const override;
+protected:
+  std::shared_ptr<TableExClipboardRows> m_pRows;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_DATA_OBJECT_H_
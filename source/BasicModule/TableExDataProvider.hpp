@@ -0,0 +1,677 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_DATA_PROVIDER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_DATA_PROVIDER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <queue>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*****************************************************************************
+ *
+ * STRUCT  : TableExQuery
+ * PURPOSE : Order and filters of the rows a data provider serves
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: sortCol == N keeps the provider's natural order
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+struct TableExQuery
+{
+  using RangeFilter = typename TableEx<C, N>::RangeFilter;
+
+  size_t                           sortCol   = N;
+  bool                             ascending = true;
+  std::array<RangeFilter, N>       filters;
+
+  // Check if any range filter is set
+  bool HasFilters() const
+  {
+    for (const RangeFilter& filter : filters)
+    {
+      if (filter.active)
+        return true;
+    }
+    return false;
+  }
+  // Check if a row passes every range filter
+  bool Matches(const std::array<ColumnData<C>, N>& row) const
+  {
+    for (size_t col = 0; col < N; ++col)
+    {
+      const RangeFilter& filter = filters[col];
+      if (!filter.active)
+        continue;
+      if (filter.hasLower && ColumnDataCompare<C>::Compare(row[col], filter.lower) < 0)
+        return false;
+      if (filter.PastUpper(row[col]))
+        return false;
+    }
+    return true;
+  }
+};
+
+/*****************************************************************************
+ *
+ * STRUCT  : TableExPage
+ * PURPOSE : One page of rows answered by a data provider
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: A page may hold fewer rows than requested at the end of the
+ *           data. totalRows is an estimate until totalExact is set.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+struct TableExPage
+{
+  using RowData = std::array<ColumnData<C>, N>;
+
+  uint64_t                         generation = 0;     // Query generation
+  size_t                           offset     = 0;     // Position of rows[0]
+  size_t                           totalRows  = 0;     // Rows of the query
+  bool                             totalExact = false;
+  bool                             ok         = false; // False if dropped or failed
+  std::vector<size_t>              ids;
+  std::vector<RowData>             rows;
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : ITableExDataProvider
+ * PURPOSE : Source of table rows served in pages, for datasets that are
+ *           not materialized in a TableEx
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Pages are answered asynchronously; the callback may run on any
+ *           thread and is called exactly once per request. Each query
+ *           change gets a new generation, pages of older generations may
+ *           still arrive and are dropped by the caller.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class ITableExDataProvider
+{
+public:
+  using Query        = TableExQuery<C, N>;
+  using Page         = TableExPage<C, N>;
+  using PageCallback = std::function<void(Page&&)>;
+
+  virtual const ColumnInfo<C>& GetColumnInfo(size_t col) const             = 0;
+  // Ask for rows [offset, offset + count) of a query
+  virtual void                 RequestPage  (const Query&  query,
+                                             uint64_t      generation,
+                                             size_t        offset,
+                                             size_t        count,
+                                             PageCallback  done)            = 0;
+  // Answer queued requests of generations before the given one as dropped
+  virtual void                 CancelBefore (uint64_t      generation)      = 0;
+  virtual                     ~ITableExDataProvider()                 = default;
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : ThreadedTableExDataProvider
+ * PURPOSE : Data provider base answering requests on one worker thread
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Derived classes implement ReadPage, which runs on the worker
+ *           only. The newest request is served first, so the page under a
+ *           fast scroll is read before those scrolled past. Derived
+ *           destructors must call Stop() before their members go away.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class ThreadedTableExDataProvider : public ITableExDataProvider<C, N>
+{
+public:
+  using typename ITableExDataProvider<C, N>::Query;
+  using typename ITableExDataProvider<C, N>::Page;
+  using typename ITableExDataProvider<C, N>::PageCallback;
+protected:
+  struct Request
+  {
+    Query                          query;
+    uint64_t                       generation;
+    size_t                         offset;
+    size_t                         count;
+    PageCallback                   done;
+  };
+  std::mutex                       m_mutex;
+  std::condition_variable          m_condition;
+  std::deque<Request>              m_queRequests;
+  std::thread                      m_worker;
+  bool                             m_bStopping = false;
+public:
+  ~ThreadedTableExDataProvider() override
+  {
+    Stop();
+  }
+  void RequestPage(const Query&  query,
+                   uint64_t      generation,
+                   size_t        offset,
+                   size_t        count,
+                   PageCallback  done) override
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_bStopping)
+    {
+      // Still answered exactly once, as dropped
+      lock.unlock();
+      Request request = { query, generation, offset, count, std::move(done) };
+      Answer(request, false, Page());
+      return;
+    }
+
+    // Started on first use, a derived object is complete by then
+    if (!m_worker.joinable())
+    {
+      m_worker = std::thread(&ThreadedTableExDataProvider::WorkerLoop, this);
+    }
+    m_queRequests.push_back({ query, generation, offset, count, std::move(done) });
+    m_condition.notify_one();
+  }
+  void CancelBefore(uint64_t generation) override
+  {
+    std::deque<Request> dropped;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (auto it = m_queRequests.begin(); it != m_queRequests.end(); )
+      {
+        if (it->generation < generation)
+        {
+          dropped.push_back(std::move(*it));
+          it = m_queRequests.erase(it);
+        }
+        else
+        {
+          ++it;
+        }
+      }
+    }
+    for (Request& request : dropped)
+    {
+      Answer(request, false, Page());
+    }
+  }
+protected:
+  // Read the rows of a request into page (ids, rows, totals), false on error
+  virtual bool ReadPage(const Request& request, Page& page) = 0;
+
+  // Stop the worker, requests still queued are answered as dropped
+  void Stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_bStopping = true;
+      m_condition.notify_one();
+    }
+    if (m_worker.joinable())
+    {
+      m_worker.join();
+    }
+    for (Request& request : m_queRequests)
+    {
+      Answer(request, false, Page());
+    }
+    m_queRequests.clear();
+  }
+  void WorkerLoop()
+  {
+    for (;;)
+    {
+      Request request;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]()
+        {
+          return m_bStopping || !m_queRequests.empty();
+        });
+        if (m_bStopping)
+          return;
+
+        request = std::move(m_queRequests.back());
+        m_queRequests.pop_back();
+      }
+      Page page;
+      bool ok = ReadPage(request, page);
+      Answer(request, ok, std::move(page));
+    }
+  }
+  static void Answer(Request& request, bool ok, Page page)
+  {
+    page.generation = request.generation;
+    page.offset     = request.offset;
+    page.ok         = ok;
+    if (request.done)
+    {
+      request.done(std::move(page));
+    }
+  }
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : CsvTableExDataProvider
+ * PURPOSE : Reference data provider reading rows from a local CSV file
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Row IDs are line numbers (header excluded). A sparse index
+ *           keeps the byte offset of every INDEX_STRIDE-th line and grows
+ *           as pages further down are read, so natural order costs 8 bytes
+ *           per INDEX_STRIDE lines. Until the file has been read to the
+ *           end the row count is estimated from the average line length.
+ *           A filtered or sorted query scans the file once and writes the
+ *           line numbers and offsets of the matching lines to a temporary
+ *           file. A sort keeps at most RUN_BYTES of keys in memory: full
+ *           runs are sorted and spilled to temporary files, then merged
+ *           MERGE_WAYS at a time.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class CsvTableExDataProvider : public ThreadedTableExDataProvider<C, N>
+{
+public:
+  using typename ThreadedTableExDataProvider<C, N>::Query;
+  using typename ThreadedTableExDataProvider<C, N>::Page;
+  using typename ThreadedTableExDataProvider<C, N>::Request;
+  using RowData = std::array<ColumnData<C>, N>;
+
+  // Lines between two entries of the sparse index
+  static const size_t INDEX_STRIDE = 1024;
+  // Memory for the sort keys of one run, and runs merged in one pass
+  static const size_t RUN_BYTES    = 64 << 20;
+  static const size_t MERGE_WAYS   = 64;
+protected:
+  // A matching line while sorting
+  struct SortEntry
+  {
+    ColumnData<C>                  key;
+    uint64_t                       line;
+    uint64_t                       offset;
+  };
+  // Column metadata, types and formats drive parsing
+  std::array<ColumnInfo<C>, N>     m_arrColumnInfo;
+  // Everything below is only used by the worker thread
+  std::ifstream                    m_file;
+  uint64_t                         m_nFileSize       = 0;
+  uint64_t                         m_nDataStart      = 0;
+  // Byte offset of line k * INDEX_STRIDE, and the first line not indexed
+  std::vector<uint64_t>            m_vLineIndex;
+  size_t                           m_nIndexedLines   = 0;
+  uint64_t                         m_nIndexedBytes   = 0;
+  bool                             m_bIndexComplete  = false;
+  // Matching lines of the last filtered or sorted query, as (line number,
+  // byte offset) pairs in a temporary file
+  uint64_t                         m_nResultGeneration = 0;
+  bool                             m_bHasResult      = false;
+  size_t                           m_nResultRows     = 0;
+  std::FILE*                       m_pResultFile     = nullptr;
+public:
+  CsvTableExDataProvider(const std::string&                  filename,
+                         const std::array<ColumnInfo<C>, N>& columnInfo,
+                         bool                                hasHeader = true)
+    : m_arrColumnInfo(columnInfo)
+    , m_file         (filename, std::ios::binary)
+  {
+    if (!m_file.is_open())
+      return;
+
+    m_file.seekg(0, std::ios::end);
+    m_nFileSize = static_cast<uint64_t>(m_file.tellg());
+    m_file.seekg(0, std::ios::beg);
+    std::string line;
+    if (hasHeader && std::getline(m_file, line))
+    {
+      m_nDataStart = static_cast<uint64_t>(m_file.tellg());
+    }
+    m_vLineIndex.push_back(m_nDataStart);
+    m_nIndexedBytes = m_nDataStart;
+  }
+  ~CsvTableExDataProvider() override
+  {
+    this->Stop();
+    if (m_pResultFile)
+    {
+      std::fclose(m_pResultFile);
+    }
+  }
+  // Check if the file could be opened
+  bool IsOpen() const
+  {
+    return m_file.is_open();
+  }
+  const ColumnInfo<C>& GetColumnInfo(size_t col) const override
+  {
+    static ColumnInfo<C> dummyColumn = {};
+    return (col < N) ? m_arrColumnInfo[col] : dummyColumn;
+  }
+protected:
+  bool ReadPage(const Request& request, Page& page) override
+  {
+    if (!m_file.is_open())
+      return false;
+
+    if (request.query.sortCol >= N && !request.query.HasFilters())
+      return ReadNaturalPage(request, page);
+
+    if (!m_bHasResult || m_nResultGeneration != request.generation)
+    {
+      m_bHasResult        = BuildResult(request.query);
+      m_nResultGeneration = request.generation;
+      if (!m_bHasResult)
+        return false;
+    }
+    page.totalRows  = m_nResultRows;
+    page.totalExact = true;
+    if (request.offset >= m_nResultRows)
+      return true;
+
+    // The pairs of the page lie next to each other in the result file
+    size_t                count = std::min(request.count, m_nResultRows - request.offset);
+    std::vector<uint64_t> pairs(2 * count);
+    if (!SeekFile(m_pResultFile, request.offset * 2 * sizeof(uint64_t))
+      || std::fread(pairs.data(), 2 * sizeof(uint64_t), count, m_pResultFile) != count)
+      return false;
+
+    std::string line;
+    for (size_t i = 0; i < count; ++i)
+    {
+      m_file.clear();
+      m_file.seekg(static_cast<std::streamoff>(pairs[2 * i + 1]));
+      std::getline(m_file, line);
+      page.ids .push_back(static_cast<size_t>(pairs[2 * i]));
+      page.rows.push_back(ParseLine(line));
+    }
+    return true;
+  }
+  // Rows in file order, located through the sparse index
+  bool ReadNaturalPage(const Request& request, Page& page)
+  {
+    std::string line;
+    ExtendIndex(request.offset + request.count);
+
+    size_t entry = std::min(request.offset / INDEX_STRIDE, m_vLineIndex.size() - 1);
+    size_t lineNo = entry * INDEX_STRIDE;
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(m_vLineIndex[entry]));
+    while (lineNo < request.offset && std::getline(m_file, line))
+    {
+      ++lineNo;
+    }
+    while (lineNo < request.offset + request.count && std::getline(m_file, line))
+    {
+      page.ids .push_back(lineNo++);
+      page.rows.push_back(ParseLine(line));
+    }
+
+    page.totalExact = m_bIndexComplete;
+    if (m_bIndexComplete)
+    {
+      page.totalRows = m_nIndexedLines;
+    }
+    else
+    {
+      // Estimate the rest of the file from the lines seen so far
+      uint64_t bytes = m_nIndexedBytes - m_nDataStart;
+      page.totalRows = bytes == 0 ? m_nIndexedLines
+        : static_cast<size_t>(static_cast<double>(m_nFileSize - m_nDataStart)
+                              * m_nIndexedLines / bytes);
+      page.totalRows = std::max(page.totalRows, request.offset + page.rows.size() + 1);
+    }
+    return true;
+  }
+  // Index lines until at least lines are known or the file ends
+  void ExtendIndex(size_t lines)
+  {
+    if (m_bIndexComplete || m_nIndexedLines >= lines)
+      return;
+
+    std::string line;
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(m_nIndexedBytes));
+    while (m_nIndexedLines < lines)
+    {
+      if (!std::getline(m_file, line))
+      {
+        m_bIndexComplete = true;
+        break;
+      }
+      ++m_nIndexedLines;
+      m_nIndexedBytes = static_cast<uint64_t>(m_file.tellg());
+      if (m_nIndexedLines % INDEX_STRIDE == 0)
+      {
+        m_vLineIndex.push_back(m_nIndexedBytes);
+      }
+    }
+    if (!m_bIndexComplete && m_nIndexedBytes >= m_nFileSize)
+    {
+      m_bIndexComplete = true;
+    }
+  }
+  // Scan the whole file for the rows of a filtered or sorted query into
+  // a new result file, false if a temporary file fails
+  bool BuildResult(const Query& query)
+  {
+    if (m_pResultFile)
+    {
+      std::fclose(m_pResultFile);
+    }
+    m_pResultFile = std::tmpfile();
+    m_nResultRows = 0;
+    if (!m_pResultFile)
+      return false;
+
+    ExtendIndex(static_cast<size_t>(-1));
+
+    bool                    sorting  = query.sortCol < N;
+    bool                    ok       = true;
+    size_t                  runBytes = 0;
+    std::vector<SortEntry>  run;
+    std::vector<std::FILE*> runs;
+    std::string             line;
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(m_nDataStart));
+    uint64_t offset = m_nDataStart;
+    for (uint64_t lineNo = 0; ok && std::getline(m_file, line); ++lineNo)
+    {
+      uint64_t next = static_cast<uint64_t>(m_file.tellg());
+      RowData  row  = ParseLine(line);
+      if (query.Matches(row))
+      {
+        ++m_nResultRows;
+        if (!sorting)
+        {
+          ok = WriteResult(m_pResultFile, lineNo, offset);
+        }
+        else
+        {
+          run.push_back({ std::move(row[query.sortCol]), lineNo, offset });
+          runBytes += sizeof(SortEntry) + run.back().key.str.capacity();
+          if (runBytes >= RUN_BYTES)
+          {
+            ok       = SpillRun(query, run, runs);
+            runBytes = 0;
+          }
+        }
+      }
+      offset = next;
+    }
+    if (ok && sorting && runs.empty())
+    {
+      // Everything fit in one run, no merge needed
+      SortRun(query, run);
+      for (size_t i = 0; ok && i < run.size(); ++i)
+      {
+        ok = WriteResult(m_pResultFile, run[i].line, run[i].offset);
+      }
+    }
+    else if (ok && sorting)
+    {
+      ok = (run.empty() || SpillRun(query, run, runs)) && MergeRuns(query, runs);
+    }
+    for (std::FILE* file : runs)
+    {
+      std::fclose(file);
+    }
+    return ok && std::fflush(m_pResultFile) == 0;
+  }
+  // Order of two matching lines, ties keep file order
+  static bool SortedBefore(const Query& query, const SortEntry& a, const SortEntry& b)
+  {
+    int result = ColumnDataCompare<C>::Compare(a.key, b.key);
+    return result != 0 ? (query.ascending ? result < 0 : result > 0) : a.line < b.line;
+  }
+  static void SortRun(const Query& query, std::vector<SortEntry>& run)
+  {
+    std::sort(run.begin(), run.end(), [&query](const SortEntry& a, const SortEntry& b)
+    {
+      return SortedBefore(query, a, b);
+    });
+  }
+  // Sort a full run into a new temporary file and empty it
+  bool SpillRun(const Query& query, std::vector<SortEntry>& run, std::vector<std::FILE*>& runs)
+  {
+    std::FILE* file = std::tmpfile();
+    if (!file)
+      return false;
+
+    runs.push_back(file);
+    SortRun(query, run);
+    for (const SortEntry& entry : run)
+    {
+      if (!WriteEntry(file, entry))
+        return false;
+    }
+    run.clear();
+    return std::fflush(file) == 0;
+  }
+  // Merge the runs into the result file, MERGE_WAYS at a time; a pass over
+  // more runs merges the first ones into a new run
+  bool MergeRuns(const Query& query, std::vector<std::FILE*>& runs)
+  {
+    size_t first = 0;
+    while (runs.size() - first > MERGE_WAYS)
+    {
+      std::FILE* merged = std::tmpfile();
+      if (!merged)
+        return false;
+
+      runs.push_back(merged);
+      if (!MergePass(query, runs.data() + first, MERGE_WAYS, merged, false))
+        return false;
+
+      first += MERGE_WAYS;
+    }
+    return MergePass(query, runs.data() + first, runs.size() - first, m_pResultFile, true);
+  }
+  // Merge count runs into out, as run entries or as result pairs
+  bool MergePass(const Query& query, std::FILE** runs, size_t count, std::FILE* out, bool result)
+  {
+    std::vector<SortEntry> heads(count);
+    auto later = [&](size_t a, size_t b)
+    {
+      return SortedBefore(query, heads[b], heads[a]);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> queue(later);
+    for (size_t i = 0; i < count; ++i)
+    {
+      std::rewind(runs[i]);
+      if (ReadEntry(query, runs[i], heads[i]))
+      {
+        queue.push(i);
+      }
+    }
+    while (!queue.empty())
+    {
+      size_t           i     = queue.top();
+      const SortEntry& entry = heads[i];
+      queue.pop();
+      if (result ? !WriteResult(out, entry.line, entry.offset) : !WriteEntry(out, entry))
+        return false;
+
+      if (ReadEntry(query, runs[i], heads[i]))
+      {
+        queue.push(i);
+      }
+    }
+    return std::fflush(out) == 0;
+  }
+  // Seek a temporary file, which may be past the 2 GB a long reaches
+  static bool SeekFile(std::FILE* file, uint64_t offset)
+  {
+#ifdef _MSC_VER
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+  }
+  static bool WriteResult(std::FILE* file, uint64_t line, uint64_t offset)
+  {
+    uint64_t pair[2] = { line, offset };
+    return std::fwrite(pair, sizeof(pair), 1, file) == 1;
+  }
+  // A run entry is its line and offset, then the key: the value of a
+  // number, the length and bytes of a string
+  static bool WriteEntry(std::FILE* file, const SortEntry& entry)
+  {
+    if (!WriteResult(file, entry.line, entry.offset))
+      return false;
+
+    if (!entry.key.IsString())
+      return std::fwrite(&entry.key.value, sizeof(entry.key.value), 1, file) == 1;
+
+    uint64_t length = entry.key.str.size();
+    return std::fwrite(&length, sizeof(length), 1, file) == 1
+      && std::fwrite(entry.key.str.data(), 1, entry.key.str.size(), file) == entry.key.str.size();
+  }
+  bool ReadEntry(const Query& query, std::FILE* file, SortEntry& entry) const
+  {
+    uint64_t pair[2];
+    if (std::fread(pair, sizeof(pair), 1, file) != 1)
+      return false;
+
+    entry.line     = pair[0];
+    entry.offset   = pair[1];
+    entry.key.type = m_arrColumnInfo[query.sortCol].type;
+    if (!entry.key.IsString())
+      return std::fread(&entry.key.value, sizeof(entry.key.value), 1, file) == 1;
+
+    uint64_t length = 0;
+    if (std::fread(&length, sizeof(length), 1, file) != 1)
+      return false;
+
+    entry.key.str.resize(static_cast<size_t>(length));
+    return std::fread(&entry.key.str[0], 1, entry.key.str.size(), file) == entry.key.str.size();
+  }
+  // Parse one line into a row, missing fields become empty text
+  RowData ParseLine(const std::string& line) const
+  {
+    std::vector<std::string> fields;
+    SplitCsvLine(line, fields);
+    RowData row;
+    for (size_t col = 0; col < N; ++col)
+    {
+      const ColumnInfo<C>& info = m_arrColumnInfo[col];
+      row[col] = ColumnData<C>::FromText(info.type,
+        col < fields.size() ? fields[col] : std::string(), info.format);
+      row[col].columnInfo = &info;
+    }
+    return row;
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_DATA_PROVIDER_H_
@@ -0,0 +1,115 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_FOLLOWER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_FOLLOWER_H_
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExFollower
+ * PURPOSE : Feed the rows appended to a CSV file into a TableEx
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Fields are parsed by the table's column types and formats.
+ *           New rows get IDs after the table's last ID and are inserted in
+ *           one transaction per Poll, which TableEx merges into its views
+ *           without rebuilding them. When the file is truncated or replaced
+ *           the table is cleared and filled again from the new content.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class TableExFollower
+{
+public:
+  using RowData = std::array<ColumnData<C>, N>;
+protected:
+  // Table receiving the rows
+  TableEx<C, N>                   *m_pTable;
+  // Source of the appended lines
+  FileFollower                     m_follower;
+  // Scratch buffers reused between polls
+  std::vector<std::string>         m_vLines;
+  std::vector<std::string>         m_vFields;
+public:
+  explicit TableExFollower(TableEx<C, N>* table)
+    : m_pTable(table)
+  {
+  }
+  // Start following a file. hasHeader skips its first line, fromEnd only
+  // takes the rows appended from now on.
+  bool Open(const std::string& path, bool hasHeader = true, bool fromEnd = false)
+  {
+    return m_pTable && m_follower.Open(path, fromEnd, hasHeader ? 1 : 0);
+  }
+  // Stop following
+  void Close()
+  {
+    m_follower.Close();
+  }
+  // Check if a file is being followed
+  bool IsOpen() const
+  {
+    return m_follower.IsOpen();
+  }
+  // Insert the rows appended since the last call and return their IDs
+  // (ascending). reset is set if the table was cleared because the file
+  // started over, more if data is already waiting for the next call.
+  std::vector<size_t> Poll(bool&  reset,
+                           bool&  more,
+                           size_t maxBytes = FileFollower::DEFAULT_READ_BYTES)
+  {
+    std::vector<size_t> ids;
+    m_vLines.clear();
+    more  = m_follower.ReadLines(m_vLines, maxBytes);
+    reset = m_follower.TakeReset();
+    if (reset)
+    {
+      // Rows arriving next are merged into the same sort order
+      size_t sortCol   = 0;
+      bool   ascending = true;
+      bool   sorted    = m_pTable->GetSortOrder(sortCol, ascending);
+      m_pTable->Clear();
+      if (sorted)
+      {
+        m_pTable->SortByColumn(sortCol, ascending);
+      }
+    }
+    if (m_vLines.empty())
+      return ids;
+
+    size_t nextId = 0;
+    if (m_pTable->GetLastId(nextId))
+    {
+      ++nextId;
+    }
+    ids.reserve(m_vLines.size());
+    m_pTable->BeginTransaction();
+    for (const std::string& line : m_vLines)
+    {
+      if (line.empty())
+        continue;
+
+      SplitCsvLine(line, m_vFields);
+      RowData row;
+      for (size_t col = 0; col < N; ++col)
+      {
+        const ColumnInfo<C>& info = m_pTable->GetColumnInfo(col);
+        row[col] = ColumnData<C>::FromText(info.type,
+          col < m_vFields.size() ? m_vFields[col] : std::string(), info.format);
+      }
+      m_pTable->UpsertRow(nextId, std::move(row));
+      ids.push_back(nextId++);
+    }
+    m_pTable->CommitTransaction();
+    return ids;
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_FOLLOWER_H_
@@ -0,0 +1,482 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_GROUP_BY_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_GROUP_BY_H_
+
+#include <atomic>
+#include <cinttypes>
+#include <thread>
+#include <unordered_map>
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExGroupBy
+ * PURPOSE : Group the rows of a TableEx<C, N> by key columns into a
+ *           TableEx<C, M> of keys and aggregates (count, sum, min, max, avg)
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Build groups every row with partitioned hash aggregation: the
+ *           rows are split between threads, each scatters its rows into
+ *           PARTITIONS lists by key hash, then each partition (disjoint
+ *           keys) is aggregated by one thread. After that a row listener on
+ *           the source keeps the groups current; Update writes the changed
+ *           groups into the result, so no row is grouped twice. MIN / MAX
+ *           keep their values with counts to survive removals, SUM / AVG
+ *           add and subtract. A group left empty makes Update rewrite the
+ *           result (which has no row removal) from the groups, still
+ *           without a scan of the source. The source must outlive this.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N, size_t M>
+class TableExGroupBy
+{
+public:
+  using SourceRow  = std::array<ColumnData<C>, N>;
+  using ResultRow  = std::array<ColumnData<C>, M>;
+  using ColumnType = typename ColumnInfo<C>::ColumnType;
+
+  enum class Aggregate
+  {
+    KEY,
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    AVG
+  };
+  // One column of the result
+  struct Output
+  {
+    Aggregate                      aggregate;
+    // Source column grouped by (KEY) or aggregated, unused by COUNT
+    size_t                         source;
+    // Result column info. Its type follows from the aggregate, an empty
+    // format takes a default.
+    ColumnInfo<C>                  info;
+  };
+
+  // Partitions of the parallel build, by the top bits of the key hash
+  static const size_t PARTITION_BITS  = 6;
+  static const size_t PARTITIONS      = size_t(1) << PARTITION_BITS;
+  // Fewest rows worth another thread
+  static const size_t MIN_THREAD_ROWS = 65536;
+protected:
+  // Running aggregate of one result column of a group
+  struct Cell
+  {
+    double                         sum = 0.0;
+    // Values with their counts (MIN / MAX)
+    std::map<ColumnData<C>, size_t, ColumnDataCompare<C>> values;
+  };
+  struct Group
+  {
+    uint64_t                       hash = 0;
+    // Result row ID
+    size_t                         id   = 0;
+    size_t                         rows = 0;
+    // Indicates the group is in m_vDirtyGroups
+    bool                           dirty = false;
+    // Values of the KEY outputs, in order
+    std::vector<ColumnData<C>>     key;
+    std::array<Cell, M>            cells;
+  };
+  // Key hash -> position of the group
+  using GroupIndex = std::unordered_multimap<uint64_t, size_t>;
+  // A source row scattered to a partition
+  struct Entry
+  {
+    uint64_t                       hash;
+    const SourceRow               *row;
+  };
+
+  TableEx<C, N>                   *m_pSource;
+  std::array<Output, M>            m_arrOutputs;
+  // Source columns of the KEY outputs, in order
+  std::vector<size_t>              m_vKeyColumns;
+  TableEx<C, M>                    m_result;
+  // Groups in result ID order, empty ones stay until the next reset
+  std::vector<Group>               m_vGroups;
+  GroupIndex                       m_mapGroups;
+  size_t                           m_nNextId     = 0;
+  // Positions of the groups changed since the last Update, each once, so
+  // it stays bounded by the group count however long Update is not called
+  std::vector<size_t>              m_vDirtyGroups;
+  // Set when a group emptied or the source was cleared
+  bool                             m_bReset      = false;
+  // Handle of the row listener on the source, 0 before Build
+  size_t                           m_nListener   = 0;
+public:
+  TableExGroupBy(TableEx<C, N>* source, const std::array<Output, M>& outputs)
+    : m_pSource   (source)
+    , m_arrOutputs(outputs)
+  {
+    for (const Output& output : m_arrOutputs)
+    {
+      if (output.aggregate == Aggregate::KEY)
+      {
+        m_vKeyColumns.push_back(output.source);
+      }
+    }
+  }
+  ~TableExGroupBy()
+  {
+    if (m_nListener)
+    {
+      m_pSource->RemoveRowListener(m_nListener);
+    }
+  }
+  TableExGroupBy(const TableExGroupBy&)            = delete;
+  TableExGroupBy& operator=(const TableExGroupBy&) = delete;
+
+  // Group every source row and rewrite the result, ordered by key. Call it
+  // once the source columns are set up; the groups follow the source from
+  // then on.
+  void Build()
+  {
+    SetupResultColumns();
+
+    std::vector<const SourceRow*> rows;
+    rows.reserve(m_pSource->GetRowCount());
+    m_pSource->ForEachRowWithId([&](size_t, const SourceRow& row)
+    {
+      rows.push_back(&row);
+    });
+    size_t threads = (std::min)(
+      (std::max)(rows.size() / MIN_THREAD_ROWS, size_t(1)),
+      static_cast<size_t>((std::max)(std::thread::hardware_concurrency(), 1u)));
+
+    // Scatter: each thread hashes its slice of rows into partitions
+    std::vector<std::array<std::vector<Entry>, PARTITIONS>> scattered(threads);
+    RunParallel(threads, [&](size_t thread)
+    {
+      size_t first = rows.size() *  thread      / threads;
+      size_t last  = rows.size() * (thread + 1) / threads;
+      for (size_t i = first; i < last; ++i)
+      {
+        uint64_t hash = HashKey(*rows[i]);
+        scattered[thread][hash >> (64 - PARTITION_BITS)].push_back({ hash, rows[i] });
+      }
+    });
+
+    // Aggregate: partitions hold disjoint keys, each is grouped alone
+    std::array<std::vector<Group>, PARTITIONS> partitions;
+    std::atomic<size_t> next(0);
+    RunParallel(threads, [&](size_t)
+    {
+      for (size_t partition = next++; partition < PARTITIONS; partition = next++)
+      {
+        std::vector<Group>& groups = partitions[partition];
+        GroupIndex          index;
+        for (const auto& slice : scattered)
+        {
+          for (const Entry& entry : slice[partition])
+          {
+            size_t pos = FindGroup(groups, index, entry.hash, *entry.row);
+            if (pos == groups.size())
+            {
+              pos = NewGroup(groups, index, entry.hash, *entry.row);
+            }
+            Accumulate(groups[pos], *entry.row, true);
+          }
+        }
+      }
+    });
+    scattered.clear();
+
+    m_vGroups.clear();
+    for (std::vector<Group>& groups : partitions)
+    {
+      std::move(groups.begin(), groups.end(), std::back_inserter(m_vGroups));
+      std::vector<Group>().swap(groups);
+    }
+    std::sort(m_vGroups.begin(), m_vGroups.end(), [](const Group& a, const Group& b)
+    {
+      return KeyLess(a.key, b.key);
+    });
+    m_nNextId = 0;
+    for (Group& group : m_vGroups)
+    {
+      group.id = m_nNextId++;
+    }
+    RebuildIndex();
+    WriteResult();
+
+    if (!m_nListener)
+    {
+      m_nListener = m_pSource->AddRowListener(
+        [this](size_t, const SourceRow* before, const SourceRow& after)
+      {
+        if (before)
+        {
+          RemoveRow(*before);
+        }
+        AddRow(after);
+      },
+        [this]()
+      {
+        m_vGroups.clear();
+        m_mapGroups.clear();
+        m_vDirtyGroups.clear();
+        m_bReset = true;
+      });
+    }
+  }
+  // Write the groups changed since the last call into the result and
+  // return their result IDs. If groups went away the result is rewritten
+  // instead: reset is set and the result should be refreshed whole.
+  std::vector<size_t> Update(bool& reset)
+  {
+    reset = m_bReset;
+    if (m_bReset)
+    {
+      m_vGroups.erase(std::remove_if(m_vGroups.begin(), m_vGroups.end(),
+        [](const Group& group) { return group.rows == 0; }), m_vGroups.end());
+      RebuildIndex();
+      WriteResult();
+      return std::vector<size_t>();
+    }
+
+    std::sort(m_vDirtyGroups.begin(), m_vDirtyGroups.end());
+    m_result.BeginTransaction();
+    for (size_t pos : m_vDirtyGroups)
+    {
+      m_vGroups[pos].dirty = false;
+      m_result.UpsertRow(m_vGroups[pos].id, MakeRow(m_vGroups[pos]));
+    }
+    m_vDirtyGroups.clear();
+    return m_result.CommitTransaction();
+  }
+  // Get the grouped table, keys and aggregates as of the last Update
+  TableEx<C, M>& GetResult()
+  {
+    return m_result;
+  }
+  // Number of groups, including ones emptied since the last Update
+  size_t GetGroupCount() const
+  {
+    return m_vGroups.size();
+  }
+protected:
+  // Run func(thread) on threads threads, the calling one included
+  template <typename F>
+  static void RunParallel(size_t threads, F func)
+  {
+    std::vector<std::thread> pool;
+    for (size_t thread = 1; thread < threads; ++thread)
+    {
+      pool.emplace_back(func, thread);
+    }
+    func(0);
+    for (std::thread& thread : pool)
+    {
+      thread.join();
+    }
+  }
+  // Result column types follow the aggregates and the source columns
+  void SetupResultColumns()
+  {
+    for (size_t col = 0; col < M; ++col)
+    {
+      const Output&        output = m_arrOutputs[col];
+      const ColumnInfo<C>& source = m_pSource->GetColumnInfo(output.source < N ? output.source : 0);
+      ColumnInfo<C>        info   = output.info;
+      switch (output.aggregate)
+      {
+      case Aggregate::COUNT:
+        info.type   = ColumnType::UINT64;
+        info.format = info.format.empty() ? "%" PRIu64 : info.format;
+        break;
+      case Aggregate::SUM:
+      case Aggregate::AVG:
+        info.type   = ColumnType::DOUBLE;
+        info.format = info.format.empty() ? "%.2f" : info.format;
+        break;
+      default:
+        info.type   = source.type;
+        info.format = info.format.empty() ? source.format : info.format;
+        break;
+      }
+      m_result.SetColumnInfo(col, info);
+    }
+  }
+  // Hash of the key columns of a row
+  uint64_t HashKey(const SourceRow& row) const
+  {
+    uint64_t hash = 0;
+    for (size_t col : m_vKeyColumns)
+    {
+      hash = MixHash(hash ^ row[col].Hash());
+    }
+    return hash;
+  }
+  // Position of the group of a row, groups.size() if none
+  size_t FindGroup(const std::vector<Group>& groups,
+                   const GroupIndex&         index,
+                   uint64_t                  hash,
+                   const SourceRow&          row) const
+  {
+    auto bounds = index.equal_range(hash);
+    for (auto it = bounds.first; it != bounds.second; ++it)
+    {
+      const Group& group = groups[it->second];
+      size_t       k     = 0;
+      while (k < m_vKeyColumns.size()
+        && group.key[k].type == row[m_vKeyColumns[k]].type
+        && ColumnDataCompare<C>::Compare(group.key[k], row[m_vKeyColumns[k]]) == 0)
+      {
+        ++k;
+      }
+      if (k == m_vKeyColumns.size())
+        return it->second;
+    }
+    return groups.size();
+  }
+  // Add an empty group for the key of a row, returns its position
+  size_t NewGroup(std::vector<Group>& groups, GroupIndex& index, uint64_t hash, const SourceRow& row) const
+  {
+    Group group;
+    group.hash = hash;
+    for (size_t col : m_vKeyColumns)
+    {
+      group.key.push_back(row[col]);
+    }
+    groups.push_back(std::move(group));
+    index.emplace(hash, groups.size() - 1);
+    return groups.size() - 1;
+  }
+  // Count a row into a group, or take it out
+  void Accumulate(Group& group, const SourceRow& row, bool add) const
+  {
+    group.rows = add ? group.rows + 1 : group.rows - 1;
+    for (size_t col = 0; col < M; ++col)
+    {
+      const Output& output = m_arrOutputs[col];
+      Cell&         cell   = group.cells[col];
+      double        number = 0.0;
+      switch (output.aggregate)
+      {
+      case Aggregate::SUM:
+      case Aggregate::AVG:
+        if (row[output.source].ToNumber(number))
+        {
+          cell.sum += add ? number : -number;
+        }
+        break;
+      case Aggregate::MIN:
+      case Aggregate::MAX:
+        if (add)
+        {
+          ++cell.values[row[output.source]];
+        }
+        else
+        {
+          auto it = cell.values.find(row[output.source]);
+          if (it != cell.values.end() && --it->second == 0)
+          {
+            cell.values.erase(it);
+          }
+        }
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  // Listener side: a row joined its group
+  void AddRow(const SourceRow& row)
+  {
+    uint64_t hash = HashKey(row);
+    size_t   pos  = FindGroup(m_vGroups, m_mapGroups, hash, row);
+    if (pos == m_vGroups.size())
+    {
+      pos = NewGroup(m_vGroups, m_mapGroups, hash, row);
+      m_vGroups[pos].id = m_nNextId++;
+    }
+    Accumulate(m_vGroups[pos], row, true);
+    MarkDirty(pos);
+  }
+  // Listener side: a row left its group
+  void RemoveRow(const SourceRow& row)
+  {
+    size_t pos = FindGroup(m_vGroups, m_mapGroups, HashKey(row), row);
+    if (pos == m_vGroups.size())
+      return;
+
+    Accumulate(m_vGroups[pos], row, false);
+    MarkDirty(pos);
+    m_bReset = m_bReset || m_vGroups[pos].rows == 0;
+  }
+  // Note a changed group for the next Update
+  void MarkDirty(size_t pos)
+  {
+    if (!m_vGroups[pos].dirty)
+    {
+      m_vGroups[pos].dirty = true;
+      m_vDirtyGroups.push_back(pos);
+    }
+  }
+  // Result row of a group
+  ResultRow MakeRow(const Group& group) const
+  {
+    ResultRow row;
+    size_t    key = 0;
+    for (size_t col = 0; col < M; ++col)
+    {
+      const Cell& cell = group.cells[col];
+      switch (m_arrOutputs[col].aggregate)
+      {
+      case Aggregate::KEY:   row[col] = group.key[key++];                                       break;
+      case Aggregate::COUNT: row[col] = ColumnData<C>(static_cast<uint64_t>(group.rows));       break;
+      case Aggregate::SUM:   row[col] = ColumnData<C>(cell.sum);                                break;
+      case Aggregate::AVG:   row[col] = ColumnData<C>(group.rows ? cell.sum / group.rows : 0.0); break;
+      case Aggregate::MIN:   row[col] = cell.values.empty() ? ColumnData<C>() : cell.values.begin ()->first; break;
+      case Aggregate::MAX:   row[col] = cell.values.empty() ? ColumnData<C>() : cell.values.rbegin()->first; break;
+      }
+    }
+    return row;
+  }
+  // Key order of the built result
+  static bool KeyLess(const std::vector<ColumnData<C>>& a, const std::vector<ColumnData<C>>& b)
+  {
+    for (size_t k = 0; k < a.size(); ++k)
+    {
+      int order = ColumnDataCompare<C>::Compare(a[k], b[k]);
+      if (order != 0)
+        return order < 0;
+    }
+    return false;
+  }
+  void RebuildIndex()
+  {
+    m_mapGroups.clear();
+    m_mapGroups.reserve(m_vGroups.size());
+    for (size_t pos = 0; pos < m_vGroups.size(); ++pos)
+    {
+      m_mapGroups.emplace(m_vGroups[pos].hash, pos);
+    }
+  }
+  // Rewrite the result from the groups
+  void WriteResult()
+  {
+    m_result.Clear();
+    m_result.BeginTransaction();
+    for (Group& group : m_vGroups)
+    {
+      group.dirty = false;
+      m_result.UpsertRow(group.id, MakeRow(group));
+    }
+    m_result.CommitTransaction();
+    m_vDirtyGroups.clear();
+    m_bReset = false;
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_GROUP_BY_H_
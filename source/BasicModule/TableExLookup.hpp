@@ -0,0 +1,192 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_LOOKUP_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_LOOKUP_H_
+
+#include <unordered_map>
+#include <vector>
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExLookup
+ * PURPOSE : Hash index of a TableEx<C, M> by a key column, resolving the
+ *           lookup columns of other tables (see TableEx::SetLookupColumn)
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Keys map to the row holding them and the version of its last
+ *           change; a row listener keeps them current, so a reference row
+ *           upserted later is seen by the next read of a dependent cell.
+ *           Rows are only removed by Clear, so a row is found once by ID
+ *           and then read through its (stable) map node. Keys should be
+ *           unique; otherwise the row written last holds the key. A key a
+ *           row moved away from is kept without a row, to remember when it
+ *           changed. The reference table must outlive this, and this every
+ *           table using it.
+ *           Only the listeners, on the thread writing the reference table,
+ *           change the index, so Resolve may run on several threads while
+ *           no row is written (TableExAdapter::WriteRows).
+ *
+ *****************************************************************************/
+
+template <typename C, size_t M>
+class TableExLookup : public ITableExLookup<C>
+{
+public:
+  using RowData = std::array<ColumnData<C>, M>;
+
+  // ID of a key no row holds any more
+  static const size_t NPOS = static_cast<size_t>(-1);
+protected:
+  struct KeyHash
+  {
+    size_t operator()(const ColumnData<C>& key) const
+    {
+      return static_cast<size_t>(key.Hash());
+    }
+  };
+  struct KeyEqual
+  {
+    bool operator()(const ColumnData<C>& a, const ColumnData<C>& b) const
+    {
+      return a.type == b.type && ColumnDataCompare<C>::Compare(a, b) == 0;
+    }
+  };
+  struct Entry
+  {
+    size_t                         id      = NPOS;
+    // Row of id, nullptr until an inserted row is found (see m_vPending)
+    const RowData                 *row     = nullptr;
+    uint64_t                       version = 0;
+  };
+  using EntryMap = std::unordered_map<ColumnData<C>, Entry, KeyHash, KeyEqual>;
+
+  const TableEx<C, M>             *m_pTable;
+  size_t                           m_nKeyCol;
+  EntryMap                         m_mapEntries;
+  uint64_t                         m_nVersion      = 0;
+  // Version of the last Clear, every key changed then
+  uint64_t                         m_nClearVersion = 0;
+  size_t                           m_nListener     = 0;
+  // Entries of inserted rows, whose map node is only there after their
+  // listener call; found at the next change or transaction commit
+  std::vector<Entry*>              m_vPending;
+public:
+  // Index the rows of table by keyCol, and follow their changes
+  TableExLookup(TableEx<C, M>* table, size_t keyCol)
+    : m_pTable (table)
+    , m_nKeyCol(keyCol < M ? keyCol : 0)
+  {
+    m_mapEntries.reserve(table->GetRowCount());
+    table->ForEachRowWithId([this](size_t id, const RowData& row)
+    {
+      Entry& entry = m_mapEntries[row[m_nKeyCol]];
+      entry.id  = id;
+      entry.row = &row;
+    });
+    m_nListener = table->AddRowListener(
+      [this](size_t id, const RowData* before, const RowData& row)
+    {
+      OnUpsert(id, before, row);
+    },
+      [this]()
+    {
+      m_vPending.clear();
+      m_mapEntries.clear();
+      m_nClearVersion = ++m_nVersion;
+    },
+      [this](bool begin)
+    {
+      if (!begin)
+      {
+        FindPendingRows();
+      }
+    });
+  }
+  ~TableExLookup()
+  {
+    const_cast<TableEx<C, M>*>(m_pTable)->RemoveRowListener(m_nListener);
+  }
+  TableExLookup(const TableExLookup&)            = delete;
+  TableExLookup& operator=(const TableExLookup&) = delete;
+
+  // Get a cell of the row with a key, nullptr if there is none
+  const ColumnData<C>* Resolve(const ColumnData<C>& key, size_t col) const override
+  {
+    auto it = m_mapEntries.find(key);
+    if (it == m_mapEntries.end() || it->second.id == NPOS || col >= M)
+      return nullptr;
+
+    // A row inserted since the last change is looked up, not remembered
+    const RowData* row = it->second.row ? it->second.row : m_pTable->GetRow(it->second.id);
+    return row ? &(*row)[col] : nullptr;
+  }
+  // Version of the rows, increases with every upsert and Clear
+  uint64_t GetVersion() const override
+  {
+    return m_nVersion;
+  }
+  // Check if the row with a key changed after a version
+  bool ChangedSince(const ColumnData<C>& key, uint64_t version) const override
+  {
+    auto it = m_mapEntries.find(key);
+    if (it == m_mapEntries.end())
+      return m_nClearVersion > version;
+
+    return it->second.version > version;
+  }
+  // Number of keys held, including those no row holds any more
+  size_t GetKeyCount() const
+  {
+    return m_mapEntries.size();
+  }
+protected:
+  void OnUpsert(size_t id, const RowData* before, const RowData& row)
+  {
+    FindPendingRows();
+    ++m_nVersion;
+    if (before && !KeyEqual()((*before)[m_nKeyCol], row[m_nKeyCol]))
+    {
+      auto it = m_mapEntries.find((*before)[m_nKeyCol]);
+      if (it != m_mapEntries.end() && it->second.id == id)
+      {
+        it->second.id      = NPOS;
+        it->second.row     = nullptr;
+        it->second.version = m_nVersion;
+      }
+    }
+
+    // An updated row is written in place, its node is the one it is in
+    Entry& entry  = m_mapEntries[row[m_nKeyCol]];
+    if (entry.id != id || !entry.row)
+    {
+      entry.id  = id;
+      entry.row = before;
+      if (!before)
+      {
+        m_vPending.push_back(&entry);
+      }
+    }
+    entry.version = m_nVersion;
+  }
+  // Point the entries of rows inserted since at their map nodes
+  void FindPendingRows()
+  {
+    for (Entry* entry : m_vPending)
+    {
+      if (entry->id != NPOS && !entry->row)
+      {
+        entry->row = m_pTable->GetRow(entry->id);
+      }
+    }
+    m_vPending.clear();
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_LOOKUP_H_
@@ -0,0 +1,220 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_RECORDER_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_RECORDER_H_
+
+#include <cstring>
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExRecorder
+ * PURPOSE : Record the row writes of a TableEx<C, N> into a trace
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Start writes the column setup and the rows already present,
+ *           then a row listener records every upsert, clear and
+ *           transaction as it happens. List operations (sorts, filters,
+ *           refreshes) are recorded by a RecordingTableExAdapter sharing
+ *           the writer. Cells are encoded as a type byte and the value:
+ *           zigzag varints for signed integers, varints for unsigned,
+ *           raw IEEE bytes for floating point, length-prefixed UTF-8.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class TableExRecorder
+{
+public:
+  using RowData    = std::array<ColumnData<C>, N>;
+  using ColumnType = typename ColumnInfo<C>::ColumnType;
+protected:
+  TableEx<C, N>                   *m_pTable;
+  TableExTraceWriter               m_writer;
+  // Handle of the row listener, 0 when not recording
+  size_t                           m_nListener = 0;
+  // Record reused for every write
+  TableExTraceRecord               m_record;
+public:
+  explicit TableExRecorder(TableEx<C, N>* table)
+    : m_pTable(table)
+  {
+  }
+  ~TableExRecorder()
+  {
+    Stop();
+  }
+  TableExRecorder(const TableExRecorder&)            = delete;
+  TableExRecorder& operator=(const TableExRecorder&) = delete;
+
+  // Start recording into a new trace file
+  bool Start(const std::string& filename)
+  {
+    Stop();
+    TableExTraceHeader header;
+    for (size_t col = 0; col < N; ++col)
+    {
+      const ColumnInfo<C>& info = m_pTable->GetColumnInfo(col);
+      TableExTraceColumn   column;
+      column.type        = static_cast<uint8_t>(info.type);
+      column.indexed     = m_pTable->HasIndex(col);
+      column.textIndexed = m_pTable->HasTextIndex(col);
+      column.format      = info.format;
+      column.name        = info.name;
+      header.columns.push_back(column);
+    }
+    header.zoneMaps = m_pTable->HasZoneMaps();
+    if (!m_writer.Open(filename, header))
+      return false;
+
+    TableExTraceRecord initial;
+    initial.op    = TableExTraceOp::UPSERT;
+    initial.flags = TableExTraceRecord::INITIAL;
+    m_pTable->ForEachRowWithId([&](size_t id, const RowData& row)
+    {
+      initial.target = id;
+      initial.cells.clear();
+      EncodeRow(row, initial.cells);
+      m_writer.Write(initial, true);
+    });
+
+    m_nListener = m_pTable->AddRowListener(
+      [this](size_t id, const RowData*, const RowData& row)
+    {
+      m_record.op     = TableExTraceOp::UPSERT;
+      m_record.target = id;
+      m_record.cells.clear();
+      EncodeRow(row, m_record.cells);
+      m_writer.Write(m_record);
+    },
+      [this]()
+    {
+      WriteOp(TableExTraceOp::CLEAR);
+    },
+      [this](bool begin)
+    {
+      WriteOp(begin ? TableExTraceOp::BEGIN : TableExTraceOp::COMMIT);
+    });
+    return true;
+  }
+  // Stop recording and close the trace
+  void Stop()
+  {
+    if (m_nListener)
+    {
+      m_pTable->RemoveRowListener(m_nListener);
+      m_nListener = 0;
+    }
+    m_writer.Close();
+  }
+  // Check if recording
+  bool IsRecording() const
+  {
+    return m_writer.IsOpen();
+  }
+  // Get the writer, for recording list operations next to the rows
+  TableExTraceWriter* GetWriter()
+  {
+    return &m_writer;
+  }
+
+  // Append the encoded cells of a row
+  static void EncodeRow(const RowData& row, std::string& out)
+  {
+    for (const ColumnData<C>& cell : row)
+    {
+      out += static_cast<char>(cell.type);
+      switch (cell.type)
+      {
+      case ColumnType::INT32:  AppendTraceVarint(out, ZigZag(cell.value.i32)); break;
+      case ColumnType::INT64:  AppendTraceVarint(out, ZigZag(cell.value.i64)); break;
+      case ColumnType::UINT32: AppendTraceVarint(out, cell.value.u32);         break;
+      case ColumnType::UINT64: AppendTraceVarint(out, cell.value.u64);         break;
+      case ColumnType::FLOAT:  out.append(reinterpret_cast<const char*>(&cell.value.f), sizeof(float )); break;
+      case ColumnType::DOUBLE: out.append(reinterpret_cast<const char*>(&cell.value.d), sizeof(double)); break;
+      default:
+        AppendTraceVarint(out, cell.str.size());
+        out += cell.str;
+        break;
+      }
+    }
+  }
+  // Decode the cells of a row, false if they are malformed
+  static bool DecodeRow(const std::string& cells, RowData& row)
+  {
+    const char* p   = cells.data();
+    const char* end = p + cells.size();
+    for (ColumnData<C>& cell : row)
+    {
+      uint64_t value = 0;
+      if (p == end)
+        return false;
+
+      cell.type = static_cast<ColumnType>(*p++);
+      cell.str.clear();
+      switch (cell.type)
+      {
+      case ColumnType::INT32:
+      case ColumnType::INT64:
+        if (!ReadTraceVarint(p, end, value))
+          return false;
+        // Zigzag: the low bit carries the sign
+        cell.value.i64 = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        if (cell.type == ColumnType::INT32)
+        {
+          cell.value.i32 = static_cast<int32_t>(cell.value.i64);
+        }
+        break;
+      case ColumnType::UINT32:
+      case ColumnType::UINT64:
+        if (!ReadTraceVarint(p, end, value))
+          return false;
+        if (cell.type == ColumnType::UINT32)
+        {
+          cell.value.u32 = static_cast<uint32_t>(value);
+        }
+        else
+        {
+          cell.value.u64 = value;
+        }
+        break;
+      case ColumnType::FLOAT:
+      case ColumnType::DOUBLE:
+      {
+        size_t size = (cell.type == ColumnType::FLOAT) ? sizeof(float) : sizeof(double);
+        if (static_cast<size_t>(end - p) < size)
+          return false;
+        memcpy(&cell.value, p, size);
+        p += size;
+        break;
+      }
+      default:
+        if (!ReadTraceVarint(p, end, value) || value > static_cast<uint64_t>(end - p))
+          return false;
+        cell.str.assign(p, static_cast<size_t>(value));
+        p += value;
+        break;
+      }
+    }
+    return p == end;
+  }
+protected:
+  static uint64_t ZigZag(int64_t value)
+  {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  }
+  void WriteOp(TableExTraceOp op)
+  {
+    TableExTraceRecord record;
+    record.op = op;
+    m_writer.Write(record);
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_RECORDER_H_
@@ -0,0 +1,228 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include <iterator>
+#include "TableExTrace.h"
+
+namespace
+{
+  // Identifies a trace and its format version
+  const char TRACE_MAGIC[] = "TXTRACE1";
+  const size_t TRACE_MAGIC_SIZE = sizeof(TRACE_MAGIC) - 1;
+
+  void AppendTraceText(std::string& out, const std::string& text)
+  {
+    AppendTraceVarint(out, text.size());
+    out += text;
+  }
+}
+
+void AppendTraceVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+bool ReadTraceVarint(const char*& p, const char* end, uint64_t& value)
+{
+  value = 0;
+  for (unsigned shift = 0; p != end && shift < 64; shift += 7)
+  {
+    uint8_t byte = static_cast<uint8_t>(*p++);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+TableExTraceWriter::TableExTraceWriter()
+  : m_nLastTime(0)
+  , m_nRecords (0)
+{
+}
+
+TableExTraceWriter::~TableExTraceWriter()
+{
+  Close();
+}
+
+bool TableExTraceWriter::Open(const std::string& filename, const TableExTraceHeader& header)
+{
+  Close();
+  m_file.open(filename, std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open())
+    return false;
+
+  m_buffer.assign(TRACE_MAGIC, TRACE_MAGIC_SIZE);
+  AppendTraceVarint(m_buffer, header.columns.size());
+  for (const TableExTraceColumn& column : header.columns)
+  {
+    m_buffer += static_cast<char>(column.type);
+    m_buffer += static_cast<char>((column.indexed ? 1 : 0) | (column.textIndexed ? 2 : 0));
+    AppendTraceText(m_buffer, column.format);
+    AppendTraceText(m_buffer, column.name);
+  }
+  m_buffer += static_cast<char>(header.zoneMaps ? 1 : 0);
+
+  m_start     = std::chrono::steady_clock::now();
+  m_nLastTime = 0;
+  m_nRecords  = 0;
+  return true;
+}
+
+void TableExTraceWriter::Close()
+{
+  if (!m_file.is_open())
+    return;
+
+  m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_buffer.clear();
+  m_file.close();
+}
+
+void TableExTraceWriter::Write(const TableExTraceRecord& record, bool timed)
+{
+  if (!m_file.is_open())
+    return;
+
+  uint64_t time = record.time;
+  if (!timed)
+  {
+    time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - m_start).count());
+  }
+  // Times only move forward, so they are stored as deltas
+  time = (std::max)(time, m_nLastTime);
+
+  m_buffer += static_cast<char>(record.op);
+  AppendTraceVarint(m_buffer, time - m_nLastTime);
+  AppendTraceVarint(m_buffer, record.target);
+  AppendTraceVarint(m_buffer, record.flags);
+  AppendTraceVarint(m_buffer, record.first);
+  AppendTraceVarint(m_buffer, record.count);
+  AppendTraceVarint(m_buffer, record.texts.size());
+  for (const std::string& text : record.texts)
+  {
+    AppendTraceText(m_buffer, text);
+  }
+  AppendTraceText(m_buffer, record.cells);
+  m_nLastTime = time;
+  ++m_nRecords;
+
+  if (m_buffer.size() >= FLUSH_BYTES)
+  {
+    m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.clear();
+  }
+}
+
+TableExTraceReader::TableExTraceReader()
+  : m_pCursor(nullptr)
+  , m_pEnd   (nullptr)
+  , m_nTime  (0)
+{
+}
+
+bool TableExTraceReader::Open(const std::string& filename)
+{
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  m_pCursor = m_data.data();
+  m_pEnd    = m_data.data() + m_data.size();
+  m_nTime   = 0;
+  m_header  = TableExTraceHeader();
+  if (m_data.compare(0, TRACE_MAGIC_SIZE, TRACE_MAGIC) != 0)
+    return false;
+
+  m_pCursor += TRACE_MAGIC_SIZE;
+  uint64_t columns = 0;
+  if (!ReadTraceVarint(m_pCursor, m_pEnd, columns))
+    return false;
+
+  for (uint64_t col = 0; col < columns; ++col)
+  {
+    TableExTraceColumn column;
+    if (m_pEnd - m_pCursor < 2)
+      return false;
+
+    column.type        = static_cast<uint8_t>(*m_pCursor++);
+    uint8_t flags      = static_cast<uint8_t>(*m_pCursor++);
+    column.indexed     = (flags & 1) != 0;
+    column.textIndexed = (flags & 2) != 0;
+    if (!ReadText(column.format) || !ReadText(column.name))
+      return false;
+
+    m_header.columns.push_back(column);
+  }
+  if (m_pCursor == m_pEnd)
+    return false;
+
+  m_header.zoneMaps = *m_pCursor++ != 0;
+  return true;
+}
+
+bool TableExTraceReader::Next(TableExTraceRecord& record)
+{
+  if (m_pCursor == m_pEnd)
+    return false;
+
+  uint64_t delta = 0;
+  uint64_t texts = 0;
+  record.op = static_cast<TableExTraceOp>(*m_pCursor++);
+  if (!ReadTraceVarint(m_pCursor, m_pEnd, delta)
+    || !ReadTraceVarint(m_pCursor, m_pEnd, record.target)
+    || !ReadTraceVarint(m_pCursor, m_pEnd, record.flags)
+    || !ReadTraceVarint(m_pCursor, m_pEnd, record.first)
+    || !ReadTraceVarint(m_pCursor, m_pEnd, record.count)
+    || !ReadTraceVarint(m_pCursor, m_pEnd, texts)
+    || texts > static_cast<uint64_t>(m_pEnd - m_pCursor))
+  {
+    m_pCursor = m_pEnd;
+    return false;
+  }
+  record.texts.resize(static_cast<size_t>(texts));
+  for (std::string& text : record.texts)
+  {
+    if (!ReadText(text))
+    {
+      m_pCursor = m_pEnd;
+      return false;
+    }
+  }
+  if (!ReadText(record.cells))
+  {
+    m_pCursor = m_pEnd;
+    return false;
+  }
+  m_nTime    += delta;
+  record.time = m_nTime;
+  return true;
+}
+
+bool TableExTraceReader::ReadText(std::string& text)
+{
+  uint64_t size = 0;
+  if (!ReadTraceVarint(m_pCursor, m_pEnd, size)
+    || size > static_cast<uint64_t>(m_pEnd - m_pCursor))
+    return false;
+
+  text.assign(m_pCursor, static_cast<size_t>(size));
+  m_pCursor += size;
+  return true;
+}
@@ -0,0 +1,174 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_TRACE_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_TRACE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Operations recorded in a trace
+enum class TableExTraceOp : uint8_t
+{
+  UPSERT          = 1,  // target: row ID, cells: the row
+  CLEAR           = 2,
+  BEGIN           = 3,  // Outermost transaction begins
+  COMMIT          = 4,  // Outermost transaction commits
+  SORT            = 5,  // target: column, flags: ascending, first: lazy window
+  RANGE_FILTER    = 6,  // target: column, texts: lower and upper bound,
+                        // flags: UPPER_OPEN
+  VALUE_FILTER    = 7,  // target: column, texts: values kept, or left
+                        // out with flags EXCLUDE
+  FUNCTION_FILTER = 8,  // target: column; the function can not be recorded
+  CLEAR_FILTER    = 9,  // target: column, -1 for all
+  QUICK_SEARCH    = 10, // texts: the search text
+  REFRESH         = 11  // flags: TableExTraceRefresh, first / count: visible
+                        // items, target: rows refreshed or appended
+};
+
+// List refreshes recorded by REFRESH
+enum class TableExTraceRefresh : uint8_t
+{
+  FULL,
+  PARTIAL,
+  ROWS,
+  APPEND
+};
+
+// Column setup of the traced table
+struct TableExTraceColumn
+{
+  uint8_t                  type        = 0;  // ColumnInfo<C>::ColumnType
+  bool                     indexed     = false;
+  bool                     textIndexed = false;
+  std::string              format;
+  std::string              name;
+};
+
+struct TableExTraceHeader
+{
+  std::vector<TableExTraceColumn> columns;
+  bool                     zoneMaps    = false;
+};
+
+/*****************************************************************************
+ *
+ * STRUCT  : TableExTraceRecord
+ * PURPOSE : One operation of a trace
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: The meaning of the fields depends on op (see TableExTraceOp).
+ *           Rows present when recording started come first, as UPSERT
+ *           records at time 0 flagged INITIAL.
+ *
+ *****************************************************************************/
+
+struct TableExTraceRecord
+{
+  // UPSERT flag of the rows the table held when recording started
+  static const uint64_t    INITIAL    = 1;
+  // RANGE_FILTER flag: the upper bound itself is left out
+  static const uint64_t    UPPER_OPEN = 1;
+  // VALUE_FILTER flag: the texts are the values left out
+  static const uint64_t    EXCLUDE    = 1;
+
+  TableExTraceOp           op     = TableExTraceOp::CLEAR;
+  // Microseconds since recording started
+  uint64_t                 time   = 0;
+  uint64_t                 target = 0;
+  uint64_t                 flags  = 0;
+  uint64_t                 first  = 0;
+  uint64_t                 count  = 0;
+  std::vector<std::string> texts;
+  // Encoded cells of an UPSERT (see TableExRecorder)
+  std::string              cells;
+};
+
+// Append an unsigned LEB128 varint
+void AppendTraceVarint(std::string& out, uint64_t value);
+// Read a varint at p, advancing it; false if it runs past end
+bool ReadTraceVarint  (const char*& p, const char* end, uint64_t& value);
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExTraceWriter
+ * PURPOSE : Write a binary trace of table and list operations
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: A header describes the columns, then each record is an op byte
+ *           and varints: time since the previous record, target, flags,
+ *           first, count, texts and cells (length prefixed). Records are
+ *           buffered and written FLUSH_BYTES at a time; a trace cut short
+ *           by a crash reads up to its last complete record.
+ *
+ *****************************************************************************/
+
+class TableExTraceWriter
+{
+public:
+  // Buffered bytes written at once
+  static const size_t FLUSH_BYTES = 64 * 1024;
+
+  TableExTraceWriter();
+  ~TableExTraceWriter();
+  TableExTraceWriter(const TableExTraceWriter&)            = delete;
+  TableExTraceWriter& operator=(const TableExTraceWriter&) = delete;
+
+  // Create a trace, the clock of its records starts now
+  bool     Open          (const std::string&        filename,
+                          const TableExTraceHeader& header);
+  // Write what is buffered and close the file
+  void     Close         ();
+  // Check if a trace is being written
+  bool     IsOpen        () const { return m_file.is_open(); }
+  // Append a record, stamped with the current time unless timed
+  void     Write         (const TableExTraceRecord& record, bool timed = false);
+  // Number of records written
+  uint64_t GetRecordCount() const { return m_nRecords;         }
+protected:
+  std::ofstream                          m_file;
+  std::string                            m_buffer;
+  std::chrono::steady_clock::time_point  m_start;
+  uint64_t                               m_nLastTime;
+  uint64_t                               m_nRecords;
+};
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExTraceReader
+ * PURPOSE : Read the records of a trace written by TableExTraceWriter
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: The file is read whole on Open, so replaying it costs no I/O
+ *
+ *****************************************************************************/
+
+class TableExTraceReader
+{
+public:
+  TableExTraceReader();
+
+  // Read a trace and its header
+  bool     Open          (const std::string& filename);
+  const TableExTraceHeader& GetHeader() const { return m_header; }
+  // Read the next record, false at the end (or a truncated record)
+  bool     Next          (TableExTraceRecord& record);
+protected:
+  bool     ReadText      (std::string& text);
+
+  TableExTraceHeader     m_header;
+  std::string            m_data;
+  const char            *m_pCursor;
+  const char            *m_pEnd;
+  uint64_t               m_nTime;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_TRACE_H_
@@ -0,0 +1,434 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_VERSIONS_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TABLE_EX_VERSIONS_H_
+
+#include <atomic>
+#include <algorithm>
+
+/*****************************************************************************
+ *
+ * CLASS   : TableExVersions
+ * PURPOSE : Consistent snapshots of a TableEx for readers on other threads
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: The writer thread keeps using its TableEx as before and, after
+ *           each batch, publishes the IDs CommitTransaction returned. Rows
+ *           are copied into immutable chunks of CHUNK_IDS consecutive IDs;
+ *           a publish only copies the chunks holding those IDs and shares
+ *           the others with the previous version, then swaps the version
+ *           pointer. Readers pin an epoch and read that version without any
+ *           lock; replaced chunks are freed once no pinned reader can still
+ *           see them (EpochManager). Column info is captured by PublishAll,
+ *           call it again after changing columns or clearing the table.
+ *           Follow does the publishing itself: the table's listeners note
+ *           the written IDs, each outermost commit publishes them and a
+ *           Clear republishes the table.
+ *
+ *****************************************************************************/
+
+template <typename C, size_t N>
+class TableExVersions
+{
+public:
+  using RowData = std::array<ColumnData<C>, N>;
+  using Row     = std::pair<size_t, RowData>;
+
+  // IDs per chunk, the unit copied when one of its rows changes
+  static const size_t CHUNK_IDS = 1024;
+protected:
+  // Column info the rows of a version point to
+  struct Schema
+  {
+    std::array<ColumnInfo<C>, N>   columns;
+  };
+  // Rows with IDs in [key * CHUNK_IDS, (key + 1) * CHUNK_IDS), by ID
+  struct Chunk
+  {
+    size_t                         key;
+    std::vector<Row>               rows;
+  };
+  struct Version
+  {
+    uint64_t                       number;
+    size_t                         rowCount;
+    const Schema                  *schema;
+    // Chunks by key, shared with other versions
+    std::vector<const Chunk*>      chunks;
+  };
+public:
+  /*****************************************************************************
+   *
+   * CLASS   : Snapshot
+   * PURPOSE : One published version, pinned while the snapshot lives
+   * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+   * COMMENTS: Use it from one thread and let it go when done reading, as
+   *           it holds back the freeing of versions published since.
+   *
+   *****************************************************************************/
+  class Snapshot
+  {
+  public:
+    Snapshot(Snapshot&&) = default;
+
+    // Check if anything was published
+    bool                 IsValid        () const { return m_pVersion != nullptr;                  }
+    // Publish number of the version, increasing by one per publish
+    uint64_t             GetVersion     () const { return m_pVersion ? m_pVersion->number   : 0;  }
+    // Number of rows
+    size_t               GetRowCount    () const { return m_pVersion ? m_pVersion->rowCount : 0;  }
+    const ColumnInfo<C>& GetColumnInfo  (size_t col) const
+    {
+      return m_pVersion->schema->columns[col];
+    }
+    // Get a row by ID, nullptr if not present
+    const RowData* GetRow(size_t id) const
+    {
+      if (!m_pVersion)
+        return nullptr;
+
+      const std::vector<const Chunk*>& chunks = m_pVersion->chunks;
+      auto chunk = std::lower_bound(chunks.begin(), chunks.end(), id / CHUNK_IDS,
+        [](const Chunk* a, size_t key) { return a->key < key; });
+      if (chunk == chunks.end() || (*chunk)->key != id / CHUNK_IDS)
+        return nullptr;
+
+      const std::vector<Row>& rows = (*chunk)->rows;
+      auto row = std::lower_bound(rows.begin(), rows.end(), id,
+        [](const Row& a, size_t value) { return a.first < value; });
+      return row != rows.end() && row->first == id ? &row->second : nullptr;
+    }
+    // Visit every row in ID order
+    template <typename F>
+    void ForEachWithId(F func) const
+    {
+      if (!m_pVersion)
+        return;
+
+      for (const Chunk* chunk : m_pVersion->chunks)
+      {
+        for (const Row& row : chunk->rows)
+        {
+          func(row.first, row.second);
+        }
+      }
+    }
+  protected:
+    friend class TableExVersions;
+
+    Snapshot(EpochManager& epochs, const std::atomic<const Version*>& current)
+      : m_guard   (epochs)
+      , m_pVersion(current.load())
+    {
+    }
+
+    EpochManager::Guard            m_guard;
+    const Version                 *m_pVersion;
+  };
+protected:
+  // Readers pin from any thread, hence mutable
+  mutable EpochManager             m_epochs;
+  std::atomic<const Version*>      m_pCurrent;
+  // Table published on its commits, see Follow, and its listener handle
+  TableEx<C, N>                   *m_pFollowed    = nullptr;
+  size_t                           m_nListener    = 0;
+  // IDs written since the last publish, or the whole table after a Clear
+  std::vector<size_t>              m_vPendingIds;
+  bool                             m_bPendingAll  = false;
+public:
+  TableExVersions()
+    : m_pCurrent(nullptr)
+  {
+  }
+  // No reader may hold a snapshot any more
+  ~TableExVersions()
+  {
+    Unfollow();
+    const Version* version = m_pCurrent.load();
+    if (version)
+    {
+      for (const Chunk* chunk : version->chunks)
+      {
+        delete chunk;
+      }
+      delete version->schema;
+      delete version;
+    }
+  }
+  TableExVersions(const TableExVersions&)            = delete;
+  TableExVersions& operator=(const TableExVersions&) = delete;
+
+  // Pin the latest version for reading, from any thread
+  Snapshot Pin() const
+  {
+    return Snapshot(m_epochs, m_pCurrent);
+  }
+
+  // Publish the table now and then at the end of each of its outermost
+  // transactions, until Unfollow (writer thread). Rows written outside a
+  // transaction wait for the next commit or PublishPending.
+  void Follow(TableEx<C, N>& table)
+  {
+    Unfollow();
+    m_pFollowed = &table;
+    m_nListener = table.AddRowListener(
+      [this](size_t id, const RowData*, const RowData&)
+    {
+      if (!m_bPendingAll)
+      {
+        m_vPendingIds.push_back(id);
+      }
+    },
+      [this]()
+    {
+      m_vPendingIds.clear();
+      m_bPendingAll = true;
+    },
+      [this](bool begin)
+    {
+      if (!begin)
+      {
+        PublishPending();
+      }
+    });
+    PublishAll(table);
+  }
+  // Stop publishing the followed table
+  void Unfollow()
+  {
+    if (m_pFollowed)
+    {
+      m_pFollowed->RemoveRowListener(m_nListener);
+    }
+    m_pFollowed = nullptr;
+    m_nListener = 0;
+    m_vPendingIds.clear();
+    m_bPendingAll = false;
+  }
+  // Publish the rows of the followed table written since the last publish
+  // (writer thread); a reader about to pin calls it to see every write
+  void PublishPending()
+  {
+    if (!m_pFollowed)
+      return;
+
+    if (m_bPendingAll)
+    {
+      m_vPendingIds.clear();
+      m_bPendingAll = false;
+      PublishAll(*m_pFollowed);
+      return;
+    }
+    std::sort(m_vPendingIds.begin(), m_vPendingIds.end());
+    m_vPendingIds.erase(
+      std::unique(m_vPendingIds.begin(), m_vPendingIds.end()), m_vPendingIds.end());
+    Publish(*m_pFollowed, m_vPendingIds);
+    m_vPendingIds.clear();
+  }
+
+  // Publish every row and the column info of the table (writer thread).
+  // Rows are taken in ID order, whatever the table's sort and filters.
+  void PublishAll(const TableEx<C, N>& table)
+  {
+    const Version* previous = m_pCurrent.load();
+    Schema*        schema   = new Schema();
+    for (size_t col = 0; col < N; ++col)
+    {
+      schema->columns[col] = table.GetColumnInfo(col);
+    }
+
+    Version* version  = new Version();
+    version->number   = previous ? previous->number + 1 : 1;
+    version->rowCount = 0;
+    version->schema   = schema;
+    Chunk* chunk      = nullptr;
+    table.ForEachRowWithId([&](size_t id, const RowData& row)
+    {
+      if (!chunk || chunk->key != id / CHUNK_IDS)
+      {
+        chunk      = new Chunk();
+        chunk->key = id / CHUNK_IDS;
+        version->chunks.push_back(chunk);
+      }
+      chunk->rows.emplace_back(id, row);
+      LinkRow(chunk->rows.back().second, *schema);
+      ++version->rowCount;
+    });
+
+    m_pCurrent.store(version);
+    if (previous)
+    {
+      for (const Chunk* old : previous->chunks)
+      {
+        RetireObject(old);
+      }
+      RetireObject(previous->schema);
+      RetireObject(previous);
+    }
+    m_epochs.Reclaim();
+  }
+
+  // Publish the rows with the given IDs (writer thread). Only the chunks
+  // holding them are copied; IDs no longer in the table are dropped.
+  void Publish(const TableEx<C, N>& table, const std::vector<size_t>& ids)
+  {
+    const Version* previous = m_pCurrent.load();
+    if (!previous)
+    {
+      PublishAll(table);
+      return;
+    }
+    if (ids.empty())
+      return;
+
+    std::vector<size_t> dirtyIds(ids);
+    if (!std::is_sorted(dirtyIds.begin(), dirtyIds.end()))
+    {
+      std::sort(dirtyIds.begin(), dirtyIds.end());
+    }
+
+    Version* version  = new Version();
+    version->number   = previous->number + 1;
+    version->rowCount = previous->rowCount;
+    version->schema   = previous->schema;
+    version->chunks.reserve(previous->chunks.size() + 1);
+
+    std::vector<const Chunk*> replaced;
+    auto   oldChunk = previous->chunks.begin();
+    size_t next     = 0;
+    while (next < dirtyIds.size())
+    {
+      // IDs of the next dirty chunk
+      size_t key   = dirtyIds[next] / CHUNK_IDS;
+      size_t first = next;
+      while (next < dirtyIds.size() && dirtyIds[next] / CHUNK_IDS == key)
+      {
+        ++next;
+      }
+
+      // Chunks before it are shared
+      while (oldChunk != previous->chunks.end() && (*oldChunk)->key < key)
+      {
+        version->chunks.push_back(*oldChunk++);
+      }
+      const Chunk* source = nullptr;
+      if (oldChunk != previous->chunks.end() && (*oldChunk)->key == key)
+      {
+        source = *oldChunk++;
+        replaced.push_back(source);
+        version->rowCount -= source->rows.size();
+      }
+
+      Chunk* chunk = MergeChunk(table, *version->schema, key, source,
+        dirtyIds.data() + first, dirtyIds.data() + next);
+      if (chunk->rows.empty())
+      {
+        delete chunk;
+        continue;
+      }
+      version->rowCount += chunk->rows.size();
+      version->chunks.push_back(chunk);
+    }
+    version->chunks.insert(version->chunks.end(), oldChunk, previous->chunks.end());
+
+    m_pCurrent.store(version);
+    for (const Chunk* old : replaced)
+    {
+      RetireObject(old);
+    }
+    RetireObject(previous);
+    m_epochs.Reclaim();
+  }
+
+  // Number of the latest version, 0 before the first publish
+  uint64_t GetVersion() const
+  {
+    const Version* version = m_pCurrent.load();
+    return version ? version->number : 0;
+  }
+  // Number of replaced objects still held for pinned readers
+  size_t GetRetiredCount() const
+  {
+    return m_epochs.GetRetiredCount();
+  }
+protected:
+  // Copy of a chunk with the rows [dirty, dirtyEnd) taken from the table
+  static Chunk* MergeChunk(const TableEx<C, N>& table,
+                           const Schema&        schema,
+                           size_t               key,
+                           const Chunk*         source,
+                           const size_t*        dirty,
+                           const size_t*        dirtyEnd)
+  {
+    Chunk* chunk = new Chunk();
+    chunk->key   = key;
+    chunk->rows.reserve((source ? source->rows.size() : 0) + (dirtyEnd - dirty));
+
+    auto copy = [&](size_t id, const RowData& row)
+    {
+      chunk->rows.emplace_back(id, row);
+      LinkRow(chunk->rows.back().second, schema);
+    };
+    auto take = [&](size_t id)
+    {
+      const RowData* row = table.GetRow(id);
+      if (row)
+      {
+        copy(id, *row);
+      }
+    };
+
+    const Row* kept = source ? source->rows.data()     : nullptr;
+    const Row* end  = source ? kept + source->rows.size() : nullptr;
+    while (dirty != dirtyEnd)
+    {
+      if (kept != end && kept->first < *dirty)
+      {
+        copy(kept->first, kept->second);
+        ++kept;
+        continue;
+      }
+      if (kept != end && kept->first == *dirty)
+      {
+        ++kept;
+      }
+      take(*dirty);
+      // Skip repeated IDs
+      size_t id = *dirty;
+      while (dirty != dirtyEnd && *dirty == id)
+      {
+        ++dirty;
+      }
+    }
+    for (; kept != end; ++kept)
+    {
+      copy(kept->first, kept->second);
+    }
+    return chunk;
+  }
+  // Point the cells of a published row at the version's column info
+  static void LinkRow(RowData& row, const Schema& schema)
+  {
+    for (size_t col = 0; col < N; ++col)
+    {
+      row[col].columnInfo = &schema.columns[col];
+    }
+  }
+  template <typename T>
+  void RetireObject(const T* object)
+  {
+    m_epochs.Retire(const_cast<T*>(object), [](void* p)
+    {
+      delete static_cast<T*>(p);
+    });
+  }
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TABLE_EX_VERSIONS_H_
@@ -0,0 +1,121 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include "TextWidthStats.h"
+
+const size_t TextWidthStats::MAX_LENGTH;
+const size_t TextWidthStats::WIDEST_VALUES;
+
+TextWidthStats::TextWidthStats()
+  : m_arrLengths()
+  , m_nCount    (0)
+  , m_nMaxLength(0)
+  , m_bDropped  (false)
+  , m_bStale    (false)
+  , m_nVersion  (1)
+{
+}
+
+void TextWidthStats::Add(const std::string& text)
+{
+  size_t length = (std::min)(Length(text), MAX_LENGTH);
+  ++m_arrLengths[length];
+  ++m_nCount;
+  if (length > m_nMaxLength)
+  {
+    m_nMaxLength = length;
+    ++m_nVersion;
+  }
+
+  auto found = std::find_if(m_vWidest.begin(), m_vWidest.end(),
+    [&](const Value& value) { return value.text == text; });
+  if (found != m_vWidest.end())
+  {
+    ++found->count;
+    return;
+  }
+  if (m_vWidest.size() == WIDEST_VALUES && length <= m_vWidest.back().length)
+  {
+    m_bDropped = true;
+    return;
+  }
+
+  // Keep the list ordered, longest first
+  auto position = std::find_if(m_vWidest.begin(), m_vWidest.end(),
+    [&](const Value& value) { return value.length < length; });
+  m_vWidest.insert(position, Value{ text, length, 1 });
+  if (m_vWidest.size() > WIDEST_VALUES)
+  {
+    m_vWidest.pop_back();
+    m_bDropped = true;
+  }
+  ++m_nVersion;
+}
+
+void TextWidthStats::Remove(const std::string& text)
+{
+  size_t length = (std::min)(Length(text), MAX_LENGTH);
+  if (m_arrLengths[length] == 0)
+    return;
+
+  --m_arrLengths[length];
+  --m_nCount;
+  if (length == m_nMaxLength && m_arrLengths[length] == 0)
+  {
+    // The longest value went, look for the next longest
+    while (m_nMaxLength > 0 && m_arrLengths[m_nMaxLength] == 0)
+    {
+      --m_nMaxLength;
+    }
+    ++m_nVersion;
+  }
+
+  auto found = std::find_if(m_vWidest.begin(), m_vWidest.end(),
+    [&](const Value& value) { return value.text == text; });
+  if (found == m_vWidest.end() || --found->count > 0)
+    return;
+
+  m_vWidest.erase(found);
+  m_bStale = m_bStale || m_bDropped;
+  ++m_nVersion;
+}
+
+void TextWidthStats::Clear()
+{
+  m_arrLengths.fill(0);
+  m_nCount     = 0;
+  m_nMaxLength = 0;
+  m_vWidest.clear();
+  m_bDropped = false;
+  m_bStale   = false;
+  ++m_nVersion;
+}
+
+size_t TextWidthStats::GetBytes() const
+{
+  size_t bytes = m_vWidest.capacity() * sizeof(Value);
+  for (const Value& value : m_vWidest)
+  {
+    bytes += value.text.capacity() > std::string().capacity() ? value.text.capacity() + 1 : 0;
+  }
+  return bytes;
+}
+
+size_t TextWidthStats::Length(const std::string& text)
+{
+  // Every byte but UTF-8 continuation bytes starts a character
+  size_t length = 0;
+  for (char ch : text)
+  {
+    length += (static_cast<unsigned char>(ch) & 0xC0) != 0x80 ? 1 : 0;
+  }
+  return length;
+}
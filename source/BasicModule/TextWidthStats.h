@@ -0,0 +1,86 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TEXT_WIDTH_STATS_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TEXT_WIDTH_STATS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*****************************************************************************
+ *
+ * CLASS   : TextWidthStats
+ * PURPOSE : Lengths of the formatted values of a column, for auto-sizing
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Counts values by length in characters (UTF-8 code points, at
+ *           most MAX_LENGTH) and keeps the WIDEST_VALUES longest distinct
+ *           texts with their counts, so a column is sized by measuring a
+ *           handful of texts instead of every row. Taking out a kept text
+ *           after longer-than-kept texts were turned away makes the kept
+ *           ones incomplete (IsStale); the owner then adds every value
+ *           again. The version changes whenever the longest length or the
+ *           kept texts do, so unchanged columns need not be measured.
+ *
+ *****************************************************************************/
+
+class TextWidthStats
+{
+public:
+  struct Value
+  {
+    std::string            text;
+    size_t                 length;
+    size_t                 count;
+  };
+
+  // Lengths counted separately, longer ones count as MAX_LENGTH
+  static const size_t MAX_LENGTH    = 256;
+  // Longest distinct texts kept
+  static const size_t WIDEST_VALUES = 8;
+
+  TextWidthStats();
+
+  // Count a value as displayed
+  void   Add          (const std::string& text);
+  // Take back a value added before
+  void   Remove       (const std::string& text);
+  // Forget every value (the version still moves on)
+  void   Clear        ();
+
+  // Number of values counted
+  size_t GetCount     () const { return m_nCount;   }
+  // Length of the longest value, in characters
+  size_t GetMaxLength () const { return m_nMaxLength; }
+  // Longest distinct texts, longest first
+  const std::vector<Value>& GetWidest() const { return m_vWidest; }
+  // Check if longer texts than some kept ones may be missing
+  bool   IsStale      () const { return m_bStale;   }
+  // Changes whenever GetMaxLength or GetWidest may have
+  uint64_t GetVersion () const { return m_nVersion; }
+  // Bytes held
+  size_t GetBytes     () const;
+
+  // Length of text in characters
+  static size_t Length(const std::string& text);
+protected:
+  std::array<size_t, MAX_LENGTH + 1> m_arrLengths;
+  size_t                 m_nCount;
+  size_t                 m_nMaxLength;
+  std::vector<Value>     m_vWidest;
+  // Set once a text was turned away or pushed out of m_vWidest
+  bool                   m_bDropped;
+  bool                   m_bStale;
+  uint64_t               m_nVersion;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TEXT_WIDTH_STATS_H_
@@ -0,0 +1,450 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include "IdRangeSet.h"
+#include "TrigramIndex.h"
+
+namespace
+{
+  // A block of short postings per first byte, of the byte alone and of
+  // the byte followed by each other byte
+  const size_t SHORT_BLOCKS     = 256;
+  const size_t SHORT_BLOCK_SIZE = 1 + 256;
+
+  // Pack a window of 1 to 3 bytes, its length in the top byte
+  uint32_t PackGram(const unsigned char* p, size_t length)
+  {
+    uint32_t gram = static_cast<uint32_t>(length) << 24;
+    for (size_t i = 0; i < length; ++i)
+    {
+      gram |= uint32_t(p[i]) << (8 * (2 - i));
+    }
+    return gram;
+  }
+}
+
+TrigramIndex::Posting::Posting()
+  : m_nCount(0)
+{
+}
+
+void TrigramIndex::Posting::Insert(size_t id)
+{
+  size_t   key = id >> 16;
+  uint16_t low = static_cast<uint16_t>(id);
+
+  // Rows mostly arrive in ID order, so look at the last chunk first
+  auto chunk = (!m_vChunks.empty() && m_vChunks.back().key <= key)
+             ? m_vChunks.end() - 1 : FindChunk(key);
+  if (chunk == m_vChunks.end() || chunk->key != key)
+  {
+    if (chunk != m_vChunks.end() && chunk->key < key)
+    {
+      ++chunk;
+    }
+    chunk = m_vChunks.insert(chunk, Chunk{ key, 0, false, {} });
+  }
+
+  if (chunk->bitmap)
+  {
+    uint16_t& word = chunk->data[low >> 4];
+    uint16_t  bit  = static_cast<uint16_t>(1u << (low & 15));
+    if (word & bit)
+      return;
+
+    word |= bit;
+  }
+  else
+  {
+    std::vector<uint16_t>& values = chunk->data;
+    if (values.empty() || values.back() < low)
+    {
+      values.push_back(low);
+    }
+    else
+    {
+      auto pos = std::lower_bound(values.begin(), values.end(), low);
+      if (*pos == low)
+        return;
+
+      values.insert(pos, low);
+    }
+  }
+  ++chunk->count;
+  ++m_nCount;
+  if (!chunk->bitmap && chunk->count > ARRAY_MAX)
+  {
+    ToBitmap(*chunk);
+  }
+}
+
+void TrigramIndex::Posting::Erase(size_t id)
+{
+  size_t   key   = id >> 16;
+  uint16_t low   = static_cast<uint16_t>(id);
+  auto     chunk = FindChunk(key);
+  if (chunk == m_vChunks.end() || chunk->key != key)
+    return;
+
+  if (chunk->bitmap)
+  {
+    uint16_t& word = chunk->data[low >> 4];
+    uint16_t  bit  = static_cast<uint16_t>(1u << (low & 15));
+    if (!(word & bit))
+      return;
+
+    word &= static_cast<uint16_t>(~bit);
+  }
+  else
+  {
+    std::vector<uint16_t>& values = chunk->data;
+    auto pos = std::lower_bound(values.begin(), values.end(), low);
+    if (pos == values.end() || *pos != low)
+      return;
+
+    values.erase(pos);
+  }
+  --m_nCount;
+  if (--chunk->count == 0)
+  {
+    m_vChunks.erase(chunk);
+  }
+  else if (chunk->bitmap && chunk->count < ARRAY_MAX / 2)
+  {
+    // Not at ARRAY_MAX, so that an ID going and coming does not convert
+    ToArray(*chunk);
+  }
+}
+
+bool TrigramIndex::Posting::Contains(size_t id) const
+{
+  size_t   key   = id >> 16;
+  uint16_t low   = static_cast<uint16_t>(id);
+  auto     chunk = FindChunk(key);
+  if (chunk == m_vChunks.end() || chunk->key != key)
+    return false;
+
+  if (chunk->bitmap)
+    return (chunk->data[low >> 4] >> (low & 15)) & 1;
+
+  return std::binary_search(chunk->data.begin(), chunk->data.end(), low);
+}
+
+void TrigramIndex::Posting::AppendTo(std::vector<size_t>& ids) const
+{
+  ids.reserve(ids.size() + m_nCount);
+  for (const Chunk& chunk : m_vChunks)
+  {
+    size_t base = chunk.key << 16;
+    if (!chunk.bitmap)
+    {
+      for (uint16_t low : chunk.data)
+      {
+        ids.push_back(base | low);
+      }
+      continue;
+    }
+    for (size_t word = 0; word < BITMAP_WORDS; ++word)
+    {
+      for (uint32_t bits = chunk.data[word]; bits != 0; bits &= bits - 1)
+      {
+        size_t bit = 0;
+        while (!((bits >> bit) & 1))
+        {
+          ++bit;
+        }
+        ids.push_back(base | (word << 4) | bit);
+      }
+    }
+  }
+}
+
+size_t TrigramIndex::Posting::GetBytes() const
+{
+  size_t bytes = m_vChunks.capacity() * sizeof(Chunk);
+  for (const Chunk& chunk : m_vChunks)
+  {
+    bytes += chunk.data.capacity() * sizeof(uint16_t);
+  }
+  return bytes;
+}
+
+TrigramIndex::Posting::ChunkVector::iterator TrigramIndex::Posting::FindChunk(size_t key)
+{
+  return std::lower_bound(m_vChunks.begin(), m_vChunks.end(), key,
+    [](const Chunk& chunk, size_t k) { return chunk.key < k; });
+}
+
+TrigramIndex::Posting::ChunkVector::const_iterator TrigramIndex::Posting::FindChunk(size_t key) const
+{
+  return std::lower_bound(m_vChunks.begin(), m_vChunks.end(), key,
+    [](const Chunk& chunk, size_t k) { return chunk.key < k; });
+}
+
+void TrigramIndex::Posting::ToBitmap(Chunk& chunk)
+{
+  std::vector<uint16_t> bits(BITMAP_WORDS, 0);
+  for (uint16_t low : chunk.data)
+  {
+    bits[low >> 4] |= static_cast<uint16_t>(1u << (low & 15));
+  }
+  chunk.data.swap(bits);
+  chunk.bitmap = true;
+}
+
+void TrigramIndex::Posting::ToArray(Chunk& chunk)
+{
+  std::vector<uint16_t> values;
+  values.reserve(chunk.count);
+  for (size_t low = 0; low < 65536; ++low)
+  {
+    if ((chunk.data[low >> 4] >> (low & 15)) & 1)
+    {
+      values.push_back(static_cast<uint16_t>(low));
+    }
+  }
+  chunk.data.swap(values);
+  chunk.bitmap = false;
+}
+
+TrigramIndex::TrigramIndex()
+  : m_vShortPostings(SHORT_BLOCKS)
+{
+}
+
+std::string TrigramIndex::Fold(const std::string& text)
+{
+  std::string folded(text);
+  for (char& ch : folded)
+  {
+    if (ch >= 'A' && ch <= 'Z')
+    {
+      ch = static_cast<char>(ch - 'A' + 'a');
+    }
+  }
+  return folded;
+}
+
+void TrigramIndex::Insert(size_t id, const std::vector<std::string>& texts)
+{
+  CollectGrams(texts, m_vGrams);
+  for (uint32_t gram : m_vGrams)
+  {
+    GetPosting(gram).Insert(id);
+  }
+}
+
+void TrigramIndex::Erase(size_t id, const std::vector<std::string>& texts)
+{
+  CollectGrams(texts, m_vGrams);
+  for (uint32_t gram : m_vGrams)
+  {
+    ErasePosting(gram, id);
+  }
+}
+
+void TrigramIndex::Update(size_t                          id,
+                          const std::vector<std::string>& oldTexts,
+                          const std::vector<std::string>& newTexts)
+{
+  if (oldTexts == newTexts)
+    return;
+
+  CollectGrams(oldTexts, m_vGrams);
+  CollectGrams(newTexts, m_vNewGrams);
+  for (std::vector<uint32_t>* grams : { &m_vGrams, &m_vNewGrams })
+  {
+    std::sort(grams->begin(), grams->end());
+    grams->erase(std::unique(grams->begin(), grams->end()), grams->end());
+  }
+
+  // Walk both sorted lists, a window in one only is erased or inserted
+  auto oldGram = m_vGrams.begin();
+  auto newGram = m_vNewGrams.begin();
+  while (oldGram != m_vGrams.end() || newGram != m_vNewGrams.end())
+  {
+    if (newGram == m_vNewGrams.end() || (oldGram != m_vGrams.end() && *oldGram < *newGram))
+    {
+      ErasePosting(*oldGram++, id);
+    }
+    else if (oldGram == m_vGrams.end() || *newGram < *oldGram)
+    {
+      GetPosting(*newGram++).Insert(id);
+    }
+    else
+    {
+      ++oldGram;
+      ++newGram;
+    }
+  }
+}
+
+void TrigramIndex::Clear()
+{
+  for (ShortPostings& block : m_vShortPostings)
+  {
+    ShortPostings().swap(block);
+  }
+  PostingMap().swap(m_mapPostings);
+}
+
+IdRangeSet TrigramIndex::Search(const std::string& pattern, bool& exact) const
+{
+  std::vector<size_t>  ids;
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(pattern.data());
+  exact = true;
+
+  if (pattern.empty())
+    return IdRangeSet();
+
+  if (pattern.size() <= 3)
+  {
+    // Every occurrence is a window of the pattern's length
+    const Posting* posting = FindPosting(PackGram(p, pattern.size()));
+    if (posting)
+    {
+      posting->AppendTo(ids);
+    }
+    return IdRangeSet::FromSorted(ids);
+  }
+
+  // Intersect the postings of every trigram, walking the smallest one
+  std::vector<const Posting*> postings;
+  for (size_t i = 0; i + 3 <= pattern.size(); ++i)
+  {
+    const Posting* posting = FindPosting(PackGram(p + i, 3));
+    if (!posting)
+      return IdRangeSet();
+
+    postings.push_back(posting);
+  }
+  std::sort(postings.begin(), postings.end(),
+    [](const Posting* a, const Posting* b)
+  {
+    return a->Count() < b->Count();
+  });
+  postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+
+  postings.front()->AppendTo(ids);
+  ids.erase(std::remove_if(ids.begin(), ids.end(), [&](size_t id)
+  {
+    for (size_t i = 1; i < postings.size(); ++i)
+    {
+      if (!postings[i]->Contains(id))
+        return true;
+    }
+    return false;
+  }), ids.end());
+  // Trigrams may come from different texts or places
+  exact = false;
+  return IdRangeSet::FromSorted(ids);
+}
+
+size_t TrigramIndex::GetGramCount() const
+{
+  size_t count = m_mapPostings.size();
+  for (const ShortPostings& block : m_vShortPostings)
+  {
+    for (const Posting& posting : block)
+    {
+      count += posting.Empty() ? 0 : 1;
+    }
+  }
+  return count;
+}
+
+size_t TrigramIndex::GetBytes() const
+{
+  // A hash node carries its value and a link, each bucket one more link
+  size_t bytes = m_mapPostings.size() * (sizeof(PostingMap::value_type) + sizeof(void*))
+               + m_mapPostings.bucket_count() * sizeof(void*)
+               + m_vShortPostings.size() * sizeof(ShortPostings);
+  for (const ShortPostings& block : m_vShortPostings)
+  {
+    for (const Posting& posting : block)
+    {
+      bytes += sizeof(Posting) + posting.GetBytes();
+    }
+  }
+  for (const auto& posting : m_mapPostings)
+  {
+    bytes += posting.second.GetBytes();
+  }
+  return bytes;
+}
+
+void TrigramIndex::CollectGrams(const std::vector<std::string>& texts,
+                                std::vector<uint32_t>&          grams)
+{
+  grams.clear();
+  for (const std::string& text : texts)
+  {
+    const unsigned char* p    = reinterpret_cast<const unsigned char*>(text.data());
+    size_t               size = text.size();
+    for (size_t i = 0; i < size; ++i)
+    {
+      for (size_t length = 1; length <= 3 && i + length <= size; ++length)
+      {
+        grams.push_back(PackGram(p + i, length));
+      }
+    }
+  }
+}
+
+const TrigramIndex::Posting* TrigramIndex::FindPosting(uint32_t gram) const
+{
+  size_t length = gram >> 24;
+  if (length < 3)
+  {
+    const ShortPostings& block = m_vShortPostings[(gram >> 16) & 0xFF];
+    if (block.empty())
+      return nullptr;
+
+    const Posting& posting = block[(length == 1) ? 0 : 1 + ((gram >> 8) & 0xFF)];
+    return posting.Empty() ? nullptr : &posting;
+  }
+  auto it = m_mapPostings.find(gram);
+  return (it == m_mapPostings.end()) ? nullptr : &it->second;
+}
+
+TrigramIndex::Posting& TrigramIndex::GetPosting(uint32_t gram)
+{
+  size_t length = gram >> 24;
+  if (length < 3)
+  {
+    ShortPostings& block = m_vShortPostings[(gram >> 16) & 0xFF];
+    if (block.empty())
+    {
+      block.resize(SHORT_BLOCK_SIZE);
+    }
+    return block[(length == 1) ? 0 : 1 + ((gram >> 8) & 0xFF)];
+  }
+  return m_mapPostings[gram];
+}
+
+void TrigramIndex::ErasePosting(uint32_t gram, size_t id)
+{
+  if ((gram >> 24) < 3)
+  {
+    // Short postings stay in their block even when empty
+    GetPosting(gram).Erase(id);
+    return;
+  }
+  auto it = m_mapPostings.find(gram);
+  if (it == m_mapPostings.end())
+    return;
+
+  it->second.Erase(id);
+  if (it->second.Empty())
+  {
+    m_mapPostings.erase(it);
+  }
+}
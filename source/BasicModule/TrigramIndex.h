@@ -0,0 +1,150 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#ifndef   GUI_WXWIDGETS_MAIN_APP_TRIGRAM_INDEX_H_
+#define   GUI_WXWIDGETS_MAIN_APP_TRIGRAM_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*****************************************************************************
+ *
+ * CLASS   : TrigramIndex
+ * PURPOSE : Substring search over the texts of rows, by row ID
+ * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+ * COMMENTS: Every 1, 2 and 3-byte window of each text maps to the IDs of
+ *           the rows containing it. Texts are searched case insensitively
+ *           for ASCII (see Fold). Patterns of 1 to 3 bytes are answered
+ *           exactly from their own posting; longer patterns give the rows
+ *           holding all of their trigrams, which the caller checks.
+ *           Windows of 1 and 2 bytes, met several times per text, are
+ *           looked up in a table by their bytes; trigrams are hashed.
+ *
+ *****************************************************************************/
+
+class TrigramIndex
+{
+public:
+  /*****************************************************************************
+   *
+   * CLASS   : Posting
+   * PURPOSE : Sorted set of the row IDs holding one window
+   * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+   * COMMENTS: IDs are split into chunks by their bits above the low 16. A
+   *           chunk keeps the low bits as a sorted array while it holds at
+   *           most ARRAY_MAX of them and as a bitmap once denser, so an ID
+   *           costs at most two bytes and one appended in order is pushed
+   *           at the back.
+   *
+   *****************************************************************************/
+  class Posting
+  {
+  public:
+    Posting();
+
+    // Add an ID, cheapest when it is above every ID held
+    void   Insert  (size_t id);
+    // Remove an ID
+    void   Erase   (size_t id);
+    // Check if an ID is held, O(log chunks + log ARRAY_MAX)
+    bool   Contains(size_t id) const;
+    // Number of IDs held
+    size_t Count   () const { return m_nCount;      }
+    // Check if no ID is held
+    bool   Empty   () const { return m_nCount == 0; }
+    // Append every ID held to ids in ascending order
+    void   AppendTo(std::vector<size_t>& ids) const;
+    // Approximate bytes held
+    size_t GetBytes() const;
+  protected:
+    struct Chunk
+    {
+      // ID bits above the low 16
+      size_t                key;
+      // Number of IDs in the chunk
+      size_t                count;
+      // Indicates data is a bitmap of BITMAP_WORDS words
+      bool                  bitmap;
+      // Sorted low bits, or the bitmap of them
+      std::vector<uint16_t> data;
+    };
+    using ChunkVector = std::vector<Chunk>;
+
+    // Chunks are arrays up to this many IDs, bitmaps (of the same size) above
+    static const size_t ARRAY_MAX    = 4096;
+    static const size_t BITMAP_WORDS = 65536 / 16;
+
+    // Get the chunk of key, or where it would be inserted
+    ChunkVector::iterator       FindChunk(size_t key);
+    ChunkVector::const_iterator FindChunk(size_t key) const;
+    // Switch a chunk between its array and bitmap forms
+    static void ToBitmap(Chunk& chunk);
+    static void ToArray (Chunk& chunk);
+  protected:
+    ChunkVector            m_vChunks;
+    size_t                 m_nCount;
+  };
+  // Trigram postings keyed by their packed bytes
+  using PostingMap = std::unordered_map<uint32_t, Posting>;
+
+  TrigramIndex();
+
+  // Lower-case ASCII letters; other bytes, including UTF-8, are kept
+  static std::string Fold(const std::string& text);
+
+  // Index a row under the windows of its (folded) texts
+  void   Insert         (size_t id, const std::vector<std::string>& texts);
+  // Remove a row indexed with the same texts before
+  void   Erase          (size_t id, const std::vector<std::string>& texts);
+  // Re-index a row indexed with oldTexts before, touching only the windows
+  // that are not in both
+  void   Update         (size_t                          id,
+                         const std::vector<std::string>& oldTexts,
+                         const std::vector<std::string>& newTexts);
+  // Remove every row
+  void   Clear          ();
+
+  // IDs of the rows whose texts may contain pattern (folded). exact is set
+  // if every returned row is known to contain it.
+  IdRangeSet Search     (const std::string& pattern, bool& exact) const;
+
+  // Number of distinct windows
+  size_t GetGramCount   () const;
+  // Approximate bytes held
+  size_t GetBytes       () const;
+protected:
+  // Postings of the short windows starting with one byte: the byte alone,
+  // then the byte followed by each other byte. Empty until the byte is met.
+  using ShortPostings = std::vector<Posting>;
+
+  // Windows of 1 to 3 bytes of texts, duplicates included (a posting keeps
+  // an ID once), each packed with its length in the top byte
+  static void CollectGrams(const std::vector<std::string>& texts,
+                           std::vector<uint32_t>&          grams);
+  // Get the posting of a packed window, nullptr if there is none
+  const Posting* FindPosting(uint32_t gram) const;
+  // Get the posting of a packed window, adding it if needed
+  Posting&       GetPosting (uint32_t gram);
+  // Remove an ID from the posting of a packed window, dropping an emptied
+  // trigram posting
+  void           ErasePosting(uint32_t gram, size_t id);
+protected:
+  // Short window postings by first byte
+  std::vector<ShortPostings> m_vShortPostings;
+  PostingMap             m_mapPostings;
+  // Scratch buffers reused by Insert, Erase and Update
+  std::vector<uint32_t>  m_vGrams;
+  std::vector<uint32_t>  m_vNewGrams;
+};
+
+#endif // GUI_WXWIDGETS_MAIN_APP_TRIGRAM_INDEX_H_
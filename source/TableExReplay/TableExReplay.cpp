@@ -0,0 +1,416 @@
+﻿/*****************************************************************************
+ *
+ * Copyright (C) 2015-2025 Poetic Flower Studio. All Rights Reserved.
+ *
+ * CONFIDENTIALITY:  This software source code is considered confidential
+ * information. It must be kept confidential in accordance with the terms
+ * and conditions of your Software License Agreement.
+ *
+ *****************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <TableEx.hpp>
+#include <TableExTrace.h>
+#include <TableExRecorder.hpp>
+
+/*****************************************************************************
+ *
+ * TableExReplay: replay a trace recorded by TableExRecorder and
+ * RecordingTableExAdapter against a headless TableEx, and report how long
+ * updates took to reach the screen.
+ *
+ *   TableExReplay <trace> [--speed <factor> | --max]
+ *
+ * Records are applied at their recorded times, scaled by factor (1 by
+ * default), or back to back with --max. A list refresh is replayed the way
+ * a virtual list draws: the view size, the lazy sort of the visible items
+ * and the text of each visible cell. The latency of an update is the time
+ * from when it was due until the end of the first refresh after it.
+ *
+ *****************************************************************************/
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  // Columns supported, the table is instantiated for each count up to it
+  const size_t MAX_COLUMNS = 16;
+
+  struct ReplayExtraInfo
+  {
+    int      width;
+  };
+
+  struct ReplayOptions
+  {
+    // Recorded time is divided by speed, 0 replays as fast as possible
+    double   speed = 1.0;
+  };
+
+  struct ReplayReport
+  {
+    size_t               upserts         = 0;
+    size_t               clears          = 0;
+    size_t               transactions    = 0;
+    size_t               listOps         = 0;
+    size_t               refreshes       = 0;
+    // Function filters can not be recorded, so they are not replayed
+    size_t               skippedFilters  = 0;
+    // Updates no refresh showed before the trace ended
+    size_t               unrefreshed     = 0;
+    size_t               initialRows     = 0;
+    // Microseconds from an update being due to it being drawn
+    std::vector<double>  latencies;
+    // Microseconds spent in each refresh
+    std::vector<double>  refreshTimes;
+    // Microseconds spent applying records, excluding waits
+    double               busyTime        = 0.0;
+    double               wallTime        = 0.0;
+    double               traceTime       = 0.0;
+    // Keeps the drawn texts from being optimized away
+    size_t               drawnChars      = 0;
+  };
+
+  double Microseconds(Clock::duration duration)
+  {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  }
+
+  // Value at fraction p of sorted values
+  double Percentile(const std::vector<double>& sorted, double p)
+  {
+    if (sorted.empty())
+      return 0.0;
+
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[(std::min)(index, sorted.size() - 1)];
+  }
+
+  void PrintPercentiles(const char* title, std::vector<double>& values)
+  {
+    std::sort(values.begin(), values.end());
+    printf("%-18s p50 %10.1f  p90 %10.1f  p99 %10.1f  p99.9 %10.1f  max %10.1f us\n",
+      title,
+      Percentile(values, 0.5), Percentile(values, 0.9), Percentile(values, 0.99),
+      Percentile(values, 0.999), values.empty() ? 0.0 : values.back());
+  }
+
+  /*****************************************************************************
+   *
+   * CLASS   : TraceReplayer
+   * PURPOSE : Replay the records of a trace on a TableEx<C, N>
+   * AUTHOR  : Peixuan Zhang <Zhang@PoeticFlower.CN>
+   * COMMENTS: Records are read ahead and the starting rows loaded before the
+   *           clock starts, so neither I/O nor setup is measured
+   *
+   *****************************************************************************/
+
+  template <size_t N>
+  class TraceReplayer
+  {
+  public:
+    using Table      = TableEx<ReplayExtraInfo, N>;
+    using RowData    = typename Table::RowData;
+    using ColumnType = typename ColumnInfo<ReplayExtraInfo>::ColumnType;
+    using Recorder   = TableExRecorder<ReplayExtraInfo, N>;
+  protected:
+    Table                            m_table;
+    std::vector<TableExTraceRecord>  m_vRecords;
+    // Due times of the updates not drawn yet
+    std::vector<Clock::time_point>   m_vPending;
+    RowData                          m_row;
+  public:
+    // Set up the table as the trace header describes and read the records
+    bool Load(TableExTraceReader& reader, ReplayReport& report)
+    {
+      const TableExTraceHeader& header = reader.GetHeader();
+      for (size_t col = 0; col < N; ++col)
+      {
+        const TableExTraceColumn& column = header.columns[col];
+        ColumnInfo<ReplayExtraInfo> info = {};
+        info.type   = static_cast<ColumnType>(column.type);
+        info.format = column.format;
+        info.name   = column.name;
+        m_table.SetColumnInfo(col, info);
+        if (column.indexed)
+        {
+          m_table.CreateIndex(col);
+        }
+        if (column.textIndexed)
+        {
+          m_table.EnableTextIndex(col);
+        }
+      }
+      m_table.EnableZoneMaps(header.zoneMaps);
+
+      TableExTraceRecord record;
+      while (reader.Next(record))
+      {
+        if (record.op == TableExTraceOp::UPSERT && (record.flags & TableExTraceRecord::INITIAL))
+        {
+          if (!Recorder::DecodeRow(record.cells, m_row))
+            return false;
+
+          m_table.UpsertRow(static_cast<size_t>(record.target), m_row);
+          ++report.initialRows;
+          continue;
+        }
+        m_vRecords.push_back(std::move(record));
+        record = TableExTraceRecord();
+      }
+      return true;
+    }
+
+    // Apply the records in time, as options ask
+    bool Run(const ReplayOptions& options, ReplayReport& report)
+    {
+      Clock::time_point start = Clock::now();
+      for (const TableExTraceRecord& record : m_vRecords)
+      {
+        Clock::time_point due = Clock::now();
+        if (options.speed > 0.0)
+        {
+          due = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::micro>(static_cast<double>(record.time) / options.speed));
+          std::this_thread::sleep_until(due);
+        }
+
+        Clock::time_point begin = Clock::now();
+        if (!Apply(record, due, report))
+          return false;
+        report.busyTime += Microseconds(Clock::now() - begin);
+      }
+      report.wallTime    = Microseconds(Clock::now() - start);
+      report.traceTime   = m_vRecords.empty() ? 0.0 : static_cast<double>(m_vRecords.back().time);
+      report.unrefreshed = m_vPending.size();
+      return true;
+    }
+  protected:
+    bool Apply(const TableExTraceRecord& record, Clock::time_point due, ReplayReport& report)
+    {
+      size_t col = static_cast<size_t>(record.target);
+      switch (record.op)
+      {
+      case TableExTraceOp::UPSERT:
+        if (!Recorder::DecodeRow(record.cells, m_row))
+          return false;
+
+        m_table.UpsertRow(static_cast<size_t>(record.target), m_row);
+        m_vPending.push_back(due);
+        ++report.upserts;
+        break;
+      case TableExTraceOp::CLEAR:
+        m_table.Clear();
+        m_vPending.push_back(due);
+        ++report.clears;
+        break;
+      case TableExTraceOp::BEGIN:
+        m_table.BeginTransaction();
+        break;
+      case TableExTraceOp::COMMIT:
+        m_table.CommitTransaction();
+        ++report.transactions;
+        break;
+      case TableExTraceOp::SORT:
+        m_table.SortByColumn(col, (record.flags & 1) != 0, static_cast<size_t>(record.first));
+        ++report.listOps;
+        break;
+      case TableExTraceOp::RANGE_FILTER:
+      {
+        if (col >= N || record.texts.size() != 2)
+          return false;
+
+        const ColumnInfo<ReplayExtraInfo>& info = m_table.GetColumnInfo(col);
+        const std::string& lower = record.texts[0];
+        const std::string& upper = record.texts[1];
+        ColumnData<ReplayExtraInfo> lowerValue = ColumnData<ReplayExtraInfo>::FromText(info.type, lower, info.format);
+        ColumnData<ReplayExtraInfo> upperValue = ColumnData<ReplayExtraInfo>::FromText(info.type, upper, info.format);
+        m_table.SetRangeFilter(col,
+          lower.empty() ? nullptr : &lowerValue,
+          upper.empty() ? nullptr : &upperValue,
+          (record.flags & TableExTraceRecord::UPPER_OPEN) != 0);
+        ++report.listOps;
+        break;
+      }
+      case TableExTraceOp::VALUE_FILTER:
+      {
+        // As TableExAdapter::SetValueFilter: match the displayed text
+        auto texts = std::make_shared<std::unordered_set<std::string>>(
+          record.texts.begin(), record.texts.end());
+        bool exclude = (record.flags & TableExTraceRecord::EXCLUDE) != 0;
+        m_table.SetFilter(col, [texts, exclude](const void* cell)
+        {
+          return (texts->count(static_cast<const ColumnData<ReplayExtraInfo>*>(cell)->FormatValue()) > 0) != exclude;
+        });
+        ++report.listOps;
+        break;
+      }
+      case TableExTraceOp::FUNCTION_FILTER:
+        ++report.skippedFilters;
+        break;
+      case TableExTraceOp::CLEAR_FILTER:
+        m_table.ClearFilter(col);
+        ++report.listOps;
+        break;
+      case TableExTraceOp::QUICK_SEARCH:
+        m_table.SetQuickSearch(record.texts.empty() ? std::string() : record.texts[0]);
+        ++report.listOps;
+        break;
+      case TableExTraceOp::REFRESH:
+        Refresh(record, report);
+        break;
+      default:
+        return false;
+      }
+      return true;
+    }
+
+    // Draw the visible items the way a virtual list over TableExAdapter does
+    void Refresh(const TableExTraceRecord& record, ReplayReport& report)
+    {
+      Clock::time_point begin = Clock::now();
+      size_t rows  = m_table.size();
+      size_t first = static_cast<size_t>(record.first);
+      size_t last  = (std::min)(rows, first + static_cast<size_t>(record.count));
+      if (!m_table.HasActiveFilters() && first < last)
+      {
+        m_table.EnsureSorted(first, last);
+      }
+      for (size_t item = first; item < last; ++item)
+      {
+        const typename Table::RowNode* node = m_table.GetViewNode(item);
+        if (!node)
+          break;
+
+        for (const ColumnData<ReplayExtraInfo>& cell : node->second)
+        {
+          report.drawnChars += cell.FormatValueW().size();
+        }
+      }
+
+      Clock::time_point end = Clock::now();
+      report.refreshTimes.push_back(Microseconds(end - begin));
+      for (Clock::time_point due : m_vPending)
+      {
+        report.latencies.push_back(Microseconds(end - due));
+      }
+      m_vPending.clear();
+      ++report.refreshes;
+    }
+  };
+
+  // Replay with the column count fixed at compile time
+  template <size_t N>
+  bool Replay(TableExTraceReader& reader, const ReplayOptions& options, ReplayReport& report)
+  {
+    if constexpr (N <= MAX_COLUMNS)
+    {
+      if (reader.GetHeader().columns.size() != N)
+        return Replay<N + 1>(reader, options, report);
+
+      // Too large for the stack with many columns
+      std::unique_ptr<TraceReplayer<N>> replayer(new TraceReplayer<N>());
+      if (!replayer->Load(reader, report))
+      {
+        fprintf(stderr, "Malformed row in the trace\n");
+        return false;
+      }
+      if (!replayer->Run(options, report))
+      {
+        fprintf(stderr, "Malformed record in the trace\n");
+        return false;
+      }
+      return true;
+    }
+    else
+    {
+      fprintf(stderr, "Traces of 1 to %zu columns are supported\n", MAX_COLUMNS);
+      return false;
+    }
+  }
+
+  void PrintReport(ReplayReport& report)
+  {
+    printf("Initial rows       %zu\n", report.initialRows);
+    printf("Upserts            %zu\n", report.upserts);
+    printf("Clears             %zu\n", report.clears);
+    printf("Transactions       %zu\n", report.transactions);
+    printf("List operations    %zu\n", report.listOps);
+    printf("Refreshes          %zu\n", report.refreshes);
+    if (report.skippedFilters)
+    {
+      printf("Function filters   %zu (not replayed)\n", report.skippedFilters);
+    }
+    if (report.unrefreshed)
+    {
+      printf("Never drawn        %zu updates\n", report.unrefreshed);
+    }
+    PrintPercentiles("Update latency", report.latencies);
+    PrintPercentiles("Refresh time", report.refreshTimes);
+    printf("Trace time         %.3f s\n", report.traceTime / 1e6);
+    printf("Wall time          %.3f s\n", report.wallTime  / 1e6);
+    printf("Busy time          %.3f s (%.1f%%)\n", report.busyTime / 1e6,
+      report.wallTime > 0.0 ? 100.0 * report.busyTime / report.wallTime : 0.0);
+    // Upserts per second if nothing but replaying them took time
+    printf("Throughput ceiling %.0f upserts/s\n",
+      report.busyTime > 0.0 ? static_cast<double>(report.upserts) * 1e6 / report.busyTime : 0.0);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  ReplayOptions options;
+  const char*   filename = nullptr;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--max") == 0)
+    {
+      options.speed = 0.0;
+    }
+    else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+    {
+      options.speed = atof(argv[++i]);
+      if (options.speed <= 0.0)
+      {
+        fprintf(stderr, "Speed must be positive\n");
+        return 1;
+      }
+    }
+    else if (!filename)
+    {
+      filename = argv[i];
+    }
+    else
+    {
+      filename = nullptr;
+      break;
+    }
+  }
+  if (!filename)
+  {
+    fprintf(stderr, "Usage: %s <trace> [--speed <factor> | --max]\n", argv[0]);
+    return 1;
+  }
+
+  TableExTraceReader reader;
+  if (!reader.Open(filename))
+  {
+    fprintf(stderr, "Can not read trace %s\n", filename);
+    return 1;
+  }
+
+  ReplayReport report;
+  if (!Replay<1>(reader, options, report))
+    return 1;
+
+  PrintReport(report);
+  return 0;
+}
@@ -13,6 +13,17 @@
 
 #define ID_MENU_FILE                                                      12800
 #define ID_MENU_FILE_EXIT                                                 12801
+#define ID_MENU_FILE_OPEN_CSV                                             12802
+#define ID_MENU_FILE_FOLLOW_CSV                                           12803
+#define ID_MENU_FILE_OPEN_ANY_CSV                                         12804
+#define ID_MENU_FILE_RECORD_TRACE                                         12805
+#define ID_MENU_FILE_EXPORT_SNAPSHOT                                      12806
+#define ID_MENU_VIEW                                                      12900
+#define ID_MENU_VIEW_AUTO_SCROLL                                          12901
+#define ID_MENU_VIEW_AUTO_SIZE_COLUMNS                                    12902
+#define ID_MENU_VIEW_GROUP_BY_NAME                                        12903
+#define ID_MENU_VIEW_BLOTTER                                              12904
+#define ID_MENU_VIEW_REPRICE                                              12905
 
 extern const wxString gcStringApplicationTitle;
 
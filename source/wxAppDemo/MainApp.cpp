@@ -10,8 +10,28 @@
 
 #include <wx/wx.h>
 #include <wx/listctrl.h>
+#include <wx/timer.h>
+#include <wx/srchctrl.h>
+#include <thread>
 #include <TableEx.hpp>
 #include <TableExAdapter.hpp>
+#include <TableExDataProvider.hpp>
+#include <PagedTableExAdapter.hpp>
+#include <FileFollower.h>
+#include <TableExFollower.hpp>
+#include <ColumnSketch.h>
+#include <TableExGroupBy.hpp>
+#include <DynTableEx.hpp>
+#include <DynTableExAdapter.hpp>
+#include <TableExTrace.h>
+#include <TableExRecorder.hpp>
+#include <RecordingTableExAdapter.h>
+#include <TableExLookup.hpp>
+#include <EpochManager.h>
+#include <TableExVersions.hpp>
+#include <TableExDataObject.h>
+#include <GlyphWidthCache.h>
+#include <IdRangeSet.h>
 #include <ListViewEx.h>
 #include "GlobalConstants.h"
 #include "MainFrame.h"
@@ -10,26 +10,136 @@
 
 #include <wx/wx.h>
 #include <wx/listctrl.h>
+#include <wx/filedlg.h>
+#include <wx/timer.h>
+#include <wx/srchctrl.h>
+#include <chrono>
 #include <cstdint>
+#include <fstream>
 #include <memory>
+#include <thread>
 #include <unordered_map>
 #include <TableEx.hpp>
 #include <TableExAdapter.hpp>
+#include <TableExDataProvider.hpp>
+#include <PagedTableExAdapter.hpp>
+#include <FileFollower.h>
+#include <TableExFollower.hpp>
+#include <ColumnSketch.h>
+#include <TableExGroupBy.hpp>
+#include <DynTableEx.hpp>
+#include <DynTableExAdapter.hpp>
+#include <TableExTrace.h>
+#include <TableExRecorder.hpp>
+#include <RecordingTableExAdapter.h>
+#include <TableExLookup.hpp>
+#include <EpochManager.h>
+#include <TableExVersions.hpp>
+#include <TableExDataObject.h>
+#include <GlyphWidthCache.h>
+#include <IdRangeSet.h>
 #include <ListViewEx.h>
 #include "GlobalConstants.h"
 #include "MainFrame.h"
 
+namespace
+{
+  using DemoGroupBy  = TableExGroupBy <TableExtraInfo, 6, 5>;
+  using DemoVersions = TableExVersions<TableExtraInfo, 6>;
+
+  // Demo rows by name: how many, and their average scores
+  std::array<DemoGroupBy::Output, 5> DemoGroupOutputs()
+  {
+    using ColumnType = ColumnInfo<TableExtraInfo>::ColumnType;
+    using Aggregate  = DemoGroupBy::Aggregate;
+
+    return {{
+      { Aggregate::KEY  , 2, { ColumnType::STRING, ""    , nullptr, { wxLIST_FORMAT_RIGHT , 80 }, "Name"        } },
+      { Aggregate::COUNT, 0, { ColumnType::UINT64, ""    , nullptr, { wxLIST_FORMAT_CENTRE, 60 }, "Rows"        } },
+      { Aggregate::AVG  , 3, { ColumnType::DOUBLE, "%.1f", nullptr, { wxLIST_FORMAT_CENTRE, 80 }, "Avg Score 1" } },
+      { Aggregate::AVG  , 4, { ColumnType::DOUBLE, "%.1f", nullptr, { wxLIST_FORMAT_CENTRE, 80 }, "Avg Score 2" } },
+      { Aggregate::AVG  , 5, { ColumnType::DOUBLE, "%.1f", nullptr, { wxLIST_FORMAT_CENTRE, 80 }, "Avg Score 3" } } }};
+  }
+
+  // Write every row of a published version as CSV, in ID order; returns
+  // the rows written, or false if the file can not be created
+  bool WriteSnapshotCsv(const DemoVersions::Snapshot& snapshot,
+                        const std::string&            path,
+                        size_t&                       rows)
+  {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+      return false;
+
+    std::string line;
+    for (size_t col = 0; col < 6; ++col)
+    {
+      line += (col > 0) ? "," : "";
+      AppendDelimitedCell(line, snapshot.GetColumnInfo(col).name, ',');
+    }
+    file << line << '\n';
+
+    rows = 0;
+    snapshot.ForEachWithId([&](size_t, const DemoVersions::RowData& row)
+    {
+      line.clear();
+      for (size_t col = 0; col < 6; ++col)
+      {
+        line += (col > 0) ? "," : "";
+        AppendDelimitedCell(line, row[col].FormatValue(), ',');
+      }
+      file << line << '\n';
+      ++rows;
+    });
+    return file.good();
+  }
+}
+
 MainFrame::MainFrame(const wxString& title)
   : wxFrame(nullptr, wxID_ANY, title, wxDefaultPosition, wxDefaultSize)
+  , m_pSearchMain  (nullptr)
   , m_pListViewMain(nullptr)
   , m_adapterDemo(&m_tableDemo)
+  , m_groupDemo(&m_tableDemo, DemoGroupOutputs())
+  , m_adapterGroup(&m_groupDemo.GetResult())
+  , m_lookupInstruments(&m_tableInstruments, 0)
+  , m_adapterBlotter(&m_tableBlotter)
+  , m_followerDemo(&m_tableDemo)
+  , m_timerFollow(this)
+  , m_recorderDemo(&m_tableDemo)
+  , m_bAutoScroll(true)
+  , m_bAutoSizeColumns(true)
+  , m_bGroupByName(false)
+  , m_bGroupBuilt(false)
+  , m_bShowBlotter(false)
+  , m_nReprices(0)
 {
-  m_pListViewMain            = new ListViewEx(this, wxID_ANY);
+  m_pSearchMain              = new wxSearchCtrl(this, wxID_ANY);
+  m_pSearchMain->ShowCancelButton(true);
+  m_pListViewMain            = new ListViewEx(this, wxID_ANY,
+    wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL);
+
+  wxBoxSizer *pSizer = new wxBoxSizer(wxVERTICAL);
+  pSizer->Add(m_pSearchMain  , 0, wxEXPAND | wxALL, 2);
+  pSizer->Add(m_pListViewMain, 1, wxEXPAND);
+  SetSizer(pSizer);
+
+  m_pListViewMain->SetAutoSizeColumns(m_bAutoSizeColumns);
 
   InitializeMenuBar();
   InitializeMessageBinding();
 
   WriteDemoData();
+  WriteBlotterData();
+}
+
+MainFrame::~MainFrame()
+{
+  // The export reads versions owned by this frame
+  if (m_threadExport.joinable())
+  {
+    m_threadExport.join();
+  }
 }
 
 void MainFrame::InitializeMenuBar()
@@ -38,17 +148,331 @@ void MainFrame::InitializeMenuBar()
   wxMenu    *pMenu    = nullptr;
 
   pMenu = new wxMenu();
+  pMenu->Append(ID_MENU_FILE_OPEN_CSV, "&Open CSV...");
+  pMenu->Append(ID_MENU_FILE_FOLLOW_CSV, "&Follow CSV...");
+  pMenu->Append(ID_MENU_FILE_OPEN_ANY_CSV, "Open CSV with &Any Columns...");
+  pMenu->AppendCheckItem(ID_MENU_FILE_RECORD_TRACE, "&Record Trace...");
+  pMenu->Append(ID_MENU_FILE_EXPORT_SNAPSHOT, "&Export Snapshot...");
+  pMenu->AppendSeparator();
   pMenu->Append(ID_MENU_FILE_EXIT, "E&xit");
   pMenuBar->Append(pMenu, "&File");
 
+  pMenu = new wxMenu();
+  pMenu->AppendCheckItem(ID_MENU_VIEW_AUTO_SCROLL, "&Auto Scroll");
+  pMenu->Check(ID_MENU_VIEW_AUTO_SCROLL, m_bAutoScroll);
+  pMenu->AppendCheckItem(ID_MENU_VIEW_AUTO_SIZE_COLUMNS, "Auto Size &Columns");
+  pMenu->Check(ID_MENU_VIEW_AUTO_SIZE_COLUMNS, m_bAutoSizeColumns);
+  pMenu->AppendSeparator();
+  pMenu->AppendCheckItem(ID_MENU_VIEW_GROUP_BY_NAME, "&Group by Name");
+  pMenu->AppendSeparator();
+  pMenu->AppendCheckItem(ID_MENU_VIEW_BLOTTER, "Instrument &Blotter");
+  pMenu->Append(ID_MENU_VIEW_REPRICE, "&Reprice Instruments");
+  pMenuBar->Append(pMenu, "&View");
+
   SetMenuBar(pMenuBar);
 }
 
 void MainFrame::InitializeMessageBinding()
 {
+  Bind(wxEVT_MENU, &MainFrame::OnMenuFileOpenCSV                          , this, ID_MENU_FILE_OPEN_CSV);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuFileFollowCSV                        , this, ID_MENU_FILE_FOLLOW_CSV);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuFileOpenAnyCSV                       , this, ID_MENU_FILE_OPEN_ANY_CSV);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuFileRecordTrace                      , this, ID_MENU_FILE_RECORD_TRACE);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuFileExportSnapshot                   , this, ID_MENU_FILE_EXPORT_SNAPSHOT);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuViewAutoScroll                       , this, ID_MENU_VIEW_AUTO_SCROLL);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuViewAutoSizeColumns                  , this, ID_MENU_VIEW_AUTO_SIZE_COLUMNS);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuViewGroupByName                      , this, ID_MENU_VIEW_GROUP_BY_NAME);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuViewBlotter                          , this, ID_MENU_VIEW_BLOTTER);
+  Bind(wxEVT_MENU, &MainFrame::OnMenuViewReprice                          , this, ID_MENU_VIEW_REPRICE);
+  Bind(wxEVT_TIMER, &MainFrame::OnTimerFollow                             , this);
   Bind(wxEVT_MENU, &MainFrame::OnMenuFileExit                             , this, ID_MENU_FILE_EXIT);
+  m_pSearchMain->Bind(wxEVT_TEXT, &MainFrame::OnSearchText                , this);
+  m_pSearchMain->Bind(wxEVT_SEARCHCTRL_CANCEL_BTN, &MainFrame::OnSearchCancel, this);
+}
+
+
+void MainFrame::OnMenuFileOpenCSV(wxCommandEvent& event)
+{
+  wxFileDialog dialog(this, "Open CSV", "", "",
+    "CSV files (*.csv)|*.csv", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+  if (dialog.ShowModal() != wxID_OK)
+    return;
+
+  std::array<ColumnInfo<TableExtraInfo>, 6> columnInfo;
+  for (size_t col = 0; col < columnInfo.size(); ++col)
+  {
+    columnInfo[col] = m_tableDemo.GetColumnInfo(col);
+  }
+  auto provider = std::make_unique<CsvTableExDataProvider<TableExtraInfo, 6>>(
+    dialog.GetPath().utf8_string(), columnInfo);
+  if (!provider->IsOpen())
+  {
+    wxMessageBox("Failed to open file", "Error", wxICON_ERROR);
+    return;
+  }
+
+  // Switch the list over before the previous file is released
+  auto adapter = std::make_unique<PagedTableExAdapter<TableExtraInfo, 6>>(provider.get());
+  m_pListViewMain->SetTable(adapter.get());
+  m_bGroupByName = false;
+  m_bShowBlotter = false;
+  GetMenuBar()->Check(ID_MENU_VIEW_GROUP_BY_NAME, false);
+  GetMenuBar()->Check(ID_MENU_VIEW_BLOTTER, false);
+  m_pCsvAdapter  = std::move(adapter);
+  m_pCsvProvider = std::move(provider);
+  m_pDynAdapter.reset();
+  m_pDynTable  .reset();
+}
+
+void MainFrame::OnMenuFileFollowCSV(wxCommandEvent& event)
+{
+  wxFileDialog dialog(this, "Follow CSV", "", "",
+    "CSV files (*.csv)|*.csv|Log files (*.log)|*.log|All files (*.*)|*.*",
+    wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+  if (dialog.ShowModal() != wxID_OK)
+    return;
+
+  m_timerFollow.Stop();
+  if (!m_followerDemo.Open(dialog.GetPath().utf8_string()))
+  {
+    wxMessageBox("Failed to open file", "Error", wxICON_ERROR);
+    return;
+  }
+
+  // The file's rows replace the demo rows, in the demo table's columns
+  m_tableDemo.Clear();
+  m_bShowBlotter = false;
+  GetMenuBar()->Check(ID_MENU_VIEW_BLOTTER, false);
+  ShowDemoTable();
+  m_pCsvAdapter .reset();
+  m_pCsvProvider.reset();
+  m_pDynAdapter .reset();
+  m_pDynTable   .reset();
+
+  wxTimerEvent timerEvent;
+  OnTimerFollow(timerEvent);
+  m_timerFollow.Start(200);
+}
+
+void MainFrame::OnMenuFileOpenAnyCSV(wxCommandEvent& event)
+{
+  wxFileDialog dialog(this, "Open CSV", "", "",
+    "CSV files (*.csv)|*.csv", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+  if (dialog.ShowModal() != wxID_OK)
+    return;
+
+  // Columns and their types come from the file, the search box looks in
+  // every column through the text index
+  auto table = std::make_unique<DynTableEx<TableExtraInfo>>();
+  if (!LoadCsvDynTableEx(dialog.GetPath().utf8_string(), *table,
+    TableExtraInfo{ wxLIST_FORMAT_LEFT, 100 }, true))
+  {
+    wxMessageBox("Failed to open file", "Error", wxICON_ERROR);
+    return;
+  }
+
+  // Switch the list over before the previous file is released
+  auto adapter = std::make_unique<DynTableExAdapter<TableExtraInfo>>(table.get());
+  m_pListViewMain->SetTable(adapter.get());
+  m_bGroupByName = false;
+  m_bShowBlotter = false;
+  GetMenuBar()->Check(ID_MENU_VIEW_GROUP_BY_NAME, false);
+  GetMenuBar()->Check(ID_MENU_VIEW_BLOTTER, false);
+  m_pDynAdapter = std::move(adapter);
+  m_pDynTable   = std::move(table);
+  m_pCsvAdapter .reset();
+  m_pCsvProvider.reset();
+}
+
+void MainFrame::OnMenuFileRecordTrace(wxCommandEvent& event)
+{
+  // The list is shown the demo table directly again before the recording
+  // adapter goes away
+  bool showingDemo = !m_bGroupByName && !m_bShowBlotter && !m_pCsvAdapter && !m_pDynAdapter;
+  if (!event.IsChecked())
+  {
+    if (showingDemo)
+    {
+      m_pListViewMain->SetTable(&m_adapterDemo);
+    }
+    m_pRecordingAdapter.reset();
+    m_recorderDemo.Stop();
+    return;
+  }
+
+  wxFileDialog dialog(this, "Record Trace", "", "",
+    "Trace files (*.trace)|*.trace", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (dialog.ShowModal() != wxID_OK)
+  {
+    GetMenuBar()->Check(ID_MENU_FILE_RECORD_TRACE, false);
+    return;
+  }
+  if (!m_recorderDemo.Start(dialog.GetPath().utf8_string()))
+  {
+    GetMenuBar()->Check(ID_MENU_FILE_RECORD_TRACE, false);
+    wxMessageBox("Failed to create file", "Error", wxICON_ERROR);
+    return;
+  }
+
+  m_pRecordingAdapter = std::make_unique<RecordingTableExAdapter>(
+    &m_adapterDemo, m_recorderDemo.GetWriter());
+  if (showingDemo)
+  {
+    ShowDemoTable();
+  }
+}
+
+void MainFrame::OnMenuFileExportSnapshot(wxCommandEvent& event)
+{
+  wxFileDialog dialog(this, "Export Snapshot", "", "",
+    "CSV files (*.csv)|*.csv", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (dialog.ShowModal() != wxID_OK)
+    return;
+
+  // One export at a time
+  if (m_threadExport.joinable())
+  {
+    m_threadExport.join();
+  }
+
+  // Every demo row as of now, whatever the list sorts or filters. Commits
+  // are published as they happen, only writes outside a transaction are
+  // left; the export reads the version it pins without holding up the GUI
+  // thread.
+  m_versionsDemo.PublishPending();
+  std::string path = dialog.GetPath().utf8_string();
+  m_threadExport = std::thread([this, path]()
+  {
+    size_t rows = 0;
+    bool   done = WriteSnapshotCsv(m_versionsDemo.Pin(), path, rows);
+    CallAfter([done, rows]()
+    {
+      if (done)
+      {
+        wxMessageBox(wxString::Format("%zu rows exported", rows), "Export Snapshot");
+      }
+      else
+      {
+        wxMessageBox("Failed to create file", "Error", wxICON_ERROR);
+      }
+    });
+  });
+}
+
+void MainFrame::OnMenuViewAutoScroll(wxCommandEvent& event)
+{
+  m_bAutoScroll = event.IsChecked();
+}
+
+void MainFrame::OnMenuViewAutoSizeColumns(wxCommandEvent& event)
+{
+  m_bAutoSizeColumns = event.IsChecked();
+  m_pListViewMain->SetAutoSizeColumns(m_bAutoSizeColumns);
+}
+
+void MainFrame::OnMenuViewGroupByName(wxCommandEvent& event)
+{
+  m_bGroupByName = event.IsChecked();
+  if (m_bGroupByName)
+  {
+    m_bShowBlotter = false;
+    GetMenuBar()->Check(ID_MENU_VIEW_BLOTTER, false);
+  }
+  if (m_bGroupByName && !m_bGroupBuilt)
+  {
+    // Grouped once here, the groups follow the demo table from now on
+    m_groupDemo.Build();
+    m_bGroupBuilt = true;
+  }
+  ShowDemoTable();
+}
+
+void MainFrame::OnMenuViewBlotter(wxCommandEvent& event)
+{
+  m_bShowBlotter = event.IsChecked();
+  if (m_bShowBlotter)
+  {
+    m_bGroupByName = false;
+    GetMenuBar()->Check(ID_MENU_VIEW_GROUP_BY_NAME, false);
+  }
+  ShowDemoTable();
+}
+
+void MainFrame::OnMenuViewReprice(wxCommandEvent& event)
+{
+  // Move every price by up to 2% either way; no trade row is written
+  ++m_nReprices;
+  m_tableInstruments.ForEachRowWithId([&](size_t id, const TableEx<TableExtraInfo, 3>::RowData& row)
+  {
+    int    step  = static_cast<int>((id * 7 + m_nReprices * 3) % 5) - 2;
+    double price = row[2].value.d * (1.0 + step / 100.0);
+    m_tableInstruments.UpsertRow(id, { row[0].str, row[1].str, price });
+  });
+
+  // Only the visible trades of the changed instruments are redrawn
+  if (m_bShowBlotter)
+  {
+    m_adapterBlotter.RefreshLookups(m_pListViewMain);
+  }
+  else
+  {
+    bool reset = false;
+    m_tableBlotter.SyncLookups(reset);
+  }
+}
+
+void MainFrame::OnTimerFollow(wxTimerEvent& event)
+{
+  // Take in what was appended, for at most 50ms so the GUI stays responsive
+  // while a large backlog is loaded; the rest waits for the next tick
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+  bool       reset    = false;
+  bool       more     = false;
+  do
+  {
+    std::vector<size_t> ids = m_followerDemo.Poll(reset, more, 1024 * 1024);
+    if (m_bGroupByName)
+    {
+      // Only the groups of the new rows changed, the list is diffed
+      ShowDemoTable();
+    }
+    else if (!m_bShowBlotter)
+    {
+      if (reset)
+      {
+        m_pListViewMain->SetTable(GetDemoAdapter());
+      }
+      m_pListViewMain->AppendRows(ids, m_bAutoScroll);
+    }
+  }
+  while (more && std::chrono::steady_clock::now() < deadline);
+}
+
+void MainFrame::ShowDemoTable()
+{
+  if (m_bShowBlotter)
+  {
+    m_pListViewMain->SetTable(&m_adapterBlotter);
+    return;
+  }
+  if (!m_bGroupByName)
+  {
+    m_pListViewMain->SetTable(GetDemoAdapter());
+    return;
+  }
+
+  bool reset = false;
+  m_groupDemo.Update(reset);
+  m_pListViewMain->SetTable(&m_adapterGroup);
 }
 
+ITableExAdapter* MainFrame::GetDemoAdapter()
+{
+  if (m_pRecordingAdapter)
+    return m_pRecordingAdapter.get();
+
+  return &m_adapterDemo;
+}
 
 void MainFrame::OnMenuFileExit(wxCommandEvent& event)
 {
@@ -56,6 +480,18 @@ void MainFrame::OnMenuFileExit(wxCommandEvent& event)
   wxApp::GetInstance()->Exit();
 }
 
+void MainFrame::OnSearchText(wxCommandEvent& event)
+{
+  // Each keystroke is answered from the text index, no need to wait
+  m_pListViewMain->SetQuickSearch(m_pSearchMain->GetValue());
+}
+
+void MainFrame::OnSearchCancel(wxCommandEvent& event)
+{
+  m_pSearchMain->Clear();
+  m_pListViewMain->SetQuickSearch(wxEmptyString);
+}
+
 void MainFrame::WriteDemoData()
 {
   using ColumnType = ColumnInfo<TableExtraInfo>::ColumnType;
@@ -71,6 +507,15 @@ void MainFrame::WriteDemoData()
   m_tableDemo.SetColumnInfo(4, { ColumnType::UINT32, "%d", nullptr, { wxLIST_FORMAT_CENTRE, 80 }, "Score 2" });
   m_tableDemo.SetColumnInfo(5, { ColumnType::UINT32, "%d", nullptr, { wxLIST_FORMAT_CENTRE, 80 }, "Score 3" });
 
+  // Range filters on these columns are answered by index / block skipping
+  m_tableDemo.CreateIndex(1);
+  m_tableDemo.EnableZoneMaps();
+  // The search box looks in every column through the text index
+  for (size_t col = 0; col < 6; ++col)
+  {
+    m_tableDemo.EnableTextIndex(col);
+  }
+
   m_tableDemo.UpsertRow(0, { 0, 900, "Ethan"   , 90,  80, 130 });
   m_tableDemo.UpsertRow(1, { 1, 910, "Olivia"  , 80,  90,  99 });
   m_tableDemo.UpsertRow(2, { 2, 920, "Lucas"   , 70, 100,  95 });
@@ -78,5 +523,39 @@ void MainFrame::WriteDemoData()
   m_tableDemo.UpsertRow(4, { 4, 940, "Mason"   , 50,  56,  95 });
   m_tableDemo.UpsertRow(5, { 5, 950, "Isabella", 45,  77, 131 });
 
+  // Snapshot exports read the versions published on every commit
+  m_versionsDemo.Follow(m_tableDemo);
+
   pListView->SetTable(&m_adapterDemo);
 }
+
+void MainFrame::WriteBlotterData()
+{
+  using ColumnType = ColumnInfo<TableExtraInfo>::ColumnType;
+
+  m_tableInstruments.SetColumnInfo(0, { ColumnType::STRING, "%s"  , nullptr, { wxLIST_FORMAT_LEFT  ,  70 }, "Symbol"     });
+  m_tableInstruments.SetColumnInfo(1, { ColumnType::STRING, "%s"  , nullptr, { wxLIST_FORMAT_LEFT  , 140 }, "Instrument" });
+  m_tableInstruments.SetColumnInfo(2, { ColumnType::DOUBLE, "%.2f", nullptr, { wxLIST_FORMAT_RIGHT ,  80 }, "Price"      });
+
+  m_tableInstruments.UpsertRow(0, { "AAPL", "Apple Inc."      , 189.50 });
+  m_tableInstruments.UpsertRow(1, { "MSFT", "Microsoft Corp." , 411.20 });
+  m_tableInstruments.UpsertRow(2, { "NVDA", "NVIDIA Corp."    , 120.80 });
+  m_tableInstruments.UpsertRow(3, { "AMZN", "Amazon.com Inc." , 182.30 });
+
+  // Instrument and Price hold nothing, they are resolved through the
+  // symbol when shown, filtered or sorted
+  m_tableBlotter.SetColumnInfo(0, { ColumnType::UINT32, "%d"  , nullptr, { wxLIST_FORMAT_CENTRE,  50 }, "Trade"      });
+  m_tableBlotter.SetColumnInfo(1, { ColumnType::STRING, "%s"  , nullptr, { wxLIST_FORMAT_LEFT  ,  70 }, "Symbol"     });
+  m_tableBlotter.SetColumnInfo(2, { ColumnType::INT32 , "%d"  , nullptr, { wxLIST_FORMAT_RIGHT ,  70 }, "Quantity"   });
+  m_tableBlotter.SetColumnInfo(3, { ColumnType::STRING, "%s"  , nullptr, { wxLIST_FORMAT_LEFT  , 140 }, "Instrument" });
+  m_tableBlotter.SetColumnInfo(4, { ColumnType::DOUBLE, "%.2f", nullptr, { wxLIST_FORMAT_RIGHT ,  80 }, "Price"      });
+  m_tableBlotter.SetLookupColumn(3, &m_lookupInstruments, 1, 1);
+  m_tableBlotter.SetLookupColumn(4, &m_lookupInstruments, 1, 2);
+
+  const char* symbols[] = { "AAPL", "MSFT", "NVDA", "AMZN", "TSLA" };
+  for (uint32_t trade = 0; trade < 20; ++trade)
+  {
+    int quantity = static_cast<int>((trade * 37) % 11 + 1) * ((trade % 3 == 0) ? -100 : 100);
+    m_tableBlotter.UpsertRow(trade, { trade, symbols[trade % 5], quantity, {}, {} });
+  }
+}
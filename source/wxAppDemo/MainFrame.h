@@ -15,16 +15,68 @@ class MainFrame : public wxFrame
 {
 public:
   MainFrame(const wxString& title);
+  ~MainFrame();
 private:
   void InitializeMenuBar();
   void InitializeMessageBinding();
   void WriteDemoData();
+  void WriteBlotterData();
+  // Show the demo table, or its groups if grouped by name
+  void ShowDemoTable();
+  // Adapter of the demo table, recording list operations while recording
+  ITableExAdapter* GetDemoAdapter();
 public:
+  void OnMenuFileOpenCSV                           (wxCommandEvent& event);
+  void OnMenuFileFollowCSV                         (wxCommandEvent& event);
+  void OnMenuFileOpenAnyCSV                        (wxCommandEvent& event);
+  void OnMenuFileRecordTrace                       (wxCommandEvent& event);
+  void OnMenuFileExportSnapshot                    (wxCommandEvent& event);
+  void OnMenuViewAutoScroll                        (wxCommandEvent& event);
+  void OnMenuViewAutoSizeColumns                   (wxCommandEvent& event);
+  void OnMenuViewGroupByName                       (wxCommandEvent& event);
+  void OnMenuViewBlotter                           (wxCommandEvent& event);
+  void OnMenuViewReprice                           (wxCommandEvent& event);
+  void OnTimerFollow                               (wxTimerEvent&   event);
   void OnMenuFileExit                              (wxCommandEvent& event);
+  void OnSearchText                                (wxCommandEvent& event);
+  void OnSearchCancel                              (wxCommandEvent& event);
 private:
+  wxSearchCtrl                                   *m_pSearchMain;
   ListViewEx                                     *m_pListViewMain;
   TableEx       <TableExtraInfo, 6>               m_tableDemo;
   TableExAdapter<TableExtraInfo, 6>               m_adapterDemo;
+  // Demo rows grouped by name, kept up to date as they change
+  TableExGroupBy<TableExtraInfo, 6, 5>            m_groupDemo;
+  TableExAdapter<TableExtraInfo, 5>               m_adapterGroup;
+  // Trades whose instrument name and price are looked up by symbol from
+  // the instruments, not copied into each trade
+  TableEx       <TableExtraInfo, 3>               m_tableInstruments;
+  TableExLookup <TableExtraInfo, 3>               m_lookupInstruments;
+  TableEx       <TableExtraInfo, 5>               m_tableBlotter;
+  TableExAdapter<TableExtraInfo, 5>               m_adapterBlotter;
+  // CSV file browsed page by page, with the demo table's columns
+  std::unique_ptr<CsvTableExDataProvider<TableExtraInfo, 6>> m_pCsvProvider;
+  std::unique_ptr<PagedTableExAdapter   <TableExtraInfo, 6>> m_pCsvAdapter;
+  // CSV file loaded whole with the columns of its header
+  std::unique_ptr<DynTableEx            <TableExtraInfo>>    m_pDynTable;
+  std::unique_ptr<DynTableExAdapter     <TableExtraInfo>>    m_pDynAdapter;
+  // CSV file followed into the demo table as it grows
+  TableExFollower<TableExtraInfo, 6>              m_followerDemo;
+  wxTimer                                         m_timerFollow;
+  // Trace of the demo table, and of the list over it, for TableExReplay
+  TableExRecorder<TableExtraInfo, 6>              m_recorderDemo;
+  std::unique_ptr<RecordingTableExAdapter>        m_pRecordingAdapter;
+  // Published versions of the demo table, written to CSV by an export
+  // thread while the GUI thread keeps updating the table
+  TableExVersions<TableExtraInfo, 6>              m_versionsDemo;
+  std::thread                                     m_threadExport;
+  bool                                            m_bAutoScroll;
+  bool                                            m_bAutoSizeColumns;
+  bool                                            m_bGroupByName;
+  bool                                            m_bGroupBuilt;
+  bool                                            m_bShowBlotter;
+  // Repricings so far, drives the demo price moves
+  size_t                                          m_nReprices;
 };
 
 #endif // GUI_WXWIDGETS_MAIN_FRAME_H_